@@ -0,0 +1,134 @@
+/*
+ * ClockSync.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include "ClockSync.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace dyno
+{
+
+#define MICROS_WRAP 4294967296.0 // micros() wraps at 2^32 us
+#define KEEP_FRACTION 0.5        // share of exchanges, fastest first, used in the fit
+
+// Round trip time spent outside the device
+static double roundTripUs(const SyncSample &s)
+{
+    return (double)(s.host_recv_us - s.host_send_us) - (double)(s.device_tx_us - s.device_rx_us);
+}
+
+ClockSync::ClockSync() : ref_host_us_(0), offset_us_(0), drift_(0), bound_us_(0)
+{
+}
+
+void ClockSync::addExchange(uint64_t host_send_us, uint32_t device_rx_us, uint32_t device_tx_us,
+                            uint32_t device_tx_ms, uint64_t host_recv_us)
+{
+    // millis() does not wrap for 49 days, so it picks the micros() wrap count
+    double approx_us = (double)device_tx_ms * 1000.0;
+    double wraps = std::floor((approx_us - device_tx_us) / MICROS_WRAP + 0.5);
+    uint64_t tx_us = (uint64_t)device_tx_us + (uint64_t)std::max(wraps, 0.0) * (uint64_t)MICROS_WRAP;
+
+    SyncSample s;
+    s.host_send_us = host_send_us;
+    s.device_tx_us = tx_us;
+    s.device_rx_us = tx_us - (uint32_t)(device_tx_us - device_rx_us);
+    s.host_recv_us = host_recv_us;
+    samples_.push_back(s);
+}
+
+bool ClockSync::addReply(const std::string &line, long seq, uint64_t host_send_us, uint64_t host_recv_us)
+{
+    if (line.empty() || line[0] != '~')
+        return false;
+
+    // A late reply to an earlier request would pair its device times with our host times
+    char *p;
+    if (std::strtol(line.c_str() + 1, &p, 10) != seq || *p != ',')
+        return false;
+    unsigned long rx_us = std::strtoul(p + 1, &p, 10);
+    if (*p != ',')
+        return false;
+    unsigned long tx_us = std::strtoul(p + 1, &p, 10);
+    if (*p != ',')
+        return false;
+    unsigned long tx_ms = std::strtoul(p + 1, &p, 10);
+
+    addExchange(host_send_us, rx_us, tx_us, tx_ms, host_recv_us);
+    return true;
+}
+
+bool ClockSync::estimate()
+{
+    if (samples_.size() < 2)
+        return false;
+
+    // Fastest exchanges have the least room for asymmetric delay
+    std::vector<const SyncSample *> kept;
+    for (const SyncSample &s : samples_)
+        kept.push_back(&s);
+    std::sort(kept.begin(), kept.end(), [](const SyncSample *a, const SyncSample *b)
+              { return roundTripUs(*a) < roundTripUs(*b); });
+    kept.resize(std::max<size_t>(2, (size_t)(kept.size() * KEEP_FRACTION)));
+
+    ref_host_us_ = samples_.front().host_send_us;
+
+    // Least squares line of offset against host time
+    std::vector<double> x, y;
+    for (const SyncSample *s : kept)
+    {
+        double host_mid = (double)(s->host_send_us - ref_host_us_) + (double)(s->host_recv_us - s->host_send_us) / 2;
+        double device_mid = (double)s->device_rx_us + (double)(s->device_tx_us - s->device_rx_us) / 2;
+        x.push_back(host_mid);
+        y.push_back(device_mid - (double)ref_host_us_ - host_mid);
+    }
+
+    double n = x.size();
+    double mean_x = 0, mean_y = 0;
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        mean_x += x[i] / n;
+        mean_y += y[i] / n;
+    }
+    double sxx = 0, sxy = 0;
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        sxx += (x[i] - mean_x) * (x[i] - mean_x);
+        sxy += (x[i] - mean_x) * (y[i] - mean_y);
+    }
+
+    // Exchanges bunched in time cannot resolve drift
+    drift_ = sxx > 0 ? sxy / sxx : 0;
+    offset_us_ = mean_y - drift_ * mean_x;
+
+    // The true offset of an exchange lies within half its round trip of the
+    // measured one, so the bound is the worst residual plus that half
+    bound_us_ = 0;
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        double residual = std::fabs(y[i] - (offset_us_ + drift_ * x[i]));
+        bound_us_ = std::max(bound_us_, residual + roundTripUs(*kept[i]) / 2);
+    }
+    return true;
+}
+
+uint64_t ClockSync::deviceToHost(uint64_t device_us) const
+{
+    // device = host + offset + drift * (host - ref)
+    double device_rel = (double)device_us - (double)ref_host_us_;
+    double host_rel = (device_rel - offset_us_) / (1.0 + drift_);
+    return ref_host_us_ + (int64_t)std::llround(host_rel);
+}
+
+uint64_t ClockSync::deviceMsToHost(uint32_t device_ms) const
+{
+    return deviceToHost((uint64_t)device_ms * 1000 + 500);
+}
+
+} // namespace dyno
@@ -0,0 +1,83 @@
+/*
+ * ClockSync.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Offset and drift estimator between the device clock (micros/millis since
+ *  boot) and the host clock, from NTP style 'y' exchanges:
+ *
+ *      host t0 --- y seq ---> device t1
+ *      host t3 <-- ~seq,t1,t2,ms --- device t2
+ *
+ *  Each exchange bounds the device time at the host midpoint to within half
+ *  its round trip delay. Only the fastest exchanges are kept, and a line is
+ *  fitted through them to get offset and drift.
+ */
+
+#ifndef CLOCK_SYNC_H_
+#define CLOCK_SYNC_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dyno
+{
+
+struct SyncSample
+{
+    uint64_t host_send_us;   // t0, request line end leaving the host
+    uint64_t device_rx_us;   // t1, unwrapped to us since boot
+    uint64_t device_tx_us;   // t2, unwrapped to us since boot
+    uint64_t host_recv_us;   // t3, reply start arriving at the host
+};
+
+class ClockSync
+{
+public:
+    ClockSync();
+
+    // Adds an exchange with the raw 32 bit device fields of a ~ reply
+    void addExchange(uint64_t host_send_us, uint32_t device_rx_us, uint32_t device_tx_us,
+                     uint32_t device_tx_ms, uint64_t host_recv_us);
+
+    // Parses "~seq,rx_us,tx_us,tx_ms" and adds it. Returns false, adding nothing, if the
+    // line is not a reply or answers another request than seq
+    bool addReply(const std::string &line, long seq, uint64_t host_send_us, uint64_t host_recv_us);
+
+    // Fits offset and drift. Needs two exchanges, returns false otherwise
+    bool estimate();
+
+    // Device minus host time at the reference point, in us
+    double offsetUs() const { return offset_us_; }
+
+    // Device clock rate error relative to the host, in parts per million
+    double driftPpm() const { return drift_ * 1e6; }
+
+    // Worst case error of deviceToHost over the fitted span, in us
+    double errorBoundUs() const { return bound_us_; }
+
+    // Host time the fit is referenced to
+    uint64_t referenceUs() const { return ref_host_us_; }
+
+    // Maps device us since boot to host us
+    uint64_t deviceToHost(uint64_t device_us) const;
+
+    // Maps a millis() timestamp, such as a data frame's, to host us. Adds up
+    // to 1 ms of error since millis() truncates
+    uint64_t deviceMsToHost(uint32_t device_ms) const;
+
+    const std::vector<SyncSample> &samples() const { return samples_; }
+
+private:
+    std::vector<SyncSample> samples_;
+    uint64_t ref_host_us_;
+    double offset_us_;
+    double drift_;
+    double bound_us_;
+};
+
+} // namespace dyno
+
+#endif /* CLOCK_SYNC_H_ */
@@ -0,0 +1,616 @@
+/*
+ * DeviceClient.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include "DeviceClient.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace dyno
+{
+
+#define BOOT_WAIT_MS 3000         // longest reset banner wait, as in dyno_sync
+#define DEVICE_RESP_QUEUE_FULL 25 // RespQueueFull
+#define BANNER_PREFIX "Throttle Mapper"
+
+// Replies to 'y' and retargets with 'u' run mid-command instead of queueing
+static bool outOfBand(const std::string &command)
+{
+    char op = std::tolower((unsigned char)command[0]);
+    return op == 'y' || op == 'u';
+}
+
+// A 'q' runs ahead of the device's queue and flushes it
+static bool isQuit(const std::string &command)
+{
+    return std::tolower((unsigned char)command[0]) == 'q';
+}
+
+// Frames come unasked, a '&' script report or a '~' sync reply also belongs
+// to the command that caused it
+static bool isFrame(char c)
+{
+    switch (c)
+    {
+    case '[':
+    case '{':
+    case '$':
+    case '%':
+    case '^':
+    case '#':
+    case '*':
+    case '&':
+    case '~':
+        return true;
+    default:
+        return false;
+    }
+}
+
+DeviceClient::DeviceClient()
+    : epoll_fd_(-1), wake_fd_(-1), want_write_(false), booting_(false), boot_deadline_us_(0),
+      banner_seen_(false), running_(false)
+{
+}
+
+DeviceClient::~DeviceClient()
+{
+    close();
+}
+
+void DeviceClient::open(const std::string &path, unsigned baud)
+{
+    close();
+
+    port_.open(path, baud, true);
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0)
+    {
+        int err = errno;
+        close();
+        throw std::system_error(err, std::generic_category(), "epoll");
+    }
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = port_.fd();
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, port_.fd(), &ev);
+    ev.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+    want_write_ = false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    in_.clear();
+    out_.clear();
+    booting_ = true;
+    banner_seen_ = false;
+    boot_deadline_us_ = hostTimeUs() + (uint64_t)BOOT_WAIT_MS * 1000;
+    queueTerse();
+}
+
+void DeviceClient::close()
+{
+    stop();
+
+    Events events;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        failAll(ReplyStatus::Closed, events);
+        while (!waiting_.empty())
+        {
+            finish(std::move(waiting_.front()), ReplyStatus::Closed, events);
+            waiting_.pop_front();
+        }
+        out_.clear();
+    }
+    resolve(events);
+
+    port_.close();
+    if (epoll_fd_ >= 0)
+        ::close(epoll_fd_);
+    if (wake_fd_ >= 0)
+        ::close(wake_fd_);
+    epoll_fd_ = -1;
+    wake_fd_ = -1;
+}
+
+void DeviceClient::start()
+{
+    if (running_)
+        return;
+    running_ = true;
+    thread_ = std::thread([this] {
+        while (running_ && poll(-1))
+            ;
+    });
+}
+
+void DeviceClient::stop()
+{
+    if (!running_)
+        return;
+    running_ = false;
+    wake();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+bool DeviceClient::poll(int timeout_ms)
+{
+    if (port_.fd() < 0)
+        return false;
+
+    // Give up on the banner in time, the device may not have reset at all
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (booting_)
+        {
+            uint64_t now = hostTimeUs();
+            if (now >= boot_deadline_us_)
+                booting_ = false;
+            else
+            {
+                int boot_ms = (int)((boot_deadline_us_ - now + 999) / 1000);
+                if (timeout_ms < 0 || boot_ms < timeout_ms)
+                    timeout_ms = boot_ms;
+            }
+        }
+    }
+
+    epoll_event ready[2];
+    int n = epoll_wait(epoll_fd_, ready, 2, timeout_ms);
+    if (n < 0 && errno != EINTR)
+        throw std::system_error(errno, std::generic_category(), "epoll_wait");
+
+    Events events;
+    for (int i = 0; i < n; i++)
+    {
+        if (ready[i].data.fd == wake_fd_)
+        {
+            uint64_t count;
+            if (::read(wake_fd_, &count, sizeof(count)) < 0 && errno != EAGAIN)
+                throw std::system_error(errno, std::generic_category(), "eventfd");
+        }
+        else
+        {
+            if (ready[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                readReady(events);
+            if (ready[i].events & EPOLLOUT)
+                writeReady();
+        }
+    }
+
+    writeReady();
+    resolve(events);
+    return port_.fd() >= 0;
+}
+
+std::future<Reply> DeviceClient::send(const std::string &command)
+{
+    Pending pending;
+    pending.reply.command = command;
+    pending.promise = std::make_shared<std::promise<Reply>>();
+    std::future<Reply> future = pending.promise->get_future();
+    Events events;
+    queue(std::move(pending), events);
+    resolve(events);
+    return future;
+}
+
+void DeviceClient::send(const std::string &command, ReplyHandler handler)
+{
+    Pending pending;
+    pending.reply.command = command;
+    pending.handler = std::move(handler);
+    Events events;
+    queue(std::move(pending), events);
+    resolve(events);
+}
+
+void DeviceClient::onFrame(FrameHandler handler)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_handler_ = std::move(handler);
+}
+
+void DeviceClient::emergencyStop()
+{
+    // Written straight to the port, bytes queued before it may still be in
+    // the adapter but the device acts on the stop byte as it arrives
+    const char stop = DEVICE_STOP_BYTE;
+    Events events;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (port_.fd() >= 0)
+            port_.writeAll(&stop, 1);
+
+        // Nothing queued after a stop goes out
+        while (!waiting_.empty())
+        {
+            finish(std::move(waiting_.front()), ReplyStatus::Stopped, events);
+            waiting_.pop_front();
+        }
+    }
+    resolve(events);
+}
+
+size_t DeviceClient::inFlight() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = waiting_.size() + unstarted_.size() + started_.size();
+    for (const Pending &pending : waiting_)
+        count -= pending.internal;
+    for (const Pending &pending : unstarted_)
+        count -= pending.internal;
+    for (const Pending &pending : started_)
+        count -= pending.internal;
+    return count;
+}
+
+void DeviceClient::queue(Pending &&pending, Events &events)
+{
+    // The device drops lines that overrun its buffer without a word, and
+    // takes a CR as a line end of its own
+    const std::string &command = pending.reply.command;
+    bool bad = command.empty() || command.size() > DEVICE_CMD_LEN_MAX ||
+               command.find_first_of("\r\n\x1B") != std::string::npos;
+    if (bad)
+    {
+        pending.reply.error_code = 2; // RespBadArgument
+        finish(std::move(pending), ReplyStatus::Error, events);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Nothing waiting would outlive the flush, the client's own lines still go
+        if (isQuit(command))
+        {
+            std::deque<Pending> internal;
+            for (Pending &waiting : waiting_)
+            {
+                if (waiting.internal)
+                    internal.push_back(std::move(waiting));
+                else
+                    finish(std::move(waiting), ReplyStatus::Flushed, events);
+            }
+            waiting_.swap(internal);
+        }
+        waiting_.push_back(std::move(pending));
+    }
+    wake();
+}
+
+void DeviceClient::wake()
+{
+    uint64_t one = 1;
+    if (wake_fd_ >= 0 && ::write(wake_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        throw std::system_error(errno, std::generic_category(), "eventfd");
+}
+
+// Moves waiting commands to the port as far as the device can take them
+void DeviceClient::writeReady()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t unread = 0;
+    for (const Pending &pending : unstarted_)
+        if (!pending.echoed)
+            unread += pending.reply.command.size() + 1;
+
+    while (!booting_ && !waiting_.empty())
+    {
+        Pending &next = waiting_.front();
+        size_t len = next.reply.command.size() + 1;
+
+        const std::string &command = next.reply.command;
+        if (outOfBand(command) ? !unstarted_.empty()
+                               : !isQuit(command) && unstarted_.size() >= DEVICE_CMD_QUEUE_LEN)
+            break;
+        if (unread + len > DEVICE_RX_BUFFER_SIZE)
+            break;
+
+        out_ += next.reply.command;
+        out_ += '\n';
+        unread += len;
+        next.reply.sent_us = hostTimeUs();
+        unstarted_.push_back(std::move(next));
+        waiting_.pop_front();
+    }
+
+    flush();
+
+    bool want = !out_.empty();
+    if (want != want_write_)
+    {
+        epoll_event ev = {};
+        ev.events = want ? EPOLLIN | EPOLLOUT : EPOLLIN;
+        ev.data.fd = port_.fd();
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, port_.fd(), &ev);
+        want_write_ = want;
+    }
+}
+
+// Writes what the port takes without blocking
+void DeviceClient::flush()
+{
+    while (!out_.empty())
+    {
+        ssize_t n = ::write(port_.fd(), out_.data(), out_.size());
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+                return;
+            throw std::system_error(errno, std::generic_category(), "write");
+        }
+        out_.erase(0, n);
+    }
+}
+
+void DeviceClient::readReady(Events &events)
+{
+    char buffer[512];
+    while (true)
+    {
+        ssize_t n = ::read(port_.fd(), buffer, sizeof(buffer));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+                break;
+            throw std::system_error(errno, std::generic_category(), "read");
+        }
+        if (n == 0)
+            break;
+        in_.append(buffer, n);
+    }
+
+    size_t begin = 0, end;
+    while ((end = in_.find('\n', begin)) != std::string::npos)
+    {
+        std::string line = in_.substr(begin, end - begin);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        begin = end + 1;
+        handleLine(line, events);
+    }
+    in_.erase(0, begin);
+}
+
+void DeviceClient::handleLine(const std::string &line, Events &events)
+{
+    if (line.empty())
+        return;
+
+    uint64_t now = hostTimeUs();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // The device rebooted, nothing sent before finishes
+    if (line.compare(0, sizeof(BANNER_PREFIX) - 1, BANNER_PREFIX) == 0)
+    {
+        failAll(ReplyStatus::Reset, events);
+        booting_ = true;
+        banner_seen_ = true;
+        boot_deadline_us_ = now + (uint64_t)BOOT_WAIT_MS * 1000;
+        queueTerse();
+        return;
+    }
+
+    char type = line[0];
+    switch (type)
+    {
+    case '<':
+        if (unstarted_.empty())
+        {
+            // Started by the device itself, a boot script
+            Pending pending;
+            pending.internal = true;
+            started_.push_back(std::move(pending));
+        }
+        else
+        {
+            started_.push_back(std::move(unstarted_.front()));
+            unstarted_.pop_front();
+        }
+        started_.back().reply.start_us = now;
+        return;
+
+    case '>':
+    {
+        if (started_.empty())
+        {
+            // End of the banner, or of a command sent before the client opened
+            if (booting_ && banner_seen_)
+                booting_ = false;
+            return;
+        }
+
+        Pending pending = std::move(started_.back());
+        started_.pop_back();
+        pending.reply.late_ms = std::strtol(line.c_str() + 1, nullptr, 10);
+        pending.reply.done_us = now;
+        ReplyStatus status = pending.reply.error_code ? ReplyStatus::Error : ReplyStatus::Done;
+        finish(std::move(pending), status, events);
+        return;
+    }
+
+    case '!':
+        if (line.size() > 1)
+        {
+            // Emergency stop, the device reset its application
+            failRead(ReplyStatus::Stopped, events);
+        }
+        else
+        {
+            // A 'q' ran ahead of the queue and flushed it
+            for (auto it = unstarted_.begin(); it != unstarted_.end(); ++it)
+            {
+                if (isQuit(it->reply.command))
+                {
+                    it->reply.start_us = now;
+                    it->reply.done_us = now;
+                    finish(std::move(*it), ReplyStatus::Done, events);
+                    unstarted_.erase(it);
+                    break;
+                }
+            }
+            failRead(ReplyStatus::Flushed, events);
+        }
+        break;
+
+    case '?':
+    {
+        int code = std::atoi(line.c_str() + 1);
+        size_t comma = line.find(',');
+        int arg = comma == std::string::npos ? 0 : std::atoi(line.c_str() + comma + 1);
+
+        // Refused on arrival, so it belongs to the last line the device read
+        if (code == DEVICE_RESP_QUEUE_FULL)
+        {
+            for (auto it = unstarted_.rbegin(); it != unstarted_.rend(); ++it)
+            {
+                if (it->echoed)
+                {
+                    it->reply.error_code = code;
+                    it->reply.done_us = now;
+                    finish(std::move(*it), ReplyStatus::Error, events);
+                    unstarted_.erase(std::next(it).base());
+                    break;
+                }
+            }
+            return;
+        }
+
+        if (!started_.empty())
+        {
+            Reply &reply = started_.back().reply;
+            reply.lines.push_back(line);
+            if (reply.error_code == 0)
+            {
+                reply.error_code = code;
+                reply.error_arg = arg;
+            }
+        }
+        return;
+    }
+
+    default:
+        // Echo of the oldest line the device had not read
+        if (std::isalpha((unsigned char)type))
+        {
+            for (Pending &pending : unstarted_)
+            {
+                if (!pending.echoed)
+                {
+                    pending.echoed = true;
+                    break;
+                }
+            }
+            return;
+        }
+        break;
+    }
+
+    // Frames before any banner mean the device kept running through the open
+    if (isFrame(type) && booting_ && !banner_seen_)
+        booting_ = false;
+
+    if (isFrame(type) || type == '!')
+        events.frames.push_back(Frame{type, line, now});
+
+    bool frame_only = (isFrame(type) && type != '&' && type != '~') || type == '!';
+    if (!frame_only && !started_.empty())
+        started_.back().reply.lines.push_back(line);
+}
+
+void DeviceClient::finish(Pending &&pending, ReplyStatus status, Events &events)
+{
+    pending.reply.status = status;
+    if (pending.reply.done_us == 0)
+        pending.reply.done_us = hostTimeUs();
+    if (!pending.internal)
+        events.finished.push_back(std::move(pending));
+}
+
+// Everything sent is lost, commands not yet sent go out once the device is back
+void DeviceClient::failAll(ReplyStatus status, Events &events)
+{
+    while (!started_.empty())
+    {
+        finish(std::move(started_.back()), status, events);
+        started_.pop_back();
+    }
+    while (!unstarted_.empty())
+    {
+        finish(std::move(unstarted_.front()), status, events);
+        unstarted_.pop_front();
+    }
+}
+
+// The device dropped its queue, lines still in its RX buffer run after all
+void DeviceClient::failRead(ReplyStatus status, Events &events)
+{
+    while (!started_.empty())
+    {
+        finish(std::move(started_.back()), status, events);
+        started_.pop_back();
+    }
+    while (!unstarted_.empty() && unstarted_.front().echoed)
+    {
+        finish(std::move(unstarted_.front()), status, events);
+        unstarted_.pop_front();
+    }
+}
+
+// A reboot puts the device back to text responses, once however often it resets
+void DeviceClient::queueTerse()
+{
+    for (const Pending &waiting : waiting_)
+        if (waiting.internal)
+            return;
+
+    Pending pending;
+    pending.reply.command = "h t";
+    pending.internal = true;
+    waiting_.push_front(std::move(pending));
+}
+
+// Handlers run without the lock held, so they may send again
+void DeviceClient::resolve(Events &events)
+{
+    FrameHandler frame_handler;
+    if (!events.frames.empty())
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frame_handler = frame_handler_;
+    }
+    if (frame_handler)
+        for (const Frame &frame : events.frames)
+            frame_handler(frame.type, frame.line, frame.host_us);
+
+    for (Pending &pending : events.finished)
+    {
+        if (pending.handler)
+            pending.handler(pending.reply);
+        if (pending.promise)
+            pending.promise->set_value(pending.reply);
+    }
+    events.frames.clear();
+    events.finished.clear();
+}
+
+} // namespace dyno
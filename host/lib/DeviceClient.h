@@ -0,0 +1,185 @@
+/*
+ * DeviceClient.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Asynchronous client for the firmware's line protocol. One event loop owns
+ *  the serial port, sends commands ahead while earlier ones run, and hands
+ *  back a future or a callback per command. Frames the device sends on its
+ *  own, data, batches, health and the like, go to a frame handler.
+ *
+ *  The device answers a command with '<' when it starts and '>' when it is
+ *  done, and queues lines that arrive while another command runs. Commands
+ *  therefore start in the order they were sent, and '>' always ends the
+ *  latest command to start, since 'y' and 'u' answered mid-command start and
+ *  finish inside the command in progress. The client only sends those two
+ *  once every earlier command has started, which keeps both rules exact.
+ *
+ *  Sending ahead is bounded by the device: no more lines than its command
+ *  queue holds may wait unstarted, and no more bytes than its RX buffer holds
+ *  may wait unread. A line's echo tells when the device has read it. A 'q'
+ *  is only bounded by the RX buffer, since the device runs it ahead of its
+ *  queue, and the commands still waiting to be written when it is sent
+ *  finish as flushed, as the device would have flushed them.
+ *
+ *  The client switches the device to terse responses, so an error is a
+ *  ?<code>[,<argument>] line that can be told apart from other output.
+ */
+
+#ifndef DEVICE_CLIENT_H_
+#define DEVICE_CLIENT_H_
+
+#include "SerialPort.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dyno
+{
+
+// Device limits, must match Application.h and Uart.h
+#define DEVICE_CMD_QUEUE_LEN 4     // CMD_QUEUE_LEN
+#define DEVICE_CMD_LEN_MAX 19      // CMD_CHAR_LEN, less the line end
+#define DEVICE_RX_BUFFER_SIZE 64   // UART_RX_BUFFER_SIZE
+#define DEVICE_STOP_BYTE 0x1B      // S_STOP_CHAR
+
+enum class ReplyStatus
+{
+    Done,    // the device finished the command
+    Error,   // the device rejected it, see error_code
+    Flushed, // a 'q' reset the device before the command finished
+    Stopped, // an emergency stop reset the device before the command finished
+    Reset,   // the device rebooted before the command finished
+    Closed   // the client closed first
+};
+
+struct Reply
+{
+    std::string command; // as sent, without the line end
+    ReplyStatus status = ReplyStatus::Closed;
+
+    // Output between '<' and '>', other than frames. A 'y' reply is here too
+    std::vector<std::string> lines;
+
+    int error_code = 0; // response code of the first ?<code> line, see Application.h
+    int error_arg = 0;  // index of the argument it concerns, 0 for none
+    long late_ms = 0;   // ramp completion error from a '>late_ms' end
+
+    uint64_t sent_us = 0;  // host time the line was written
+    uint64_t start_us = 0; // host time of its '<'
+    uint64_t done_us = 0;  // host time of its '>', or of the failure
+
+    bool ok() const { return status == ReplyStatus::Done; }
+};
+
+// Frame type char, the whole line and the host time it arrived
+typedef std::function<void(char type, const std::string &line, uint64_t host_us)> FrameHandler;
+typedef std::function<void(const Reply &reply)> ReplyHandler;
+
+class DeviceClient
+{
+public:
+    DeviceClient();
+    ~DeviceClient();
+
+    DeviceClient(const DeviceClient &) = delete;
+    DeviceClient &operator=(const DeviceClient &) = delete;
+
+    // Opens the port, throws std::system_error on failure. Opening resets most
+    // boards, commands sent meanwhile wait for the end of the banner
+    void open(const std::string &path, unsigned baud = DEVICE_BAUDRATE);
+
+    // Fails every command still in flight with ReplyStatus::Closed
+    void close();
+
+    // Runs the event loop on a thread of its own until stop() or close()
+    void start();
+    void stop();
+
+    // Runs the event loop once, for callers without a thread for it. Waits at
+    // most timeout_ms for input, returns false once the port is closed
+    bool poll(int timeout_ms);
+
+    // Queues a command and returns at once. Thread safe. Handlers run on the
+    // event loop and must not block it
+    std::future<Reply> send(const std::string &command);
+    void send(const std::string &command, ReplyHandler handler);
+
+    // Called for every frame line, on the event loop. Set before start()
+    void onFrame(FrameHandler handler);
+
+    // Sends the emergency stop byte ahead of anything queued and fails the
+    // commands not yet written. Thread safe
+    void emergencyStop();
+
+    // Commands sent or queued that have not finished
+    size_t inFlight() const;
+
+private:
+    struct Pending
+    {
+        Reply reply;
+        bool echoed = false;
+        bool internal = false; // sent by the client itself, no one waits for it
+        ReplyHandler handler;
+        std::shared_ptr<std::promise<Reply>> promise;
+    };
+
+    struct Frame
+    {
+        char type;
+        std::string line;
+        uint64_t host_us;
+    };
+
+    // Results of one pass, handed out once the lock is released
+    struct Events
+    {
+        std::vector<Frame> frames;
+        std::vector<Pending> finished;
+    };
+
+    void queue(Pending &&pending, Events &events);
+    void wake();
+    void writeReady();
+    void flush();
+    void readReady(Events &events);
+    void handleLine(const std::string &line, Events &events);
+    void finish(Pending &&pending, ReplyStatus status, Events &events);
+    void failAll(ReplyStatus status, Events &events);
+    void failRead(ReplyStatus status, Events &events);
+    void queueTerse();
+    void resolve(Events &events);
+
+    SerialPort port_;
+    int epoll_fd_;
+    int wake_fd_;
+    bool want_write_;
+
+    mutable std::mutex mutex_;
+    std::deque<Pending> waiting_;   // not written yet
+    std::deque<Pending> unstarted_; // written, no '<' yet, oldest first
+    std::vector<Pending> started_;  // '<' seen, no '>' yet, latest last
+    std::string out_;               // bytes not yet taken by the port
+    bool booting_;                  // writes held until the reset banner ends
+    uint64_t boot_deadline_us_;     // or until this, if the device did not reset
+    bool banner_seen_;
+    FrameHandler frame_handler_;
+
+    std::string in_; // partial line from the port
+    std::thread thread_;
+    std::atomic<bool> running_;
+};
+
+} // namespace dyno
+
+#endif /* DEVICE_CLIENT_H_ */
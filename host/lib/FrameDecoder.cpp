@@ -0,0 +1,205 @@
+/*
+ * FrameDecoder.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include "FrameDecoder.h"
+
+namespace dyno
+{
+
+#define VOLTAGE_DECIMALS 4 // 0.1 mV
+
+// Unsigned decimal up to the next separator
+static bool parseUnsigned(const char *&p, const char *end, uint64_t &value)
+{
+    const char *start = p;
+    value = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    return p > start;
+}
+
+// Volts with 2 or 4 decimals, as 0.1 mV
+static bool parseVoltage(const char *&p, const char *end, uint64_t &value)
+{
+    if (!parseUnsigned(p, end, value))
+        return false;
+
+    int decimals = 0;
+    if (p < end && *p == '.')
+    {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            if (decimals < VOLTAGE_DECIMALS)
+            {
+                value = value * 10 + (*p - '0');
+                decimals++;
+            }
+            p++;
+        }
+    }
+    for (; decimals < VOLTAGE_DECIMALS; decimals++)
+        value *= 10;
+    return true;
+}
+
+static bool expect(const char *&p, const char *end, char c)
+{
+    if (p >= end || *p != c)
+        return false;
+    p++;
+    return true;
+}
+
+FrameDecoder::FrameDecoder(const FrameLayout &layout)
+    : layout_(layout), frames_(0), malformed_(0), ms_high_(0), ms_last_(0), ms_seen_(false)
+{
+    if (layout_.channels > DEVICE_CHANNELS_MAX)
+        layout_.channels = DEVICE_CHANNELS_MAX;
+}
+
+size_t FrameDecoder::decode(const char *line, size_t len, uint64_t host_us, std::vector<Sample> &samples)
+{
+    if (len > 0 && line[len - 1] == '\r')
+        len--;
+    if (len == 0 || (line[0] != '[' && line[0] != '{'))
+        return 0;
+
+    const char *p = line + 1;
+    const char *end = line + len;
+    size_t first = samples.size();
+    bool ok = true;
+
+    if (line[0] == '[')
+    {
+        Sample sample;
+        uint32_t ms = 0;
+        bool timestamp = layout_.mask & DEVICE_DATA_TIMESTAMP;
+        ok = decodeSample(p, end, timestamp, sample, ms) && p == end;
+        if (ok)
+        {
+            sample.time_us = host_us;
+            sample.device_ms = timestamp ? unwrap(ms) : SAMPLE_NONE_MS;
+            samples.push_back(sample);
+        }
+    }
+    else
+    {
+        // Batched samples always carry their offset from the base timestamp
+        uint64_t base;
+        ok = parseUnsigned(p, end, base);
+        uint32_t offsets[DEVICE_BATCH_MAX];
+        size_t count = 0;
+        while (ok && p < end)
+        {
+            Sample sample;
+            ok = expect(p, end, ';') && decodeSample(p, end, true, sample, offsets[count]);
+            if (ok)
+            {
+                samples.push_back(sample);
+                count++;
+                ok = count < DEVICE_BATCH_MAX || p == end;
+            }
+        }
+        ok = ok && count > 0;
+
+        if (ok)
+        {
+            uint32_t last = offsets[count - 1];
+            for (size_t i = 0; i < count; i++)
+            {
+                Sample &sample = samples[first + i];
+                sample.device_ms = unwrap((uint32_t)(base + offsets[i]));
+                sample.time_us = host_us - (uint64_t)(last - offsets[i]) * 1000;
+            }
+        }
+    }
+
+    if (!ok)
+    {
+        samples.resize(first);
+        malformed_++;
+        return 0;
+    }
+    frames_++;
+    return samples.size() - first;
+}
+
+bool FrameDecoder::decodeSample(const char *&p, const char *end, bool timestamp, Sample &sample, uint32_t &ms)
+{
+    bool first = true;
+    uint64_t value;
+
+    // Fields are comma separated, in the order of serialPrintSample
+    auto field = [&](bool (*parse)(const char *&, const char *, uint64_t &)) {
+        if (!first && !expect(p, end, ','))
+            return false;
+        first = false;
+        return parse(p, end, value);
+    };
+
+    for (unsigned ch = 0; ch < DEVICE_CHANNELS_MAX; ch++)
+    {
+        sample.voltage_100uV[ch] = SAMPLE_NONE_VOLTAGE;
+        sample.position[ch] = SAMPLE_NONE_POSITION;
+        sample.ohms[ch] = SAMPLE_NONE_OHMS;
+    }
+
+    for (unsigned ch = 0; ch < layout_.channels; ch++)
+    {
+        if (layout_.mask & DEVICE_DATA_VOLTAGE)
+        {
+            if (!field(parseVoltage) || value >= SAMPLE_NONE_VOLTAGE)
+                return false;
+            sample.voltage_100uV[ch] = (uint16_t)value;
+        }
+        if (layout_.mask & DEVICE_DATA_POSITION)
+        {
+            if (!field(parseUnsigned) || value >= SAMPLE_NONE_POSITION)
+                return false;
+            sample.position[ch] = (uint8_t)value;
+        }
+        if (layout_.mask & DEVICE_DATA_OHMS)
+        {
+            if (!field(parseUnsigned) || value >= SAMPLE_NONE_OHMS)
+                return false;
+            sample.ohms[ch] = (uint32_t)value;
+        }
+    }
+    if (timestamp)
+    {
+        if (!field(parseUnsigned) || value > 0xFFFFFFFFUL)
+            return false;
+        ms = (uint32_t)value;
+    }
+
+    // Free RAM and overruns are health data, checked but not kept
+    if (layout_.mask & DEVICE_DATA_FREE_RAM && !field(parseUnsigned))
+        return false;
+    if (layout_.mask & DEVICE_DATA_OVERRUNS && !field(parseUnsigned))
+        return false;
+    return true;
+}
+
+// millis() wraps every 2^32 ms. Small steps back are reordering, not a wrap
+uint64_t FrameDecoder::unwrap(uint32_t ms)
+{
+    if (ms_seen_ && ms < ms_last_ && ms_last_ - ms > 0x80000000UL)
+        ms_high_ += 0x100000000ULL;
+    else if (ms_seen_ && ms > ms_last_ && ms - ms_last_ > 0x80000000UL && ms_high_ > 0)
+        return ms_high_ - 0x100000000ULL + ms;
+
+    if (!ms_seen_ || (uint32_t)(ms - ms_last_) < 0x80000000UL)
+        ms_last_ = ms;
+    ms_seen_ = true;
+    return ms_high_ + ms;
+}
+
+} // namespace dyno
@@ -0,0 +1,93 @@
+/*
+ * FrameDecoder.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Decoder from the firmware's data frames to samples. A '[' frame carries
+ *  one sample and a '{' batch several:
+ *
+ *      [v,pos,ohms,...,timestamp,free_ram,overruns
+ *      {base;v,pos,ohms,...,offset;v,pos,ohms,...,offset
+ *
+ *  Only the fields in the 'd' command mask are sent, so the decoder has to be
+ *  told the mask and the channel count. Fields a frame does not carry are left
+ *  at their SAMPLE_NONE_* value.
+ *
+ *  Voltages are read as fixed point, straight into the 0.1 mV units the
+ *  device measures in, and nothing is allocated per frame.
+ */
+
+#ifndef FRAME_DECODER_H_
+#define FRAME_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dyno
+{
+
+// Firmware limits and fields, must match HAL.h and Application.h
+#define DEVICE_CHANNELS_MAX 2 // POT_CHANNELS_MAX
+#define DEVICE_DATA_VOLTAGE 0x01
+#define DEVICE_DATA_POSITION 0x02
+#define DEVICE_DATA_OHMS 0x04
+#define DEVICE_DATA_TIMESTAMP 0x08
+#define DEVICE_DATA_FREE_RAM 0x10
+#define DEVICE_DATA_OVERRUNS 0x20
+#define DEVICE_DATA_DEFAULT_MASK 0x0F // DATA_DEFAULT_MASK
+#define DEVICE_BATCH_MAX 8            // DATA_BATCH_MAX
+
+#define SAMPLE_NONE_VOLTAGE 0xFFFF
+#define SAMPLE_NONE_POSITION 0xFF
+#define SAMPLE_NONE_OHMS 0xFFFFFFFFUL
+#define SAMPLE_NONE_MS 0xFFFFFFFFFFFFFFFFULL
+
+struct Sample
+{
+    uint64_t time_us;   // host time base, see FrameDecoder::decode
+    uint64_t device_ms; // millis() timestamp, unwrapped past 49 days
+    uint16_t voltage_100uV[DEVICE_CHANNELS_MAX];
+    uint8_t position[DEVICE_CHANNELS_MAX];
+    uint32_t ohms[DEVICE_CHANNELS_MAX];
+};
+
+struct FrameLayout
+{
+    unsigned channels = 1;                     // POT_CHANNELS the firmware was built with
+    unsigned mask = DEVICE_DATA_DEFAULT_MASK;  // 'd' command field mask
+};
+
+class FrameDecoder
+{
+public:
+    explicit FrameDecoder(const FrameLayout &layout = FrameLayout());
+
+    // Decodes a '[' or '{' line, without its line end, that arrived at
+    // host_us. Appends its samples and returns their count, 0 for other
+    // lines and for malformed frames, which are counted.
+    //
+    // A sample's host time is its arrival, less the time between it and the
+    // last sample of its batch on the device clock
+    size_t decode(const char *line, size_t len, uint64_t host_us, std::vector<Sample> &samples);
+
+    const FrameLayout &layout() const { return layout_; }
+    uint64_t frames() const { return frames_; }
+    uint64_t malformed() const { return malformed_; }
+
+private:
+    bool decodeSample(const char *&p, const char *end, bool timestamp, Sample &sample, uint32_t &ms);
+    uint64_t unwrap(uint32_t ms);
+
+    FrameLayout layout_;
+    uint64_t frames_;
+    uint64_t malformed_;
+    uint64_t ms_high_; // wraps of the device's 32 bit millis()
+    uint32_t ms_last_;
+    bool ms_seen_;
+};
+
+} // namespace dyno
+
+#endif /* FRAME_DECODER_H_ */
@@ -0,0 +1,268 @@
+/*
+ * RecordPipeline.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include "RecordPipeline.h"
+#include "SerialPort.h"
+
+#include <cerrno>
+#include <chrono>
+#include <memory>
+#include <poll.h>
+#include <unistd.h>
+
+namespace dyno
+{
+
+#define READ_POLL_MS 100 // how often the reader checks for stop()
+#define WRITE_BATCH 1024 // samples per pop
+
+static void idle()
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(PIPELINE_IDLE_US));
+}
+
+RecordPipeline::RecordPipeline(int fd, const FrameLayout &layout, RecordingWriter &writer, bool lossless)
+    : fd_(fd), lossless_(lossless), writer_(writer), decoder_(layout), bytes_(PIPELINE_BYTE_RING),
+      marks_(PIPELINE_MARK_RING), samples_(PIPELINE_SAMPLE_RING), stop_(false), reader_done_(false),
+      decoder_done_(false), writer_done_(false)
+{
+}
+
+RecordPipeline::~RecordPipeline()
+{
+    stop();
+    try
+    {
+        join();
+    }
+    catch (...)
+    {
+    }
+}
+
+void RecordPipeline::start()
+{
+    reader_thread_ = std::thread(&RecordPipeline::readLoop, this);
+    decoder_thread_ = std::thread(&RecordPipeline::decodeLoop, this);
+    writer_thread_ = std::thread(&RecordPipeline::writeLoop, this);
+}
+
+void RecordPipeline::stop()
+{
+    stop_.store(true, std::memory_order_release);
+}
+
+void RecordPipeline::join()
+{
+    if (reader_thread_.joinable())
+        reader_thread_.join();
+    if (decoder_thread_.joinable())
+        decoder_thread_.join();
+    if (writer_thread_.joinable())
+        writer_thread_.join();
+
+    if (error_)
+    {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+PipelineStats RecordPipeline::stats() const
+{
+    PipelineStats stats;
+    stats.bytes_read = bytes_read_.get();
+    stats.bytes_dropped = bytes_dropped_.get();
+    stats.reads_dropped = reads_dropped_.get();
+    stats.lines = lines_.get();
+    stats.lines_cut = lines_cut_.get();
+    stats.frames = frames_.get();
+    stats.malformed = malformed_.get();
+    stats.samples_dropped = samples_dropped_.get();
+    stats.rows = rows_.get();
+    stats.syncs = syncs_.get();
+    return stats;
+}
+
+// Waits on nothing but the port. A read that does not fit is dropped whole
+void RecordPipeline::readLoop()
+{
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[PIPELINE_READ_MAX]);
+    uint64_t pushed = 0;
+    bool gap = false;
+
+    while (!stop_.load(std::memory_order_acquire))
+    {
+        pollfd pfd = {fd_, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, READ_POLL_MS);
+        if (ready < 0 && errno != EINTR)
+            break;
+        if (ready <= 0)
+            continue;
+
+        ssize_t n = ::read(fd_, buffer.get(), PIPELINE_READ_MAX);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            continue;
+        if (n <= 0)
+            break; // end of input, or the port went away
+        uint64_t now = hostTimeUs();
+        bytes_read_.add(n);
+
+        // Marks only ever free up, so a mark fits once space() says so
+        while (true)
+        {
+            if (marks_.space() > 0 && bytes_.push(buffer.get(), n))
+            {
+                pushed += n;
+                marks_.push(ReadMark{pushed, now, gap});
+                gap = false;
+                break;
+            }
+            if (!lossless_ || stop_.load(std::memory_order_acquire))
+            {
+                bytes_dropped_.add(n);
+                reads_dropped_.add(1);
+                gap = true;
+                break;
+            }
+            idle();
+        }
+    }
+
+    reader_done_.store(true, std::memory_order_release);
+}
+
+void RecordPipeline::decodeLoop()
+{
+    std::unique_ptr<uint8_t[]> chunk(new uint8_t[PIPELINE_READ_MAX]);
+    char line[PIPELINE_LINE_MAX];
+    size_t len = 0;
+    bool cut = false; // skipping to the next line end
+    uint64_t consumed = 0;
+    std::vector<Sample> samples;
+
+    while (true)
+    {
+        // Done is read first, so an empty ring after it means the end
+        bool done = reader_done_.load(std::memory_order_acquire);
+        ReadMark mark;
+        if (!marks_.pop(mark))
+        {
+            if (done)
+                break;
+            idle();
+            continue;
+        }
+
+        // Whatever follows a dropped read starts mid line
+        if (mark.gap)
+        {
+            if (!cut)
+                lines_cut_.add(1);
+            len = 0;
+            cut = true;
+        }
+
+        size_t n = bytes_.pop(chunk.get(), mark.end - consumed);
+        consumed = mark.end;
+
+        samples.clear();
+        for (size_t i = 0; i < n; i++)
+        {
+            char c = chunk[i];
+            if (c == '\n')
+            {
+                if (!cut)
+                    decoder_.decode(line, len, mark.host_us, samples);
+                lines_.add(1);
+                len = 0;
+                cut = false;
+            }
+            else if (cut)
+                continue;
+            else if (len == PIPELINE_LINE_MAX)
+            {
+                lines_cut_.add(1);
+                cut = true;
+            }
+            else
+                line[len++] = c;
+        }
+        frames_.set(decoder_.frames());
+        malformed_.set(decoder_.malformed());
+
+        // Takes what fits, or waits for room when nothing may be lost
+        size_t offset = 0;
+        while (offset < samples.size())
+        {
+            size_t count = std::min(samples.size() - offset, samples_.space());
+            samples_.push(samples.data() + offset, count);
+            offset += count;
+            if (offset == samples.size())
+                break;
+            if (!lossless_)
+            {
+                samples_dropped_.add(samples.size() - offset);
+                break;
+            }
+            idle();
+        }
+    }
+
+    decoder_done_.store(true, std::memory_order_release);
+}
+
+// The only stage that touches the disk. A write error stops the reader and
+// is thrown from join(), the stages before it drain into nothing
+void RecordPipeline::writeLoop()
+{
+    std::unique_ptr<Sample[]> batch(new Sample[WRITE_BATCH]);
+    uint64_t synced_us = hostTimeUs();
+    bool failed = false;
+
+    while (true)
+    {
+        bool done = decoder_done_.load(std::memory_order_acquire);
+        size_t n = samples_.pop(batch.get(), WRITE_BATCH);
+
+        if (!failed)
+        {
+            try
+            {
+                for (size_t i = 0; i < n; i++)
+                    writer_.append(batch[i]);
+                rows_.add(n);
+
+                uint64_t now = hostTimeUs();
+                if (now - synced_us >= PIPELINE_SYNC_US)
+                {
+                    writer_.sync();
+                    syncs_.add(1);
+                    synced_us = now;
+                }
+            }
+            catch (...)
+            {
+                error_ = std::current_exception();
+                failed = true;
+                stop();
+            }
+        }
+
+        if (n == 0)
+        {
+            if (done)
+                break;
+            idle();
+        }
+    }
+
+    writer_done_.store(true, std::memory_order_release);
+}
+
+} // namespace dyno
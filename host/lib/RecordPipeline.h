@@ -0,0 +1,137 @@
+/*
+ * RecordPipeline.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Recorder split into three threads joined by SPSC rings, so a slow disk
+ *  never holds up the serial port:
+ *
+ *      reader   read() from the port into the byte ring, with a mark of the
+ *               host time of every read in the mark ring
+ *      decoder  bytes to lines to samples, into the sample ring
+ *      writer   samples into the RecordingWriter, synced once a second
+ *
+ *  The reader only ever waits on the port. When a ring is full the stage
+ *  feeding it drops what does not fit and counts it, and the decoder throws
+ *  away the line a dropped read cut through. A lossless pipeline, for input
+ *  that cannot overflow such as a file on stdin, waits for space instead.
+ */
+
+#ifndef RECORD_PIPELINE_H_
+#define RECORD_PIPELINE_H_
+
+#include "FrameDecoder.h"
+#include "Recording.h"
+#include "SpscRing.h"
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace dyno
+{
+
+#define PIPELINE_BYTE_RING 4194304  // bytes, minutes of the fastest device baud rate
+#define PIPELINE_MARK_RING 65536    // reads
+#define PIPELINE_SAMPLE_RING 262144 // samples
+#define PIPELINE_READ_MAX 65536     // bytes per read()
+#define PIPELINE_LINE_MAX 512       // longer lines are not frames
+#define PIPELINE_IDLE_US 200        // wait of a stage with nothing to do
+#define PIPELINE_SYNC_US 1000000    // writer write back period
+
+// Running totals of each stage
+struct PipelineStats
+{
+    // Reader
+    uint64_t bytes_read = 0;
+    uint64_t bytes_dropped = 0; // byte or mark ring full
+    uint64_t reads_dropped = 0;
+
+    // Decoder
+    uint64_t lines = 0;
+    uint64_t lines_cut = 0;  // by a dropped read, or too long
+    uint64_t frames = 0;
+    uint64_t malformed = 0;
+    uint64_t samples_dropped = 0; // sample ring full
+
+    // Writer
+    uint64_t rows = 0;
+    uint64_t syncs = 0;
+};
+
+class RecordPipeline
+{
+public:
+    // Reads fd, which must stay open until join(), and appends to writer
+    RecordPipeline(int fd, const FrameLayout &layout, RecordingWriter &writer, bool lossless = false);
+    ~RecordPipeline();
+
+    RecordPipeline(const RecordPipeline &) = delete;
+    RecordPipeline &operator=(const RecordPipeline &) = delete;
+
+    void start();
+
+    // Stops reading. The rest of the pipeline drains into the writer
+    void stop();
+
+    // Waits for the input to end, or for stop(), and the pipeline to drain.
+    // Throws what the writer threw
+    void join();
+
+    // True once the input ended and everything read has been written
+    bool finished() const { return writer_done_.load(std::memory_order_acquire); }
+
+    // Snapshot of the counters, safe from any thread
+    PipelineStats stats() const;
+
+private:
+    // Bytes in the byte ring up to end arrived with one read at host_us
+    struct ReadMark
+    {
+        uint64_t end;
+        uint64_t host_us;
+        bool gap; // reads before this one were dropped
+    };
+
+    struct Counter
+    {
+        std::atomic<uint64_t> value{0};
+        void add(uint64_t n) { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+        void set(uint64_t n) { value.store(n, std::memory_order_relaxed); }
+        uint64_t get() const { return value.load(std::memory_order_relaxed); }
+    };
+
+    void readLoop();
+    void decodeLoop();
+    void writeLoop();
+
+    int fd_;
+    bool lossless_;
+    RecordingWriter &writer_;
+    FrameDecoder decoder_;
+
+    SpscRing<uint8_t> bytes_;
+    SpscRing<ReadMark> marks_;
+    SpscRing<Sample> samples_;
+
+    std::atomic<bool> stop_;
+    std::atomic<bool> reader_done_;
+    std::atomic<bool> decoder_done_;
+    std::atomic<bool> writer_done_;
+    std::thread reader_thread_;
+    std::thread decoder_thread_;
+    std::thread writer_thread_;
+    std::exception_ptr error_; // from the writer, thrown by join()
+
+    // Each counter is written by its own stage only
+    Counter bytes_read_, bytes_dropped_, reads_dropped_;
+    Counter lines_, lines_cut_, frames_, malformed_, samples_dropped_;
+    Counter rows_, syncs_;
+};
+
+} // namespace dyno
+
+#endif /* RECORD_PIPELINE_H_ */
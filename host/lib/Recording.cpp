@@ -0,0 +1,419 @@
+/*
+ * Recording.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include "Recording.h"
+#include "SerialPort.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace dyno
+{
+
+static const uint32_t column_widths[5] = {8, 8, 2, 1, 4};
+static const char *const column_names[5] = {"time_us", "device_ms", "voltage", "position", "ohms"};
+
+static uint64_t roundUp(uint64_t value, uint64_t unit)
+{
+    return (value + unit - 1) / unit * unit;
+}
+
+static void fail(const char *what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+/** =================================================
+ * Writer
+ */
+
+RecordingWriter::RecordingWriter() : fd_(-1), header_(nullptr), chunk_(nullptr), rows_(0), last_us_(0)
+{
+}
+
+RecordingWriter::~RecordingWriter()
+{
+    if (isOpen())
+        close();
+}
+
+void RecordingWriter::create(const std::string &path, const FrameLayout &layout, uint32_t chunk_rows)
+{
+    if (isOpen())
+        close();
+    if (chunk_rows == 0 || layout.channels == 0 || layout.channels > DEVICE_CHANNELS_MAX)
+        throw std::system_error(EINVAL, std::generic_category(), "recording layout");
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+        fail(("open " + path).c_str());
+    if (ftruncate(fd_, REC_PAGE_SIZE) != 0)
+        fail("ftruncate");
+
+    void *map = mmap(nullptr, REC_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED)
+        fail("mmap");
+    header_ = static_cast<RecFileHeader *>(map);
+
+    std::memcpy(header_->magic, REC_MAGIC, sizeof(header_->magic));
+    header_->version = REC_VERSION;
+    header_->channels = layout.channels;
+    header_->data_mask = layout.mask;
+    header_->chunk_rows = chunk_rows;
+    header_->created_us = hostTimeUs();
+
+    // Columns follow the chunk header, each on a cache line of its own
+    uint64_t offset = sizeof(RecChunkHeader);
+    uint32_t count = 0;
+    for (int id = RecTime; id <= RecOhms; id++)
+    {
+        unsigned copies = id >= RecVoltage ? layout.channels : 1;
+        for (unsigned ch = 0; ch < copies; ch++)
+        {
+            RecColumn &column = header_->columns[count++];
+            if (id >= RecVoltage)
+                std::snprintf(column.name, sizeof(column.name), "%s%u", column_names[id], ch);
+            else
+                std::snprintf(column.name, sizeof(column.name), "%s", column_names[id]);
+            column.width = column_widths[id];
+            column.offset = offset;
+            offset = roundUp(offset + (uint64_t)column.width * chunk_rows, REC_COLUMN_ALIGN);
+        }
+    }
+    header_->column_count = count;
+    header_->chunk_size = roundUp(offset, REC_PAGE_SIZE);
+
+    rows_ = 0;
+    last_us_ = 0;
+    index_.clear();
+}
+
+void RecordingWriter::append(const Sample &sample)
+{
+    RecChunkHeader *chunk = reinterpret_cast<RecChunkHeader *>(chunk_);
+    if (chunk == nullptr || chunk->rows == header_->chunk_rows)
+    {
+        closeChunk();
+        openChunk();
+        chunk = reinterpret_cast<RecChunkHeader *>(chunk_);
+    }
+
+    uint32_t r = chunk->rows;
+    uint64_t time_us = std::max(sample.time_us, last_us_);
+    last_us_ = time_us;
+
+    // Columns are in the order create() laid them out
+    const RecColumn *column = header_->columns;
+    std::memcpy(chunk_ + column->offset + r * 8, &time_us, 8);
+    column++;
+    std::memcpy(chunk_ + column->offset + r * 8, &sample.device_ms, 8);
+    column++;
+    for (unsigned ch = 0; ch < header_->channels; ch++, column++)
+        std::memcpy(chunk_ + column->offset + r * 2, &sample.voltage_100uV[ch], 2);
+    for (unsigned ch = 0; ch < header_->channels; ch++, column++)
+        chunk_[column->offset + r] = sample.position[ch];
+    for (unsigned ch = 0; ch < header_->channels; ch++, column++)
+        std::memcpy(chunk_ + column->offset + r * 4, &sample.ohms[ch], 4);
+
+    if (r == 0)
+        chunk->first_us = time_us;
+    chunk->last_us = time_us;
+    __atomic_store_n(&chunk->rows, r + 1, __ATOMIC_RELEASE);
+    rows_++;
+}
+
+void RecordingWriter::sync()
+{
+    if (chunk_ != nullptr)
+        msync(chunk_, header_->chunk_size, MS_ASYNC);
+    if (header_ != nullptr)
+        msync(header_, REC_PAGE_SIZE, MS_ASYNC);
+}
+
+void RecordingWriter::close()
+{
+    if (!isOpen())
+        return;
+    closeChunk();
+
+    // The index goes after the last chunk, the header points at it last
+    uint64_t offset = REC_PAGE_SIZE + header_->chunk_count * header_->chunk_size;
+    RecIndexHeader index_header = {};
+    std::memcpy(index_header.magic, REC_INDEX_MAGIC, sizeof(index_header.magic));
+    index_header.count = index_.size();
+
+    bool written = pwrite(fd_, &index_header, sizeof(index_header), offset) == (ssize_t)sizeof(index_header);
+    size_t index_size = index_.size() * sizeof(RecIndexEntry);
+    if (written && index_size > 0)
+        written = pwrite(fd_, index_.data(), index_size, offset + sizeof(index_header)) == (ssize_t)index_size;
+    int err = errno;
+    if (written)
+    {
+        fdatasync(fd_);
+        header_->index_offset = offset;
+    }
+    msync(header_, REC_PAGE_SIZE, MS_SYNC);
+
+    munmap(header_, REC_PAGE_SIZE);
+    ::close(fd_);
+    header_ = nullptr;
+    fd_ = -1;
+    if (!written)
+        throw std::system_error(err, std::generic_category(), "write index");
+}
+
+// Chunks are mapped one at a time, the file grows sparse by a chunk
+void RecordingWriter::openChunk()
+{
+    uint64_t offset = REC_PAGE_SIZE + header_->chunk_count * header_->chunk_size;
+    if (ftruncate(fd_, offset + header_->chunk_size) != 0)
+        fail("ftruncate");
+
+    void *map = mmap(nullptr, header_->chunk_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, offset);
+    if (map == MAP_FAILED)
+        fail("mmap");
+    chunk_ = static_cast<uint8_t *>(map);
+
+    RecChunkHeader *chunk = reinterpret_cast<RecChunkHeader *>(chunk_);
+    std::memcpy(chunk->magic, REC_CHUNK_MAGIC, sizeof(chunk->magic));
+    header_->chunk_count++;
+}
+
+void RecordingWriter::closeChunk()
+{
+    if (chunk_ == nullptr)
+        return;
+
+    const RecChunkHeader *chunk = reinterpret_cast<const RecChunkHeader *>(chunk_);
+    RecIndexEntry entry = {chunk->first_us, chunk->last_us, header_->row_count, chunk->rows};
+    index_.push_back(entry);
+    header_->row_count += chunk->rows;
+
+    msync(chunk_, header_->chunk_size, MS_ASYNC);
+    munmap(chunk_, header_->chunk_size);
+    chunk_ = nullptr;
+}
+
+/** =================================================
+ * Reader
+ */
+
+Sample ChunkView::row(uint32_t r) const
+{
+    Sample sample;
+    sample.time_us = time_us[r];
+    sample.device_ms = device_ms[r];
+    for (unsigned ch = 0; ch < DEVICE_CHANNELS_MAX; ch++)
+    {
+        sample.voltage_100uV[ch] = voltage_100uV[ch] ? voltage_100uV[ch][r] : SAMPLE_NONE_VOLTAGE;
+        sample.position[ch] = position[ch] ? position[ch][r] : SAMPLE_NONE_POSITION;
+        sample.ohms[ch] = ohms[ch] ? ohms[ch][r] : SAMPLE_NONE_OHMS;
+    }
+    return sample;
+}
+
+RecordingReader::RecordingReader()
+    : fd_(-1), map_(nullptr), map_size_(0), header_(nullptr), index_(nullptr), chunks_(0), rows_(0)
+{
+}
+
+RecordingReader::~RecordingReader()
+{
+    close();
+}
+
+void RecordingReader::open(const std::string &path)
+{
+    close();
+
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0)
+        fail(("open " + path).c_str());
+    struct stat st;
+    if (fstat(fd_, &st) != 0)
+        fail("fstat");
+    if ((size_t)st.st_size < REC_PAGE_SIZE)
+        throw std::runtime_error(path + ": not a recording");
+
+    // The whole file is mapped, pages are only read as they are touched
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED)
+        fail("mmap");
+    map_ = static_cast<const uint8_t *>(map);
+    map_size_ = st.st_size;
+    header_ = reinterpret_cast<const RecFileHeader *>(map_);
+
+    bool valid = std::memcmp(header_->magic, REC_MAGIC, sizeof(header_->magic)) == 0 &&
+                 header_->version == REC_VERSION && header_->channels >= 1 &&
+                 header_->channels <= DEVICE_CHANNELS_MAX &&
+                 header_->column_count == 2 + 3 * header_->channels && header_->chunk_rows > 0 &&
+                 header_->chunk_size % REC_PAGE_SIZE == 0 && header_->chunk_size > 0;
+
+    // Columns are found by name, and must lie inside their chunk
+    for (int id = RecTime; valid && id <= RecOhms; id++)
+    {
+        unsigned copies = id >= RecVoltage ? header_->channels : 1;
+        for (unsigned ch = 0; ch < DEVICE_CHANNELS_MAX; ch++)
+        {
+            columns_[id][ch] = nullptr;
+            if (ch >= copies)
+                continue;
+
+            char name[REC_COLUMN_NAME_LEN];
+            if (id >= RecVoltage)
+                std::snprintf(name, sizeof(name), "%s%u", column_names[id], ch);
+            else
+                std::snprintf(name, sizeof(name), "%s", column_names[id]);
+
+            for (uint32_t c = 0; c < header_->column_count; c++)
+            {
+                const RecColumn &column = header_->columns[c];
+                if (std::strncmp(column.name, name, sizeof(name)) == 0 && column.width == column_widths[id] &&
+                    column.offset % column.width == 0 &&
+                    column.offset + (uint64_t)column.width * header_->chunk_rows <= header_->chunk_size)
+                    columns_[id][ch] = &column;
+            }
+            valid = valid && columns_[id][ch] != nullptr;
+        }
+    }
+    if (!valid)
+    {
+        close();
+        throw std::runtime_error(path + ": not a recording");
+    }
+
+    if (!mapIndex())
+        rebuildIndex();
+    rows_ = chunks_ > 0 ? index_[chunks_ - 1].first_row + index_[chunks_ - 1].rows : 0;
+}
+
+void RecordingReader::close()
+{
+    if (map_ != nullptr)
+        munmap(const_cast<uint8_t *>(map_), map_size_);
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+    map_ = nullptr;
+    map_size_ = 0;
+    header_ = nullptr;
+    index_ = nullptr;
+    rebuilt_.clear();
+    chunks_ = 0;
+    rows_ = 0;
+}
+
+// Uses the index written by close(), if it is whole
+bool RecordingReader::mapIndex()
+{
+    uint64_t offset = header_->index_offset;
+    if (offset == 0 || offset + sizeof(RecIndexHeader) > map_size_)
+        return false;
+
+    const RecIndexHeader *index_header = reinterpret_cast<const RecIndexHeader *>(map_ + offset);
+    uint64_t end = offset + sizeof(RecIndexHeader) + index_header->count * sizeof(RecIndexEntry);
+    if (std::memcmp(index_header->magic, REC_INDEX_MAGIC, sizeof(index_header->magic)) != 0 ||
+        index_header->count > header_->chunk_count || end > map_size_)
+        return false;
+
+    index_ = reinterpret_cast<const RecIndexEntry *>(index_header + 1);
+    chunks_ = index_header->count;
+    return true;
+}
+
+// A recording that was not closed is indexed from its chunk headers
+void RecordingReader::rebuildIndex()
+{
+    uint64_t available = (map_size_ - REC_PAGE_SIZE) / header_->chunk_size;
+    uint64_t count = std::min<uint64_t>(header_->chunk_count, available);
+    uint64_t first_row = 0;
+
+    rebuilt_.clear();
+    for (uint64_t i = 0; i < count; i++)
+    {
+        const RecChunkHeader *chunk = reinterpret_cast<const RecChunkHeader *>(chunkBase(i));
+        uint32_t rows = __atomic_load_n(&chunk->rows, __ATOMIC_ACQUIRE);
+        if (std::memcmp(chunk->magic, REC_CHUNK_MAGIC, sizeof(chunk->magic)) != 0 || rows == 0)
+            break;
+        rows = std::min(rows, header_->chunk_rows);
+
+        RecIndexEntry entry = {chunk->first_us, chunk->last_us, first_row, rows};
+        rebuilt_.push_back(entry);
+        first_row += rows;
+    }
+    index_ = rebuilt_.data();
+    chunks_ = rebuilt_.size();
+}
+
+const uint8_t *RecordingReader::chunkBase(size_t index) const
+{
+    return map_ + REC_PAGE_SIZE + index * header_->chunk_size;
+}
+
+ChunkView RecordingReader::chunk(size_t index) const
+{
+    ChunkView view;
+    if (index >= chunks_)
+        return view;
+
+    const uint8_t *base = chunkBase(index);
+    const RecIndexEntry &entry = index_[index];
+    view.rows = (uint32_t)entry.rows;
+    view.first_us = entry.first_us;
+    view.last_us = entry.last_us;
+    view.first_row = entry.first_row;
+    view.time_us = reinterpret_cast<const uint64_t *>(base + columns_[RecTime][0]->offset);
+    view.device_ms = reinterpret_cast<const uint64_t *>(base + columns_[RecDeviceMs][0]->offset);
+    for (unsigned ch = 0; ch < header_->channels; ch++)
+    {
+        view.voltage_100uV[ch] = reinterpret_cast<const uint16_t *>(base + columns_[RecVoltage][ch]->offset);
+        view.position[ch] = base + columns_[RecPosition][ch]->offset;
+        view.ohms[ch] = reinterpret_cast<const uint32_t *>(base + columns_[RecOhms][ch]->offset);
+    }
+    return view;
+}
+
+// First chunk that ends at or after time_us
+size_t RecordingReader::chunkAt(uint64_t time_us) const
+{
+    const RecIndexEntry *found = std::partition_point(
+        index_, index_ + chunks_, [time_us](const RecIndexEntry &entry) { return entry.last_us < time_us; });
+    return found - index_;
+}
+
+uint64_t RecordingReader::lowerBound(uint64_t time_us) const
+{
+    size_t index = chunkAt(time_us);
+    if (index >= chunks_)
+        return rows_;
+
+    ChunkView view = chunk(index);
+    return view.first_row + (std::lower_bound(view.time_us, view.time_us + view.rows, time_us) - view.time_us);
+}
+
+void RecordingReader::scan(uint64_t from_us, uint64_t to_us, const RangeVisitor &visit) const
+{
+    for (size_t index = chunkAt(from_us); index < chunks_ && index_[index].first_us < to_us; index++)
+    {
+        ChunkView view = chunk(index);
+        const uint64_t *times_end = view.time_us + view.rows;
+        uint32_t begin = std::lower_bound(view.time_us, times_end, from_us) - view.time_us;
+        uint32_t end = std::lower_bound(view.time_us + begin, times_end, to_us) - view.time_us;
+        if (begin < end && !visit(view, begin, end))
+            return;
+    }
+}
+
+} // namespace dyno
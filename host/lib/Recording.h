@@ -0,0 +1,217 @@
+/*
+ * Recording.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Columnar recording file for data frames, written and read through mmap so
+ *  a session of any length opens at once and is range scanned by time
+ *  without parsing text.
+ *
+ *  The file is a header page followed by chunks of a fixed size, and a time
+ *  index once the recording is closed:
+ *
+ *      RecFileHeader  one page, layout of every chunk
+ *      chunk 0        RecChunkHeader, then one column after the other
+ *      chunk 1        ...
+ *      RecIndexHeader and one RecIndexEntry per chunk
+ *
+ *  Every column holds chunk_rows values of a fixed width, so row r of column
+ *  c lives at chunk start + columns[c].offset + r * columns[c].width. Times
+ *  never go back, so a time is found by a binary search of the index and
+ *  then of the chunk's time column.
+ *
+ *  A chunk's row count is stored after the row itself, so a recording that
+ *  was never closed reads up to its last whole row. Its index is rebuilt from
+ *  the chunk headers.
+ */
+
+#ifndef RECORDING_H_
+#define RECORDING_H_
+
+#include "FrameDecoder.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace dyno
+{
+
+#define REC_MAGIC "DYNOREC1"
+#define REC_CHUNK_MAGIC "CHNK"
+#define REC_INDEX_MAGIC "INDX"
+#define REC_VERSION 1
+#define REC_PAGE_SIZE 4096
+#define REC_CHUNK_ROWS 65536      // default rows per chunk
+#define REC_COLUMN_ALIGN 64       // column start, a cache line
+#define REC_COLUMN_NAME_LEN 16
+#define REC_COLUMNS_MAX (2 + 3 * DEVICE_CHANNELS_MAX)
+
+// Columns in file order, channel columns repeat for each channel
+enum RecColumnId
+{
+    RecTime = 0,     // uint64, host time in us
+    RecDeviceMs = 1, // uint64, unwrapped millis()
+    RecVoltage = 2,  // uint16 per channel, 0.1 mV
+    RecPosition = 3, // uint8 per channel, wiper tap
+    RecOhms = 4      // uint32 per channel
+};
+
+struct RecColumn
+{
+    char name[REC_COLUMN_NAME_LEN]; // "time_us", "voltage0" ...
+    uint32_t width;                 // bytes per value
+    uint32_t reserved;
+    uint64_t offset;                // from the chunk start
+};
+
+struct RecFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t channels;
+    uint32_t data_mask;    // fields the frames carried, DEVICE_DATA_*
+    uint32_t column_count;
+    uint32_t chunk_rows;
+    uint32_t reserved;
+    uint64_t chunk_size;   // bytes, a page multiple
+    uint64_t chunk_count;  // chunks in the file, the last may be partly filled
+    uint64_t row_count;    // rows up to the last closed chunk, all rows once closed
+    uint64_t index_offset; // 0 until the recording is closed
+    uint64_t created_us;   // host time the recording started
+    RecColumn columns[REC_COLUMNS_MAX];
+};
+
+struct RecChunkHeader
+{
+    char magic[4];
+    uint32_t rows;     // written last, rows below it are complete
+    uint64_t first_us; // time of row 0
+    uint64_t last_us;  // time of the last row
+    uint64_t reserved[5];
+};
+
+struct RecIndexEntry
+{
+    uint64_t first_us;
+    uint64_t last_us;
+    uint64_t first_row; // of the whole recording
+    uint64_t rows;
+};
+
+struct RecIndexHeader
+{
+    char magic[4];
+    uint32_t reserved;
+    uint64_t count;
+};
+
+static_assert(sizeof(RecFileHeader) <= REC_PAGE_SIZE, "file header must fit its page");
+static_assert(sizeof(RecChunkHeader) == REC_COLUMN_ALIGN, "chunk header is one column slot");
+
+// Appends samples to a new recording. Not thread safe
+class RecordingWriter
+{
+public:
+    RecordingWriter();
+    ~RecordingWriter();
+
+    RecordingWriter(const RecordingWriter &) = delete;
+    RecordingWriter &operator=(const RecordingWriter &) = delete;
+
+    // Creates or truncates the file, throws std::system_error on failure
+    void create(const std::string &path, const FrameLayout &layout, uint32_t chunk_rows = REC_CHUNK_ROWS);
+
+    // Appends one row. A time before the last row's is raised to it, so
+    // the time column stays sorted
+    void append(const Sample &sample);
+
+    // Starts writing back what was appended, without waiting for the disk
+    void sync();
+
+    // Writes the time index and closes the file
+    void close();
+
+    uint64_t rows() const { return rows_; }
+    bool isOpen() const { return fd_ >= 0; }
+
+private:
+    void openChunk();
+    void closeChunk();
+
+    int fd_;
+    RecFileHeader *header_;
+    uint8_t *chunk_; // mapping of the chunk being filled
+    uint64_t rows_;
+    uint64_t last_us_;
+    std::vector<RecIndexEntry> index_;
+};
+
+// Read only view of the columns of one chunk
+struct ChunkView
+{
+    uint32_t rows = 0;
+    uint64_t first_us = 0;
+    uint64_t last_us = 0;
+    uint64_t first_row = 0; // of the whole recording
+    const uint64_t *time_us = nullptr;
+    const uint64_t *device_ms = nullptr;
+    const uint16_t *voltage_100uV[DEVICE_CHANNELS_MAX] = {};
+    const uint8_t *position[DEVICE_CHANNELS_MAX] = {};
+    const uint32_t *ohms[DEVICE_CHANNELS_MAX] = {};
+
+    Sample row(uint32_t r) const;
+};
+
+class RecordingReader
+{
+public:
+    RecordingReader();
+    ~RecordingReader();
+
+    RecordingReader(const RecordingReader &) = delete;
+    RecordingReader &operator=(const RecordingReader &) = delete;
+
+    // Maps the file, throws std::system_error if it cannot be read and
+    // std::runtime_error if it is not a recording
+    void open(const std::string &path);
+    void close();
+
+    const RecFileHeader &header() const { return *header_; }
+    size_t chunkCount() const { return chunks_; }
+    uint64_t rowCount() const { return rows_; }
+    bool closedCleanly() const { return header_->index_offset != 0; }
+
+    ChunkView chunk(size_t index) const;
+
+    // Row number of the first row at or after time_us, rowCount() if none
+    uint64_t lowerBound(uint64_t time_us) const;
+
+    // Calls visit with runs of rows in [from_us, to_us), chunk by chunk in
+    // time order. Stops early if visit returns false
+    typedef std::function<bool(const ChunkView &chunk, uint32_t begin, uint32_t end)> RangeVisitor;
+    void scan(uint64_t from_us, uint64_t to_us, const RangeVisitor &visit) const;
+
+private:
+    bool mapIndex();
+    void rebuildIndex();
+    const uint8_t *chunkBase(size_t index) const;
+    size_t chunkAt(uint64_t time_us) const;
+
+    int fd_;
+    const uint8_t *map_;
+    size_t map_size_;
+    const RecFileHeader *header_;
+    const RecIndexEntry *index_; // in the file, or rebuilt_
+    std::vector<RecIndexEntry> rebuilt_;
+    size_t chunks_;
+    uint64_t rows_;
+    const RecColumn *columns_[5][DEVICE_CHANNELS_MAX]; // of each RecColumnId and channel
+};
+
+} // namespace dyno
+
+#endif /* RECORDING_H_ */
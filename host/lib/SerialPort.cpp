@@ -0,0 +1,157 @@
+/*
+ * SerialPort.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include "SerialPort.h"
+
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <system_error>
+#include <termios.h>
+#include <unistd.h>
+
+namespace dyno
+{
+
+// Maps a baud rate to its termios constant
+static speed_t baudConstant(unsigned baud)
+{
+    switch (baud)
+    {
+    case 9600:
+        return B9600;
+    case 57600:
+        return B57600;
+    case 115200:
+        return B115200;
+    case 230400:
+        return B230400;
+    case 500000:
+        return B500000;
+    case 1000000:
+        return B1000000;
+    default:
+        throw std::system_error(EINVAL, std::generic_category(), "unsupported baud rate");
+    }
+}
+
+SerialPort::SerialPort() : fd_(-1), baud_(DEVICE_BAUDRATE)
+{
+}
+
+SerialPort::~SerialPort()
+{
+    close();
+}
+
+void SerialPort::open(const std::string &path, unsigned baud, bool non_blocking)
+{
+    close();
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC | (non_blocking ? O_NONBLOCK : 0));
+    if (fd_ < 0)
+        throw std::system_error(errno, std::generic_category(), "open " + path);
+
+    termios tty;
+    if (tcgetattr(fd_, &tty) != 0)
+        throw std::system_error(errno, std::generic_category(), "tcgetattr");
+
+    cfmakeraw(&tty);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+    cfsetispeed(&tty, baudConstant(baud));
+    cfsetospeed(&tty, baudConstant(baud));
+
+    if (tcsetattr(fd_, TCSANOW, &tty) != 0)
+        throw std::system_error(errno, std::generic_category(), "tcsetattr");
+
+    baud_ = baud;
+    pending_.clear();
+}
+
+void SerialPort::close()
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+}
+
+void SerialPort::writeAll(const void *data, size_t len)
+{
+    const char *p = static_cast<const char *>(data);
+    while (len > 0)
+    {
+        ssize_t n = ::write(fd_, p, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+            {
+                pollfd pfd = {fd_, POLLOUT, 0};
+                ::poll(&pfd, 1, -1);
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "write");
+        }
+        p += n;
+        len -= n;
+    }
+}
+
+void SerialPort::writeAll(const std::string &text)
+{
+    writeAll(text.data(), text.size());
+}
+
+bool SerialPort::readLine(std::string &line, int timeout_ms)
+{
+    uint64_t deadline = hostTimeUs() + (uint64_t)timeout_ms * 1000;
+
+    while (true)
+    {
+        size_t end = pending_.find('\n');
+        if (end != std::string::npos)
+        {
+            line = pending_.substr(0, end);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            pending_.erase(0, end + 1);
+            return true;
+        }
+
+        uint64_t now = hostTimeUs();
+        if (now >= deadline)
+            return false;
+
+        pollfd pfd = {fd_, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, (int)((deadline - now + 999) / 1000));
+        if (ready < 0 && errno != EINTR)
+            throw std::system_error(errno, std::generic_category(), "poll");
+        if (ready <= 0)
+            continue;
+
+        char buffer[256];
+        ssize_t n = ::read(fd_, buffer, sizeof(buffer));
+        if (n < 0 && errno != EINTR && errno != EAGAIN)
+            throw std::system_error(errno, std::generic_category(), "read");
+        if (n > 0)
+            pending_.append(buffer, n);
+    }
+}
+
+uint64_t hostTimeUs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+} // namespace dyno
@@ -0,0 +1,59 @@
+/*
+ * SerialPort.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Raw termios serial port for talking to the firmware from Linux.
+ */
+
+#ifndef SERIAL_PORT_H_
+#define SERIAL_PORT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dyno
+{
+
+#define DEVICE_BAUDRATE 115200 // must match BAUDRATE in Application.h
+
+class SerialPort
+{
+public:
+    SerialPort();
+    ~SerialPort();
+
+    SerialPort(const SerialPort &) = delete;
+    SerialPort &operator=(const SerialPort &) = delete;
+
+    // Opens the port in raw 8N1 mode, throws std::system_error on failure
+    void open(const std::string &path, unsigned baud = DEVICE_BAUDRATE, bool non_blocking = false);
+    void close();
+
+    // Writes every byte, throws std::system_error on failure
+    void writeAll(const void *data, size_t len);
+    void writeAll(const std::string &text);
+
+    // Reads one line without its CR LF. Returns false on timeout
+    bool readLine(std::string &line, int timeout_ms);
+
+    // Raw file descriptor, for event loops
+    int fd() const { return fd_; }
+
+    // Time a byte takes on the wire in us
+    double byteTimeUs() const { return 10e6 / baud_; }
+
+private:
+    int fd_;
+    unsigned baud_;
+    std::string pending_;
+};
+
+// Host clock in us, CLOCK_REALTIME so timestamps line up with other loggers
+uint64_t hostTimeUs();
+
+} // namespace dyno
+
+#endif /* SERIAL_PORT_H_ */
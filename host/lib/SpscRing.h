@@ -0,0 +1,135 @@
+/*
+ * SpscRing.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Lock-free ring for one producer thread and one consumer thread. Neither
+ *  side ever waits on the other: a push that does not fit fails and a pop of
+ *  an empty ring takes nothing, so each side decides what to do about it.
+ *
+ *  Head and tail are free running counters on cache lines of their own, and
+ *  each side keeps a copy of the other's counter so it only reads the shared
+ *  one when the copy says the ring is full or empty. Elements are copied with
+ *  memcpy, in bulk, and must be trivially copyable.
+ */
+
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace dyno
+{
+
+#define SPSC_CACHE_LINE 64
+
+template <typename T>
+class SpscRing
+{
+    static_assert(std::is_trivially_copyable<T>::value, "ring elements are copied with memcpy");
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity)
+    {
+        capacity_ = 1;
+        while (capacity_ < capacity)
+            capacity_ <<= 1;
+        mask_ = capacity_ - 1;
+        buffer_.reset(new T[capacity_]);
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    size_t capacity() const { return capacity_; }
+
+    // Producer side. Pushes all count elements or none
+    bool push(const T *items, size_t count)
+    {
+        uint64_t head = producer_.index.load(std::memory_order_relaxed);
+        if (head + count - producer_.cached > capacity_)
+        {
+            producer_.cached = consumer_.index.load(std::memory_order_acquire);
+            if (head + count - producer_.cached > capacity_)
+                return false;
+        }
+
+        copyIn(head, items, count);
+        producer_.index.store(head + count, std::memory_order_release);
+        return true;
+    }
+
+    bool push(const T &item) { return push(&item, 1); }
+
+    // Producer side. Free slots, at least as many as the consumer has left
+    size_t space()
+    {
+        producer_.cached = consumer_.index.load(std::memory_order_acquire);
+        return capacity_ - (producer_.index.load(std::memory_order_relaxed) - producer_.cached);
+    }
+
+    // Consumer side. Pops up to count elements, returns how many
+    size_t pop(T *items, size_t count)
+    {
+        uint64_t tail = consumer_.index.load(std::memory_order_relaxed);
+        if (consumer_.cached - tail < count)
+            consumer_.cached = producer_.index.load(std::memory_order_acquire);
+
+        count = std::min<size_t>(count, consumer_.cached - tail);
+        copyOut(tail, items, count);
+        consumer_.index.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    bool pop(T &item) { return pop(&item, 1) == 1; }
+
+    // Either side. Elements in the ring at some instant during the call
+    size_t size() const
+    {
+        uint64_t tail = consumer_.index.load(std::memory_order_acquire);
+        return producer_.index.load(std::memory_order_acquire) - tail;
+    }
+
+private:
+    // The ring may wrap inside a bulk copy
+    void copyIn(uint64_t at, const T *items, size_t count)
+    {
+        size_t start = at & mask_;
+        size_t first = std::min(count, capacity_ - start);
+        std::memcpy(&buffer_[start], items, first * sizeof(T));
+        std::memcpy(&buffer_[0], items + first, (count - first) * sizeof(T));
+    }
+
+    void copyOut(uint64_t at, T *items, size_t count)
+    {
+        size_t start = at & mask_;
+        size_t first = std::min(count, capacity_ - start);
+        std::memcpy(items, &buffer_[start], first * sizeof(T));
+        std::memcpy(items + first, &buffer_[0], (count - first) * sizeof(T));
+    }
+
+    // Each side's counter and its copy of the other's share a cache line
+    struct alignas(SPSC_CACHE_LINE) Side
+    {
+        std::atomic<uint64_t> index{0};
+        uint64_t cached = 0;
+    };
+
+    Side producer_;
+    Side consumer_;
+    size_t capacity_;
+    size_t mask_;
+    std::unique_ptr<T[]> buffer_;
+};
+
+} // namespace dyno
+
+#endif /* SPSC_RING_H_ */
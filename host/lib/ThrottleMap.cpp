@@ -0,0 +1,521 @@
+/*
+ * ThrottleMap.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include "ThrottleMap.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace dyno
+{
+
+// Bytes of each step in the script bytecode, see Script_append in the firmware
+#define BYTECODE_SET 2
+#define BYTECODE_RAMP 5
+#define BYTECODE_WAIT 4
+#define BYTECODE_LOOP 4
+#define BYTECODE_NEXT 4
+
+static void addDiagnostic(std::vector<Diagnostic> &diagnostics, int line, bool error, const std::string &message)
+{
+    diagnostics.push_back({line, error, message});
+}
+
+static std::string trim(const std::string &text)
+{
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string::npos)
+        return "";
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+static std::string stripComment(const std::string &text)
+{
+    return text.substr(0, text.find('#'));
+}
+
+// Parses a whole field as a number
+static bool parseNumber(const std::string &text, double &value)
+{
+    std::string field = trim(text);
+    if (field.empty())
+        return false;
+    char *end;
+    value = std::strtod(field.c_str(), &end);
+    return *end == '\0' && std::isfinite(value);
+}
+
+// Parses "time, position" into a waypoint
+static bool parsePoint(const std::string &text, int line, ThrottleMap &map, std::vector<Diagnostic> &diagnostics)
+{
+    size_t comma = text.find(',');
+    Waypoint point;
+    if (comma == std::string::npos || !parseNumber(text.substr(0, comma), point.time_ms) ||
+        !parseNumber(text.substr(comma + 1), point.position))
+    {
+        addDiagnostic(diagnostics, line, true, "expected time_ms, position");
+        return false;
+    }
+    point.line = line;
+    map.points.push_back(point);
+    return true;
+}
+
+bool parseCsv(std::istream &in, ThrottleMap &map, std::vector<Diagnostic> &diagnostics)
+{
+    std::string text;
+    bool ok = true;
+    bool first_row = true;
+
+    for (int line = 1; std::getline(in, text); line++)
+    {
+        text = trim(stripComment(text));
+        if (text.empty())
+            continue;
+
+        // A header row is anything whose first field is not a number
+        double ignored;
+        if (first_row && !parseNumber(text.substr(0, text.find(',')), ignored))
+        {
+            first_row = false;
+            continue;
+        }
+        first_row = false;
+        ok &= parsePoint(text, line, map, diagnostics);
+    }
+    return ok;
+}
+
+bool parseYaml(std::istream &in, ThrottleMap &map, std::vector<Diagnostic> &diagnostics)
+{
+    std::string text;
+    bool ok = true;
+    bool in_points = false;
+
+    for (int line = 1; std::getline(in, text); line++)
+    {
+        text = trim(stripComment(text));
+        if (text.empty())
+            continue;
+
+        if (text[0] == '-')
+        {
+            std::string item = trim(text.substr(1));
+            if (!in_points || item.size() < 2 || item.front() != '[' || item.back() != ']')
+            {
+                addDiagnostic(diagnostics, line, true, "expected a point like - [time_ms, position] under points:");
+                ok = false;
+                continue;
+            }
+            ok &= parsePoint(item.substr(1, item.size() - 2), line, map, diagnostics);
+            continue;
+        }
+
+        size_t colon = text.find(':');
+        std::string key = trim(text.substr(0, colon));
+        std::string value = colon == std::string::npos ? "" : trim(text.substr(colon + 1));
+        in_points = false;
+
+        double number;
+        if (colon == std::string::npos)
+        {
+            addDiagnostic(diagnostics, line, true, "expected key: value");
+            ok = false;
+        }
+        else if (key == "name")
+            map.name = value;
+        else if (key == "repeat" && parseNumber(value, number) && number >= 1 && number == std::floor(number))
+            map.repeat = (unsigned)number;
+        else if (key == "points" && value.empty())
+            in_points = true;
+        else
+        {
+            addDiagnostic(diagnostics, line, true, "unknown or invalid key '" + key + "'");
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// Bytes a step takes in the script bytecode
+static size_t bytecodeSize(const MapStep &step)
+{
+    switch (step.op)
+    {
+    case 't':
+        return BYTECODE_RAMP;
+    case 'w':
+        return BYTECODE_WAIT;
+    default:
+        return BYTECODE_SET;
+    }
+}
+
+/**
+ * Smallest period of a sequence by the prefix function, in linear time.
+ * Returns the length of the sequence if it does not repeat.
+ */
+static size_t smallestPeriod(const std::vector<MapStep> &steps, size_t begin)
+{
+    size_t n = steps.size() - begin;
+    std::vector<size_t> prefix(n, 0);
+
+    for (size_t i = 1; i < n; i++)
+    {
+        size_t k = prefix[i - 1];
+        while (k > 0 && !(steps[begin + i] == steps[begin + k]))
+            k = prefix[k - 1];
+        if (steps[begin + i] == steps[begin + k])
+            k++;
+        prefix[i] = k;
+    }
+
+    size_t period = n - (n ? prefix[n - 1] : 0);
+    return (period > 0 && n % period == 0) ? period : n;
+}
+
+/**
+ * Walks the predicted staircase and the requested line together. Between
+ * two breakpoints the prediction is constant and the request is linear, so
+ * the error is linear and its worst value and square integral come from the
+ * ends of the interval.
+ */
+static TrajectoryError predictError(const ThrottleMap &map, const std::vector<MapStep> &steps)
+{
+    struct Event
+    {
+        double time;
+        double value;
+    };
+    std::vector<Event> predicted;
+
+    double now = 0;
+    int position = steps.empty() ? 0 : steps[0].position;
+    for (const MapStep &step : steps)
+    {
+        if (step.op == 'p')
+        {
+            position = step.position;
+            predicted.push_back({now, (double)position});
+        }
+        else if (step.op == 'w')
+            now += step.time_ms;
+        else
+        {
+            int taps = std::abs(step.position - position);
+            int dir = step.position > position ? 1 : -1;
+            for (int k = 1; k <= taps; k++)
+                predicted.push_back({now + (double)((uint64_t)k * step.time_ms / taps), (double)(position + dir * k)});
+            now += step.time_ms;
+            position = step.position;
+        }
+    }
+    double predicted_end = now;
+
+    const std::vector<Waypoint> &knots = map.points;
+    double start = knots.front().time_ms;
+    double requested_end = knots.back().time_ms - start;
+    double end = std::max(predicted_end, requested_end);
+
+    // Requested position at t, with the knot index kept between calls
+    size_t j = 0;
+    auto requested = [&](double t) {
+        while (j + 1 < knots.size() && knots[j + 1].time_ms - start <= t)
+            j++;
+        if (j + 1 >= knots.size())
+            return knots.back().position;
+        double t0 = knots[j].time_ms - start;
+        double t1 = knots[j + 1].time_ms - start;
+        return knots[j].position + (knots[j + 1].position - knots[j].position) * (t - t0) / (t1 - t0);
+    };
+
+    TrajectoryError error;
+    double sum_squares = 0;
+    double value = knots.front().position;
+    size_t e = 0;
+    size_t k = 1;
+    double a = 0;
+
+    while (a < end)
+    {
+        while (e < predicted.size() && predicted[e].time <= a)
+            value = predicted[e++].value;
+
+        // Next breakpoint of either curve
+        double b = end;
+        if (e < predicted.size())
+            b = std::min(b, predicted[e].time);
+        while (k < knots.size() && knots[k].time_ms - start <= a)
+            k++;
+        if (k < knots.size())
+            b = std::min(b, knots[k].time_ms - start);
+
+        double error_a = value - requested(a);
+        double error_b = value - requested(b);
+        if (std::fabs(error_a) > error.max_taps)
+        {
+            error.max_taps = std::fabs(error_a);
+            error.max_at_ms = a;
+        }
+        if (std::fabs(error_b) > error.max_taps)
+        {
+            error.max_taps = std::fabs(error_b);
+            error.max_at_ms = b;
+        }
+        sum_squares += (b - a) * (error_a * error_a + error_a * error_b + error_b * error_b) / 3;
+        a = b;
+    }
+
+    error.rms_taps = end > 0 ? std::sqrt(sum_squares / end) : 0;
+    error.end_ms = predicted_end - requested_end;
+    return error;
+}
+
+bool CompiledMap::ok() const
+{
+    for (const Diagnostic &diagnostic : diagnostics)
+    {
+        if (diagnostic.error)
+            return false;
+    }
+    return true;
+}
+
+CompiledMap compileMap(const ThrottleMap &map, const CompileOptions &options)
+{
+    CompiledMap compiled;
+    std::vector<Diagnostic> &diagnostics = compiled.diagnostics;
+
+    if (map.points.empty())
+    {
+        addDiagnostic(diagnostics, 0, true, "map has no points");
+        return compiled;
+    }
+    if (map.name.empty() || map.name.size() > MAP_SCRIPT_NAME_LEN)
+        addDiagnostic(diagnostics, 0, true, "name must be 1 to 8 chars");
+    for (char c : map.name)
+    {
+        if (!std::isalnum((unsigned char)c) || std::isupper((unsigned char)c))
+        {
+            addDiagnostic(diagnostics, 0, true, "name must be lowercase letters and digits");
+            break;
+        }
+    }
+
+    // Times are rounded from the start of the map so rounding never accumulates
+    const std::vector<Waypoint> &points = map.points;
+    double start = points.front().time_ms;
+    std::vector<uint64_t> times(points.size());
+    std::vector<int> positions(points.size());
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        const Waypoint &point = points[i];
+        if (point.position < 0 || point.position > MAP_POSITION_MAX)
+            addDiagnostic(diagnostics, point.line, true, "position out of 0 to 99");
+        if (i > 0 && point.time_ms <= points[i - 1].time_ms)
+            addDiagnostic(diagnostics, point.line, true, "time does not increase");
+        times[i] = (uint64_t)std::llround(point.time_ms - start);
+        positions[i] = (int)std::lround(std::min(std::max(point.position, 0.0), (double)MAP_POSITION_MAX));
+    }
+    if (!compiled.ok())
+        return compiled;
+
+    // One step per segment, holds merge into one wait
+    std::vector<MapStep> &steps = compiled.steps;
+    steps.push_back({'p', positions[0], 0, points[0].line});
+    for (size_t i = 1; i < points.size(); i++)
+    {
+        uint64_t length = times[i] - times[i - 1];
+        int from = positions[i - 1];
+        int to = positions[i];
+        int line = points[i].line;
+
+        if (to == from)
+        {
+            while (length > 0)
+            {
+                if (steps.back().op == 'w' && steps.back().time_ms < MAP_TIME_MAX)
+                {
+                    uint64_t room = MAP_TIME_MAX - steps.back().time_ms;
+                    uint64_t add = std::min(room, length);
+                    steps.back().time_ms += add;
+                    length -= add;
+                }
+                else
+                    steps.push_back({'w', to, 0, line});
+            }
+            continue;
+        }
+
+        if (length == 0)
+        {
+            steps.push_back({'p', to, 0, line});
+            continue;
+        }
+
+        uint64_t taps = std::abs(to - from);
+        if (length > MAP_TIME_MAX)
+            addDiagnostic(diagnostics, line, true, "ramp longer than " + std::to_string(MAP_TIME_MAX) + " ms");
+        else if (length / taps < options.min_step_ms)
+            addDiagnostic(diagnostics, line, true,
+                          "ramp of " + std::to_string(taps) + " taps in " + std::to_string(length) +
+                              " ms is faster than one tap per " + std::to_string(options.min_step_ms) + " ms");
+        steps.push_back({'t', to, (uint32_t)length, line});
+    }
+    if (!compiled.ok())
+        return compiled;
+
+    // Repetition, explicit or found, becomes a loop around the steps after the first set
+    std::vector<MapStep> pass = steps;
+    compiled.loop_begin = 1;
+    if (map.repeat > 1)
+    {
+        compiled.loop_count = map.repeat;
+        if (positions.back() != positions.front())
+        {
+            // Each pass has to start from the first point again
+            compiled.loop_begin = 0;
+            addDiagnostic(diagnostics, 0, false, "map ends away from its start, each pass jumps back to position " +
+                                                     std::to_string(positions.front()));
+        }
+    }
+    else if (options.fold && steps.size() > 2)
+    {
+        size_t period = smallestPeriod(steps, 1);
+        size_t count = (steps.size() - 1) / period;
+        if (count > 1 && count <= MAP_LOOP_COUNT_MAX)
+        {
+            steps.resize(1 + period);
+            compiled.loop_count = count;
+        }
+    }
+    if (compiled.loop_count > MAP_LOOP_COUNT_MAX)
+        addDiagnostic(diagnostics, 0, true, "repeat over " + std::to_string(MAP_LOOP_COUNT_MAX));
+
+    for (const MapStep &step : steps)
+        compiled.bytecode_size += bytecodeSize(step);
+    if (compiled.loop_count > 1)
+        compiled.bytecode_size += BYTECODE_LOOP + BYTECODE_NEXT;
+
+    compiled.format = options.format;
+    if (compiled.format == MapFormat::Auto)
+        compiled.format = compiled.bytecode_size <= MAP_SCRIPT_STEPS_MAX ? MapFormat::Script : MapFormat::Stream;
+    if (compiled.format != MapFormat::Stream && compiled.bytecode_size > MAP_SCRIPT_STEPS_MAX)
+        addDiagnostic(diagnostics, 0, true, "script needs " + std::to_string(compiled.bytecode_size) +
+                                                " bytes, the device holds " + std::to_string(MAP_SCRIPT_STEPS_MAX));
+
+    // One pass of the map as written, folding does not change the trajectory
+    compiled.error = predictError(map, pass);
+    return compiled;
+}
+
+// Device command line of a step
+static std::string stepLine(const MapStep &step)
+{
+    switch (step.op)
+    {
+    case 'p':
+        return "t " + std::to_string(step.position);
+    case 'w':
+        return "w " + std::to_string(step.time_ms);
+    default:
+        return "t " + std::to_string(step.position) + " " + std::to_string(step.time_ms);
+    }
+}
+
+// Bytecode of a step as hex, the encoding of Script_append in the firmware
+static std::string stepHex(uint8_t op, int arg, bool has_arg, int value, bool has_value, uint32_t time, bool has_time)
+{
+    std::vector<uint8_t> bytes = {op};
+    if (has_arg)
+        bytes.push_back((uint8_t)arg);
+    if (has_value)
+    {
+        bytes.push_back(value & 0xFF);
+        bytes.push_back(value >> 8);
+    }
+    if (has_time)
+    {
+        bytes.push_back(time & 0xFF);
+        bytes.push_back((time >> 8) & 0xFF);
+        bytes.push_back((time >> 16) & 0xFF);
+    }
+
+    std::string text;
+    char hex[4];
+    for (uint8_t byte : bytes)
+    {
+        std::snprintf(hex, sizeof(hex), "%02x ", byte);
+        text += hex;
+    }
+    return text;
+}
+
+static std::string stepBytecode(const MapStep &step)
+{
+    return stepHex(step.op, step.position, step.op != 'w', 0, false, step.time_ms, step.op != 'p') + "# " +
+           stepLine(step);
+}
+
+std::string emitMap(const ThrottleMap &map, const CompiledMap &compiled)
+{
+    std::ostringstream out;
+    const std::vector<MapStep> &steps = compiled.steps;
+    bool loop = compiled.loop_count > 1;
+
+    switch (compiled.format)
+    {
+    case MapFormat::Stream:
+        for (size_t i = 0; i < compiled.loop_begin; i++)
+            out << stepLine(steps[i]) << '\n';
+        for (unsigned pass = 0; pass < compiled.loop_count; pass++)
+        {
+            for (size_t i = compiled.loop_begin; i < steps.size(); i++)
+                out << stepLine(steps[i]) << '\n';
+        }
+        break;
+
+    case MapFormat::Bytecode:
+        for (size_t i = 0; i < steps.size(); i++)
+        {
+            // The loop body starts after the LOOP step, NEXT jumps back to it
+            if (loop && i == compiled.loop_begin)
+                out << stepHex('l', 0, true, compiled.loop_count, true, 0, false) << "# l " << compiled.loop_count
+                    << '\n';
+            out << stepBytecode(steps[i]) << '\n';
+        }
+        if (loop)
+        {
+            size_t body = 0;
+            for (size_t i = 0; i < compiled.loop_begin; i++)
+                body += bytecodeSize(steps[i]);
+            out << stepHex('n', 0, true, body + BYTECODE_LOOP, true, 0, false) << "# n\n";
+        }
+        break;
+
+    default:
+        out << "e r " << map.name << '\n';
+        for (size_t i = 0; i < steps.size(); i++)
+        {
+            if (loop && i == compiled.loop_begin)
+                out << "l " << compiled.loop_count << '\n';
+            out << stepLine(steps[i]) << '\n';
+        }
+        if (loop)
+            out << "n\n";
+        out << "e s\n";
+        break;
+    }
+    return out.str();
+}
+
+} // namespace dyno
@@ -0,0 +1,126 @@
+/*
+ * ThrottleMap.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Compiler from throttle maps, waypoints of time and pot position, to the
+ *  firmware's 't' and 'w' command lines or to the script bytecode the 'e'
+ *  command stores in EEPROM. The map is linear between waypoints.
+ *
+ *  The device plans tap k of a ramp at floor(k * time / taps) ms from its
+ *  start, so the compiler checks every ramp against the minimum step period
+ *  and predicts the staircase the pot will actually follow, to report how far it strays from
+ *  the requested map. Everything runs in time linear in the map length.
+ */
+
+#ifndef THROTTLE_MAP_H_
+#define THROTTLE_MAP_H_
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace dyno
+{
+
+// Firmware limits, must match Application.h, X9C.h and Script.h
+#define MAP_POSITION_MAX 99      // X9C_MAX_POS
+#define MAP_TIME_MAX 0xFFFFFFUL  // SCRIPT_TIME_MAX, ms per step
+#define MAP_SCRIPT_NAME_LEN 8    // SCRIPT_NAME_LEN
+#define MAP_SCRIPT_STEPS_MAX 240 // SCRIPT_STEPS_MAX, bytes
+#define MAP_LOOP_COUNT_MAX 65535
+
+struct Waypoint
+{
+    double time_ms;
+    double position;
+    int line; // line of the map file, for diagnostics
+};
+
+struct ThrottleMap
+{
+    std::string name = "map";
+    unsigned repeat = 1; // times the whole map runs
+    std::vector<Waypoint> points;
+};
+
+struct Diagnostic
+{
+    int line; // 0 when not tied to a line
+    bool error;
+    std::string message;
+};
+
+// One device step, in the terms of the firmware's script opcodes
+struct MapStep
+{
+    char op;          // 't' ramp, 'p' set, 'w' wait
+    int position;     // ramp and set target
+    uint32_t time_ms; // ramp and wait length
+    int line;
+
+    bool operator==(const MapStep &other) const
+    {
+        return op == other.op && position == other.position && time_ms == other.time_ms;
+    }
+};
+
+enum class MapFormat
+{
+    Auto,     // script if it fits, stream otherwise
+    Stream,   // 't' and 'w' lines sent one at a time by the host
+    Script,   // 'e r' recording of the steps, run from EEPROM by 'e x'
+    Bytecode  // hex of the script steps as stored on the device
+};
+
+struct CompileOptions
+{
+    MapFormat format = MapFormat::Auto;
+    uint32_t min_step_ms = 1; // shortest time between ramp taps the device can keep
+    bool fold = true;         // find repetition and emit it as a loop
+};
+
+// Predicted versus requested trajectory
+struct TrajectoryError
+{
+    double max_taps = 0;     // worst position error
+    double max_at_ms = 0;    // where it happens, from the start of the map
+    double rms_taps = 0;
+    double end_ms = 0;       // predicted minus requested end of the map
+};
+
+struct CompiledMap
+{
+    MapFormat format = MapFormat::Stream;
+    std::vector<MapStep> steps;   // device steps, with repetition folded out
+    size_t loop_begin = 0;        // steps[loop_begin..] repeat loop_count times
+    unsigned loop_count = 1;
+    size_t bytecode_size = 0;
+    TrajectoryError error;
+    std::vector<Diagnostic> diagnostics;
+
+    bool ok() const;
+};
+
+// Parses "time_ms,position" rows, with an optional header row and # comments
+bool parseCsv(std::istream &in, ThrottleMap &map, std::vector<Diagnostic> &diagnostics);
+
+// Parses the YAML subset:
+//   name: cycle
+//   repeat: 20
+//   points:
+//     - [0, 0]          # time_ms, position
+//     - [2000, 50]
+bool parseYaml(std::istream &in, ThrottleMap &map, std::vector<Diagnostic> &diagnostics);
+
+// Compiles a parsed map. Check ok() before emitting
+CompiledMap compileMap(const ThrottleMap &map, const CompileOptions &options);
+
+// Device text for the compiled map in its format, one command per line
+std::string emitMap(const ThrottleMap &map, const CompiledMap &compiled);
+
+} // namespace dyno
+
+#endif /* THROTTLE_MAP_H_ */
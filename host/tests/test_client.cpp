@@ -0,0 +1,383 @@
+/*
+ * test_client.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Checks of the device client against a scripted fake device on a pty. The
+ *  test plays the device: it reads the lines the client writes and answers
+ *  with the echoes, starts, ends and errors the firmware would, driving the
+ *  client's event loop with poll() in between. Prints each failed check and
+ *  exits non-zero if any failed.
+ */
+
+#include "DeviceClient.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <future>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#define POLL_PASSES 8 // event loop passes per exchange, enough to drain the pty both ways
+
+using namespace dyno;
+
+static int failures = 0;
+
+#define CHECK(condition)                                                                                   \
+    do                                                                                                     \
+    {                                                                                                      \
+        if (!(condition))                                                                                  \
+        {                                                                                                  \
+            std::fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #condition); \
+            failures++;                                                                                    \
+        }                                                                                                  \
+    } while (0)
+
+// The device end of a pty, the client opens the other end as its port
+class FakeDevice
+{
+public:
+    FakeDevice() : master_(-1)
+    {
+        master_ = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master_ < 0 || grantpt(master_) != 0 || unlockpt(master_) != 0)
+        {
+            std::perror("posix_openpt");
+            std::exit(1);
+        }
+        fcntl(master_, F_SETFL, fcntl(master_, F_GETFL) | O_NONBLOCK);
+        path_ = ptsname(master_);
+    }
+
+    ~FakeDevice() { ::close(master_); }
+
+    const std::string &path() const { return path_; }
+
+    // Writes device output, lines separated by '\n'
+    void write(const std::string &text)
+    {
+        if (::write(master_, text.data(), text.size()) != (ssize_t)text.size())
+        {
+            std::perror("write");
+            std::exit(1);
+        }
+    }
+
+    // Runs the client's event loop and returns the lines it wrote since the last call
+    std::vector<std::string> exchange(DeviceClient &client)
+    {
+        char buffer[256];
+        for (int pass = 0; pass < POLL_PASSES; pass++)
+        {
+            client.poll(2);
+            ssize_t n;
+            while ((n = ::read(master_, buffer, sizeof(buffer))) > 0)
+                in_.append(buffer, n);
+        }
+
+        std::vector<std::string> lines;
+        size_t end;
+        while ((end = in_.find('\n')) != std::string::npos)
+        {
+            lines.push_back(in_.substr(0, end));
+            in_.erase(0, end + 1);
+        }
+        return lines;
+    }
+
+    // Unfinished bytes, a lone stop byte for one
+    const std::string &partial() const { return in_; }
+
+private:
+    int master_;
+    std::string path_;
+    std::string in_;
+};
+
+static bool ready(const std::future<Reply> &future)
+{
+    return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// Reply of a finished command, a closed one if it has not finished, so a failed check never blocks
+static Reply result(std::future<Reply> &future)
+{
+    return ready(future) ? future.get() : Reply();
+}
+
+// Opens the client on the device and plays the reset banner and the terse switch
+static void boot(FakeDevice &device, DeviceClient &client)
+{
+    client.open(device.path());
+    CHECK(device.exchange(client).empty()); // held until the banner ends
+
+    device.write("Throttle Mapper v2\r\n>\r\n");
+    std::vector<std::string> lines = device.exchange(client);
+    CHECK(lines.size() == 1 && lines[0] == "h t");
+
+    device.write("h t\n<\n>\n");
+    device.exchange(client);
+    CHECK(client.inFlight() == 0);
+}
+
+/** =================================================
+ * Starts and ends
+ */
+
+static void testStartOrder()
+{
+    FakeDevice device;
+    DeviceClient client;
+    boot(device, client);
+
+    std::future<Reply> first = client.send("w 100");
+    std::future<Reply> second = client.send("w 200");
+    std::future<Reply> third = client.send("w 300");
+    std::vector<std::string> lines = device.exchange(client);
+    CHECK(lines == std::vector<std::string>({"w 100", "w 200", "w 300"}));
+
+    // '<' starts the oldest unstarted command, '>' ends the running one
+    device.write("w 100\n<\nw 200\nw 300\n>\n");
+    device.exchange(client);
+    CHECK(ready(first));
+    CHECK(!ready(second));
+    CHECK(client.inFlight() == 2);
+
+    // An error inside a command ends it as failed
+    device.write("<\n?5,1\n>\n<\n>3\n");
+    device.exchange(client);
+    CHECK(ready(second) && ready(third));
+
+    Reply reply = result(first);
+    CHECK(reply.ok());
+    CHECK(reply.command == "w 100");
+    CHECK(reply.sent_us <= reply.start_us && reply.start_us <= reply.done_us);
+
+    reply = result(second);
+    CHECK(reply.status == ReplyStatus::Error);
+    CHECK(reply.error_code == 5 && reply.error_arg == 1);
+    CHECK(reply.lines == std::vector<std::string>({"?5,1"}));
+
+    reply = result(third);
+    CHECK(reply.ok());
+    CHECK(reply.late_ms == 3);
+    CHECK(client.inFlight() == 0);
+}
+
+static void testOutOfBand()
+{
+    FakeDevice device;
+    DeviceClient client;
+    std::vector<std::string> frames;
+    client.onFrame([&](char, const std::string &line, uint64_t) { frames.push_back(line); });
+    boot(device, client);
+
+    std::future<Reply> ramp = client.send("t 50 1000");
+    device.exchange(client);
+    std::future<Reply> waiting = client.send("w 10");
+    std::future<Reply> sync = client.send("y 1");
+
+    // A 'y' waits until every earlier command has started
+    std::vector<std::string> lines = device.exchange(client);
+    CHECK(lines == std::vector<std::string>({"w 10"}));
+    device.write("t 50 1000\n<\nw 10\n");
+    lines = device.exchange(client);
+    CHECK(lines.empty());
+
+    // The ramp ends and 'w 10' starts, nothing is left unstarted
+    device.write("[1.00,20,20202,5\n>0\n<\n");
+    lines = device.exchange(client);
+    CHECK(ready(ramp));
+    CHECK(lines == std::vector<std::string>({"y 1"}));
+
+    // '>' closes the command that started last, the 'y' inside 'w 10'
+    device.write("y 1\n<\n~1,1000,1200,1\n>\n");
+    device.exchange(client);
+    CHECK(ready(sync));
+    CHECK(!ready(waiting));
+
+    Reply reply = result(sync);
+    CHECK(reply.ok());
+    CHECK(reply.lines == std::vector<std::string>({"~1,1000,1200,1"}));
+
+    // A retarget runs inside the wait the same way
+    std::future<Reply> retarget = client.send("u 20 100");
+    lines = device.exchange(client);
+    CHECK(lines == std::vector<std::string>({"u 20 100"}));
+    device.write("u 20 100\n<\n>\n>\n");
+    device.exchange(client);
+    CHECK(result(retarget).ok());
+    CHECK(result(waiting).ok());
+    CHECK(result(ramp).ok());
+
+    // Frames reach the handler, the sync reply as well as its command
+    CHECK(frames == std::vector<std::string>({"[1.00,20,20202,5", "~1,1000,1200,1"}));
+    CHECK(client.inFlight() == 0);
+}
+
+/** =================================================
+ * Flushes and refusals
+ */
+
+static void testQuitFlush()
+{
+    FakeDevice device;
+    DeviceClient client;
+    boot(device, client);
+
+    std::future<Reply> ramp = client.send("t 50 1000");
+    std::future<Reply> read = client.send("w 100");
+    std::future<Reply> unread = client.send("w 200");
+    device.exchange(client);
+    device.write("t 50 1000\n<\nw 100\n");
+    device.exchange(client);
+
+    // The 'q' runs ahead of the device's queue and flushes the running and
+    // the queued commands
+    std::future<Reply> quit = client.send("q");
+    std::vector<std::string> lines = device.exchange(client);
+    CHECK(lines == std::vector<std::string>({"q"}));
+    device.write("w 200\n");
+    device.write("q\n!\n");
+    device.exchange(client);
+
+    CHECK(result(quit).ok());
+    CHECK(result(ramp).status == ReplyStatus::Flushed);
+    CHECK(result(read).status == ReplyStatus::Flushed);
+    CHECK(result(unread).status == ReplyStatus::Flushed);
+    CHECK(client.inFlight() == 0);
+
+    // A line still in the RX buffer when the 'q' flushes runs after it
+    std::future<Reply> running = client.send("w 300");
+    device.exchange(client);
+    device.write("w 300\n<\n");
+    device.exchange(client);
+    quit = client.send("q");
+    std::future<Reply> late = client.send("w 400");
+    lines = device.exchange(client);
+    CHECK(lines == std::vector<std::string>({"q", "w 400"}));
+    device.write("q\n!\n");
+    device.exchange(client);
+    CHECK(result(quit).ok());
+    CHECK(result(running).status == ReplyStatus::Flushed);
+    CHECK(!ready(late));
+
+    device.write("w 400\n<\n>\n");
+    device.exchange(client);
+    CHECK(result(late).ok());
+    CHECK(client.inFlight() == 0);
+}
+
+static void testQuitBypassesQueue()
+{
+    FakeDevice device;
+    DeviceClient client;
+    boot(device, client);
+
+    std::vector<std::future<Reply>> queued;
+    for (unsigned i = 0; i < DEVICE_CMD_QUEUE_LEN; i++)
+        queued.push_back(client.send("w " + std::to_string(100 + i)));
+    std::future<Reply> held = client.send("w 999");
+    std::vector<std::string> lines = device.exchange(client);
+    CHECK(lines.size() == DEVICE_CMD_QUEUE_LEN);
+    CHECK(!ready(held));
+
+    // The 'q' goes out past the full queue, and what waits behind the limit
+    // would only be flushed
+    std::future<Reply> quit = client.send("q");
+    CHECK(result(held).status == ReplyStatus::Flushed);
+    lines = device.exchange(client);
+    CHECK(lines == std::vector<std::string>({"q"}));
+
+    device.write("w 100\n<\nw 101\nw 102\nw 103\nq\n!\n");
+    device.exchange(client);
+    CHECK(result(quit).ok());
+    for (std::future<Reply> &future : queued)
+        CHECK(result(future).status == ReplyStatus::Flushed);
+    CHECK(client.inFlight() == 0);
+}
+
+static void testQueueFull()
+{
+    FakeDevice device;
+    DeviceClient client;
+    boot(device, client);
+
+    std::future<Reply> first = client.send("w 100");
+    std::future<Reply> second = client.send("w 200");
+    std::future<Reply> third = client.send("w 300");
+    device.exchange(client);
+
+    // A line refused on arrival is the last one the device echoed
+    device.write("w 100\n<\nw 200\n?25\nw 300\n");
+    device.exchange(client);
+    CHECK(ready(second));
+    CHECK(!ready(first) && !ready(third));
+
+    Reply reply = result(second);
+    CHECK(reply.status == ReplyStatus::Error);
+    CHECK(reply.error_code == 25);
+
+    // The rest carry on, the next start is the third command's
+    device.write(">\n<\n>\n");
+    device.exchange(client);
+    CHECK(result(first).ok());
+    CHECK(result(third).ok());
+    CHECK(client.inFlight() == 0);
+}
+
+/** =================================================
+ * Resets
+ */
+
+static void testStopAndReboot()
+{
+    FakeDevice device;
+    DeviceClient client;
+    boot(device, client);
+
+    std::future<Reply> ramp = client.send("t 50 1000");
+    device.exchange(client);
+    device.write("t 50 1000\n<\n");
+    device.exchange(client);
+
+    // The stop byte goes straight out, the device answers with a stop frame
+    client.emergencyStop();
+    device.exchange(client);
+    CHECK(device.partial() == "\x1B");
+    device.write("!180,240\n");
+    device.exchange(client);
+    CHECK(result(ramp).status == ReplyStatus::Stopped);
+
+    // A reboot fails what was sent and switches to terse responses again
+    std::future<Reply> lost = client.send("w 100");
+    device.exchange(client);
+    device.write("Throttle Mapper v2\n>\n");
+    std::vector<std::string> lines = device.exchange(client);
+    CHECK(result(lost).status == ReplyStatus::Reset);
+    CHECK(lines == std::vector<std::string>({"h t"}));
+}
+
+int main()
+{
+    testStartOrder();
+    testOutOfBand();
+    testQuitFlush();
+    testQuitBypassesQueue();
+    testQueueFull();
+    testStopAndReboot();
+
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
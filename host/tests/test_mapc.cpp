@@ -0,0 +1,394 @@
+/*
+ * test_mapc.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Checks of the throttle map compiler behind dyno_mapc: the CSV and YAML
+ *  parsers, the steps and bytecode known maps compile to, and the messages of
+ *  the maps it refuses. Prints each failed check and exits non-zero if any
+ *  failed.
+ */
+
+#include "ThrottleMap.h"
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace dyno;
+
+static int failures = 0;
+
+#define CHECK(condition)                                                                                   \
+    do                                                                                                     \
+    {                                                                                                      \
+        if (!(condition))                                                                                  \
+        {                                                                                                  \
+            std::fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #condition); \
+            failures++;                                                                                    \
+        }                                                                                                  \
+    } while (0)
+
+// Map of (time_ms, position) points, all on line 0
+static ThrottleMap makeMap(const std::vector<std::pair<double, double>> &points)
+{
+    ThrottleMap map;
+    for (const auto &point : points)
+        map.points.push_back({point.first, point.second, 0});
+    return map;
+}
+
+static CompiledMap compile(const ThrottleMap &map, MapFormat format = MapFormat::Auto, bool fold = true)
+{
+    CompileOptions options;
+    options.format = format;
+    options.fold = fold;
+    return compileMap(map, options);
+}
+
+// True if the diagnostics hold exactly one entry, with this line, severity and message
+static bool onlyDiagnostic(const std::vector<Diagnostic> &diagnostics, int line, bool error, const std::string &message)
+{
+    return diagnostics.size() == 1 && diagnostics[0].line == line && diagnostics[0].error == error &&
+           diagnostics[0].message == message;
+}
+
+/** =================================================
+ * Parsing
+ */
+
+static void testParseCsv()
+{
+    std::istringstream in("time_ms,position\n"
+                          "0, 0\n"
+                          "# comment\n"
+                          "\n"
+                          "1000,50.5 # trailing\n");
+    ThrottleMap map;
+    std::vector<Diagnostic> diagnostics;
+    CHECK(parseCsv(in, map, diagnostics));
+    CHECK(diagnostics.empty());
+    CHECK(map.points.size() == 2);
+    CHECK(map.points[0].time_ms == 0 && map.points[0].position == 0 && map.points[0].line == 2);
+    CHECK(map.points[1].time_ms == 1000 && map.points[1].position == 50.5 && map.points[1].line == 5);
+}
+
+static void testParseCsvErrors()
+{
+    // Only the first row may be a header
+    std::istringstream in("0,0\n"
+                          "time,position\n"
+                          "100\n"
+                          "200,1x\n"
+                          "300,7\n");
+    ThrottleMap map;
+    std::vector<Diagnostic> diagnostics;
+    CHECK(!parseCsv(in, map, diagnostics));
+    CHECK(map.points.size() == 2);
+    CHECK(diagnostics.size() == 3);
+    for (size_t i = 0; i < diagnostics.size() && i < 3; i++)
+    {
+        CHECK(diagnostics[i].line == (int)i + 2);
+        CHECK(diagnostics[i].error);
+        CHECK(diagnostics[i].message == "expected time_ms, position");
+    }
+}
+
+static void testParseYaml()
+{
+    std::istringstream in("name: cycle   # comment\n"
+                          "repeat: 20\n"
+                          "points:\n"
+                          "  - [0, 0]\n"
+                          "\n"
+                          "  - [2000, 50]\n");
+    ThrottleMap map;
+    std::vector<Diagnostic> diagnostics;
+    CHECK(parseYaml(in, map, diagnostics));
+    CHECK(diagnostics.empty());
+    CHECK(map.name == "cycle");
+    CHECK(map.repeat == 20);
+    CHECK(map.points.size() == 2);
+    CHECK(map.points[1].time_ms == 2000 && map.points[1].position == 50 && map.points[1].line == 6);
+}
+
+static void testParseYamlErrors()
+{
+    std::istringstream in("- [0, 0]\n"
+                          "repeat: 0\n"
+                          "repeat: 1.5\n"
+                          "speed: 3\n"
+                          "points\n"
+                          "points:\n"
+                          "  - 0, 0\n"
+                          "  - [0]\n");
+    ThrottleMap map;
+    std::vector<Diagnostic> diagnostics;
+    CHECK(!parseYaml(in, map, diagnostics));
+    CHECK(map.points.empty());
+    CHECK(map.repeat == 1);
+
+    std::vector<Diagnostic> expected = {
+        {1, true, "expected a point like - [time_ms, position] under points:"},
+        {2, true, "unknown or invalid key 'repeat'"},
+        {3, true, "unknown or invalid key 'repeat'"},
+        {4, true, "unknown or invalid key 'speed'"},
+        {5, true, "expected key: value"},
+        {7, true, "expected a point like - [time_ms, position] under points:"},
+        {8, true, "expected time_ms, position"},
+    };
+    CHECK(diagnostics.size() == expected.size());
+    for (size_t i = 0; i < diagnostics.size() && i < expected.size(); i++)
+    {
+        CHECK(diagnostics[i].line == expected[i].line);
+        CHECK(diagnostics[i].error == expected[i].error);
+        CHECK(diagnostics[i].message == expected[i].message);
+    }
+}
+
+/** =================================================
+ * Compiling
+ */
+
+static void testCompileSteps()
+{
+    // Times are relative to the first point and round to whole ms
+    ThrottleMap map = makeMap({{500, 0}, {1500.4, 50}, {2500, 50}, {3500, 0}});
+    CompiledMap compiled = compile(map);
+    CHECK(compiled.ok());
+    CHECK(compiled.diagnostics.empty());
+
+    std::vector<MapStep> expected = {{'p', 0, 0, 0}, {'t', 50, 1000, 0}, {'w', 50, 1000, 0}, {'t', 0, 1000, 0}};
+    CHECK(compiled.steps == expected);
+    CHECK(compiled.loop_count == 1);
+    CHECK(compiled.bytecode_size == 2 + 5 + 4 + 5);
+    CHECK(compiled.format == MapFormat::Script);
+
+    CHECK(emitMap(map, compiled) == "e r map\n"
+                                    "t 0\n"
+                                    "t 50 1000\n"
+                                    "w 1000\n"
+                                    "t 0 1000\n"
+                                    "e s\n");
+
+    compiled = compile(map, MapFormat::Stream);
+    CHECK(emitMap(map, compiled) == "t 0\n"
+                                    "t 50 1000\n"
+                                    "w 1000\n"
+                                    "t 0 1000\n");
+
+    compiled = compile(map, MapFormat::Bytecode);
+    CHECK(emitMap(map, compiled) == "70 00 # t 0\n"
+                                    "74 32 e8 03 00 # t 50 1000\n"
+                                    "77 e8 03 00 # w 1000\n"
+                                    "74 00 e8 03 00 # t 0 1000\n");
+}
+
+static void testCompileHolds()
+{
+    // Consecutive holds merge into one wait, a jump in position is a set
+    ThrottleMap map = makeMap({{0, 5}, {1000, 5}, {3000, 5}, {3000.2, 9}});
+    CompiledMap compiled = compile(map);
+    CHECK(compiled.ok());
+    std::vector<MapStep> expected = {{'p', 5, 0, 0}, {'w', 5, 3000, 0}, {'p', 9, 0, 0}};
+    CHECK(compiled.steps == expected);
+    CHECK(compiled.bytecode_size == 2 + 4 + 2);
+
+    // A hold longer than one wait can time splits at the limit
+    map = makeMap({{0, 5}, {20000000, 5}});
+    compiled = compile(map);
+    CHECK(compiled.ok());
+    expected = {{'p', 5, 0, 0}, {'w', 5, MAP_TIME_MAX, 0}, {'w', 5, 20000000 - MAP_TIME_MAX, 0}};
+    CHECK(compiled.steps == expected);
+    CHECK(compiled.bytecode_size == 2 + 4 + 4);
+}
+
+static void testCompileFold()
+{
+    ThrottleMap map = makeMap({{0, 0}, {100, 10}, {200, 0}, {300, 10}, {400, 0}, {500, 10}, {600, 0}});
+    CompiledMap compiled = compile(map);
+    CHECK(compiled.ok());
+    std::vector<MapStep> expected = {{'p', 0, 0, 0}, {'t', 10, 100, 0}, {'t', 0, 100, 0}};
+    CHECK(compiled.steps == expected);
+    CHECK(compiled.loop_begin == 1);
+    CHECK(compiled.loop_count == 3);
+    CHECK(compiled.bytecode_size == 2 + 5 + 5 + 4 + 4);
+
+    CHECK(emitMap(map, compiled) == "e r map\n"
+                                    "t 0\n"
+                                    "l 3\n"
+                                    "t 10 100\n"
+                                    "t 0 100\n"
+                                    "n\n"
+                                    "e s\n");
+
+    // NEXT points at the first body step, after the set and the LOOP
+    compiled = compile(map, MapFormat::Bytecode);
+    CHECK(emitMap(map, compiled) == "70 00 # t 0\n"
+                                    "6c 00 03 00 # l 3\n"
+                                    "74 0a 64 00 00 # t 10 100\n"
+                                    "74 00 64 00 00 # t 0 100\n"
+                                    "6e 00 06 00 # n\n");
+
+    // The stream unrolls the loop
+    compiled = compile(map, MapFormat::Stream);
+    CHECK(emitMap(map, compiled) == "t 0\n"
+                                    "t 10 100\nt 0 100\n"
+                                    "t 10 100\nt 0 100\n"
+                                    "t 10 100\nt 0 100\n");
+
+    // Without folding the steps stay as written
+    compiled = compile(map, MapFormat::Script, false);
+    CHECK(compiled.steps.size() == 7);
+    CHECK(compiled.loop_count == 1);
+    CHECK(compiled.bytecode_size == 2 + 6 * 5);
+}
+
+static void testCompileRepeat()
+{
+    // A map that ends away from its start loops from the first set
+    ThrottleMap map = makeMap({{0, 0}, {1000, 50}});
+    map.name = "up";
+    map.repeat = 3;
+    CompiledMap compiled = compile(map, MapFormat::Bytecode);
+    CHECK(compiled.ok());
+    CHECK(onlyDiagnostic(compiled.diagnostics, 0, false,
+                         "map ends away from its start, each pass jumps back to position 0"));
+    CHECK(compiled.loop_begin == 0);
+    CHECK(compiled.loop_count == 3);
+    CHECK(compiled.bytecode_size == 2 + 5 + 4 + 4);
+    CHECK(emitMap(map, compiled) == "6c 00 03 00 # l 3\n"
+                                    "70 00 # t 0\n"
+                                    "74 32 e8 03 00 # t 50 1000\n"
+                                    "6e 00 04 00 # n\n");
+
+    compiled.format = MapFormat::Script;
+    CHECK(emitMap(map, compiled) == "e r up\n"
+                                    "l 3\n"
+                                    "t 0\n"
+                                    "t 50 1000\n"
+                                    "n\n"
+                                    "e s\n");
+}
+
+static void testCompileError()
+{
+    // Tap k of a ramp lands at floor(k * time / taps), so the staircase
+    // trails the line by up to one tap and by a third of a tap rms
+    ThrottleMap map = makeMap({{0, 0}, {100, 10}});
+    CompiledMap compiled = compile(map);
+    CHECK(compiled.ok());
+    CHECK(std::fabs(compiled.error.max_taps - 1) < 1e-9);
+    CHECK(compiled.error.max_at_ms == 10);
+    CHECK(std::fabs(compiled.error.rms_taps - std::sqrt(1.0 / 3)) < 1e-9);
+    CHECK(compiled.error.end_ms == 0);
+}
+
+/** =================================================
+ * Refused maps
+ */
+
+static void testRefusedPoints()
+{
+    CHECK(onlyDiagnostic(compile(ThrottleMap()).diagnostics, 0, true, "map has no points"));
+
+    ThrottleMap map;
+    map.points = {{0, 0, 1}, {100, 100, 2}, {100, 10, 3}, {50, -1, 4}};
+    CompiledMap compiled = compile(map);
+    CHECK(!compiled.ok());
+    CHECK(compiled.steps.empty());
+    std::vector<Diagnostic> expected = {
+        {2, true, "position out of 0 to 99"},
+        {3, true, "time does not increase"},
+        {4, true, "position out of 0 to 99"},
+        {4, true, "time does not increase"},
+    };
+    CHECK(compiled.diagnostics.size() == expected.size());
+    for (size_t i = 0; i < compiled.diagnostics.size() && i < expected.size(); i++)
+    {
+        CHECK(compiled.diagnostics[i].line == expected[i].line);
+        CHECK(compiled.diagnostics[i].message == expected[i].message);
+    }
+}
+
+static void testRefusedName()
+{
+    ThrottleMap map = makeMap({{0, 0}, {1000, 10}});
+    map.name = "";
+    CHECK(onlyDiagnostic(compile(map).diagnostics, 0, true, "name must be 1 to 8 chars"));
+    map.name = "ninechars";
+    CHECK(onlyDiagnostic(compile(map).diagnostics, 0, true, "name must be 1 to 8 chars"));
+    map.name = "Cycle";
+    CHECK(onlyDiagnostic(compile(map).diagnostics, 0, true, "name must be lowercase letters and digits"));
+    map.name = "a_b";
+    CHECK(onlyDiagnostic(compile(map).diagnostics, 0, true, "name must be lowercase letters and digits"));
+}
+
+static void testRefusedRamps()
+{
+    ThrottleMap map;
+    map.points = {{0, 0, 1}, {10, 50, 2}};
+    CompiledMap compiled = compile(map);
+    CHECK(onlyDiagnostic(compiled.diagnostics, 2, true, "ramp of 50 taps in 10 ms is faster than one tap per 1 ms"));
+
+    // 50 taps in 100 ms keeps one tap per 2 ms, but not per 3
+    map.points = {{0, 0, 1}, {100, 50, 2}};
+    CompileOptions options;
+    options.min_step_ms = 2;
+    CHECK(compileMap(map, options).ok());
+    options.min_step_ms = 3;
+    CHECK(onlyDiagnostic(compileMap(map, options).diagnostics, 2, true,
+                         "ramp of 50 taps in 100 ms is faster than one tap per 3 ms"));
+
+    map.points = {{0, 0, 1}, {20000000, 1, 2}};
+    CHECK(onlyDiagnostic(compile(map).diagnostics, 2, true, "ramp longer than 16777215 ms"));
+}
+
+static void testRefusedSize()
+{
+    // 60 alternating points, 2 + 59 * 5 bytes unfolded
+    std::vector<std::pair<double, double>> points;
+    for (int i = 0; i < 60; i++)
+        points.push_back({i * 100.0, (i % 2) * 10.0});
+    ThrottleMap map = makeMap(points);
+
+    CompiledMap compiled = compile(map, MapFormat::Script, false);
+    CHECK(compiled.bytecode_size == 297);
+    CHECK(onlyDiagnostic(compiled.diagnostics, 0, true, "script needs 297 bytes, the device holds 240"));
+
+    compiled = compile(map, MapFormat::Auto, false);
+    CHECK(compiled.ok());
+    CHECK(compiled.format == MapFormat::Stream);
+
+    map.points.resize(3);
+    map.repeat = MAP_LOOP_COUNT_MAX + 1;
+    CHECK(onlyDiagnostic(compile(map).diagnostics, 0, true, "repeat over 65535"));
+}
+
+int main()
+{
+    testParseCsv();
+    testParseCsvErrors();
+    testParseYaml();
+    testParseYamlErrors();
+    testCompileSteps();
+    testCompileHolds();
+    testCompileFold();
+    testCompileRepeat();
+    testCompileError();
+    testRefusedPoints();
+    testRefusedName();
+    testRefusedRamps();
+    testRefusedSize();
+
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
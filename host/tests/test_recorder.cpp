@@ -0,0 +1,455 @@
+/*
+ * test_recorder.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Checks of the recorder: the SPSC ring, the columnar recording file and the
+ *  three thread pipeline. Prints each failed check and exits non-zero if any
+ *  failed. Files are written to the system temporary directory and removed.
+ */
+
+#include "RecordPipeline.h"
+#include "Recording.h"
+#include "SpscRing.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define PIPELINE_FRAMES 1500000 // ~35 MB of frames, several times the byte ring
+
+using namespace dyno;
+
+static int failures = 0;
+
+#define CHECK(condition)                                                                                   \
+    do                                                                                                     \
+    {                                                                                                      \
+        if (!(condition))                                                                                  \
+        {                                                                                                  \
+            std::fprintf(stderr, "%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #condition); \
+            failures++;                                                                                    \
+        }                                                                                                  \
+    } while (0)
+
+static std::string tempPath(const char *name)
+{
+    const char *dir = std::getenv("TMPDIR");
+    return std::string(dir != nullptr ? dir : "/tmp") + "/dyno_test_" + std::to_string(getpid()) + "_" + name;
+}
+
+static Sample makeSample(uint64_t i)
+{
+    Sample sample;
+    sample.time_us = 1000 * (i + 1);
+    sample.device_ms = i;
+    for (unsigned ch = 0; ch < DEVICE_CHANNELS_MAX; ch++)
+    {
+        sample.voltage_100uV[ch] = (uint16_t)(i * 7 + ch);
+        sample.position[ch] = (uint8_t)((i + ch) % 100);
+        sample.ohms[ch] = (uint32_t)(i * 101 + ch);
+    }
+    return sample;
+}
+
+static bool sameSample(const Sample &a, const Sample &b, unsigned channels)
+{
+    if (a.time_us != b.time_us || a.device_ms != b.device_ms)
+        return false;
+    for (unsigned ch = 0; ch < channels; ch++)
+    {
+        if (a.voltage_100uV[ch] != b.voltage_100uV[ch] || a.position[ch] != b.position[ch] ||
+            a.ohms[ch] != b.ohms[ch])
+            return false;
+    }
+    return true;
+}
+
+/** =================================================
+ * SpscRing
+ */
+
+static void testRingCapacity()
+{
+    SpscRing<int> ring(5);
+    CHECK(ring.capacity() == 8);
+    CHECK(ring.space() == 8);
+    CHECK(ring.size() == 0);
+
+    int item;
+    CHECK(!ring.pop(item));
+}
+
+static void testRingWrap()
+{
+    SpscRing<int> ring(8);
+    int in[8], out[8];
+
+    // Leaves both counters at 6, so the next bulk copies split at the end
+    for (int i = 0; i < 6; i++)
+        in[i] = i;
+    CHECK(ring.push(in, 6));
+    CHECK(ring.pop(out, 6) == 6);
+
+    for (int i = 0; i < 5; i++)
+        in[i] = 100 + i;
+    CHECK(ring.push(in, 5));
+    CHECK(ring.size() == 5);
+    CHECK(ring.space() == 3);
+
+    CHECK(ring.pop(out, 8) == 5);
+    for (int i = 0; i < 5; i++)
+        CHECK(out[i] == 100 + i);
+    CHECK(ring.size() == 0);
+}
+
+static void testRingFull()
+{
+    SpscRing<int> ring(8);
+    int in[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+    int out[8];
+
+    CHECK(ring.push(in, 6));
+    CHECK(ring.space() == 2);
+
+    // All or none, a push that does not fit leaves the ring as it was
+    CHECK(!ring.push(in, 3));
+    CHECK(ring.size() == 6);
+    CHECK(ring.push(in + 6, 2));
+    CHECK(!ring.push(in[0]));
+    CHECK(ring.space() == 0);
+
+    CHECK(ring.pop(out, 8) == 8);
+    for (int i = 0; i < 8; i++)
+        CHECK(out[i] == i);
+}
+
+static void testRingThreads()
+{
+    // Batches that do not divide the capacity, so both sides wrap mid copy
+    SpscRing<uint32_t> ring(64);
+    const uint32_t count = 1000000;
+    bool ordered = true;
+
+    std::thread consumer([&]() {
+        uint32_t next = 0, batch[37];
+        while (next < count)
+        {
+            size_t n = ring.pop(batch, 37);
+            for (size_t i = 0; i < n; i++)
+                ordered &= batch[i] == next++;
+            if (n == 0)
+                std::this_thread::yield();
+        }
+    });
+
+    uint32_t batch[13];
+    for (uint32_t next = 0; next < count;)
+    {
+        uint32_t n = std::min<uint32_t>(13, count - next);
+        for (uint32_t i = 0; i < n; i++)
+            batch[i] = next + i;
+        if (ring.push(batch, n))
+            next += n;
+        else
+            std::this_thread::yield();
+    }
+    consumer.join();
+    CHECK(ordered);
+}
+
+/** =================================================
+ * Recording
+ */
+
+static void testRecordingRoundTrip()
+{
+    std::string path = tempPath("round_trip.rec");
+    FrameLayout layout;
+    layout.channels = 2;
+    const unsigned rows = 10;
+
+    RecordingWriter writer;
+    writer.create(path, layout, 4);
+    for (unsigned i = 0; i < rows; i++)
+        writer.append(makeSample(i));
+
+    // A time before the last row's is raised to it
+    Sample late = makeSample(rows);
+    late.time_us = 500;
+    writer.append(late);
+    writer.close();
+
+    RecordingReader reader;
+    reader.open(path);
+    CHECK(reader.closedCleanly());
+    CHECK(reader.rowCount() == rows + 1);
+    CHECK(reader.chunkCount() == 3);
+    CHECK(reader.header().channels == 2);
+    CHECK(reader.chunk(1).first_row == 4);
+    CHECK(reader.chunk(2).rows == 3);
+
+    bool match = true;
+    for (size_t c = 0; c < reader.chunkCount(); c++)
+    {
+        ChunkView chunk = reader.chunk(c);
+        for (uint32_t r = 0; r < chunk.rows && chunk.first_row + r < rows; r++)
+            match &= sameSample(chunk.row(r), makeSample(chunk.first_row + r), layout.channels);
+    }
+    CHECK(match);
+    CHECK(reader.chunk(2).row(2).time_us == 1000 * rows);
+
+    CHECK(reader.lowerBound(0) == 0);
+    CHECK(reader.lowerBound(2500) == 2);
+    CHECK(reader.lowerBound(5000) == 4);
+    CHECK(reader.lowerBound(1000 * rows + 1) == rows + 1);
+
+    // Rows 2 to 6 span the first two chunks
+    std::vector<uint64_t> times;
+    reader.scan(2500, 7500, [&](const ChunkView &chunk, uint32_t begin, uint32_t end) {
+        for (uint32_t r = begin; r < end; r++)
+            times.push_back(chunk.time_us[r]);
+        return true;
+    });
+    CHECK(times.size() == 5);
+    CHECK(!times.empty() && times.front() == 3000 && times.back() == 7000);
+
+    reader.close();
+    unlink(path.c_str());
+}
+
+// A writer that dies without close() leaves a file readable up to its last row
+static void testRecordingNotClosed()
+{
+    std::string path = tempPath("not_closed.rec");
+    FrameLayout layout;
+    const unsigned rows = 9;
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        RecordingWriter writer;
+        writer.create(path, layout, 4);
+        for (unsigned i = 0; i < rows; i++)
+            writer.append(makeSample(i));
+        _exit(0);
+    }
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status));
+
+    RecordingReader reader;
+    reader.open(path);
+    CHECK(!reader.closedCleanly());
+    CHECK(reader.rowCount() == rows);
+    CHECK(reader.chunkCount() == 3);
+    CHECK(reader.lowerBound(1000 * rows) == rows - 1);
+    CHECK(reader.chunk(2).row(0).time_us == 1000 * rows);
+
+    reader.close();
+    unlink(path.c_str());
+}
+
+/** =================================================
+ * RecordPipeline
+ */
+
+// Frames of the default layout, one channel, written to a file
+static std::string writeFrames(const char *name, unsigned frames)
+{
+    std::string path = tempPath(name);
+    FILE *file = std::fopen(path.c_str(), "w");
+    for (unsigned i = 0; i < frames; i++)
+        std::fprintf(file, "[%u.%04u,%u,%u,%u\n", i % 5, i % 10000, i % 100, i % 100000, i);
+    std::fclose(file);
+    return path;
+}
+
+static void testPipelineLossless()
+{
+    std::string frames = writeFrames("lossless.txt", PIPELINE_FRAMES);
+    std::string path = tempPath("lossless.rec");
+    FrameLayout layout;
+
+    RecordingWriter writer;
+    writer.create(path, layout);
+    int fd = open(frames.c_str(), O_RDONLY);
+    RecordPipeline pipeline(fd, layout, writer, true);
+    pipeline.start();
+    pipeline.join();
+    writer.close();
+    close(fd);
+
+    PipelineStats stats = pipeline.stats();
+    CHECK(pipeline.finished());
+    CHECK(stats.bytes_dropped == 0 && stats.reads_dropped == 0);
+    CHECK(stats.lines == PIPELINE_FRAMES && stats.lines_cut == 0);
+    CHECK(stats.frames == PIPELINE_FRAMES && stats.malformed == 0);
+    CHECK(stats.samples_dropped == 0);
+    CHECK(stats.rows == PIPELINE_FRAMES);
+
+    RecordingReader reader;
+    reader.open(path);
+    CHECK(reader.rowCount() == PIPELINE_FRAMES);
+    ChunkView last = reader.chunk(reader.chunkCount() - 1);
+    CHECK(last.device_ms[last.rows - 1] == PIPELINE_FRAMES - 1);
+
+    reader.close();
+    unlink(path.c_str());
+    unlink(frames.c_str());
+}
+
+// A file reads far faster than frames decode, so the byte ring fills. What
+// does not fit is dropped whole and counted, and the lines it cut are never
+// decoded into malformed frames
+static void testPipelineLossy()
+{
+    std::string frames = writeFrames("lossy.txt", PIPELINE_FRAMES);
+    std::string path = tempPath("lossy.rec");
+    FrameLayout layout;
+
+    RecordingWriter writer;
+    writer.create(path, layout);
+    int fd = open(frames.c_str(), O_RDONLY);
+    struct stat st;
+    fstat(fd, &st);
+    RecordPipeline pipeline(fd, layout, writer, false);
+    pipeline.start();
+    pipeline.join();
+    writer.close();
+    close(fd);
+
+    PipelineStats stats = pipeline.stats();
+    CHECK(stats.bytes_read == (uint64_t)st.st_size);
+    CHECK(stats.bytes_dropped > 0 && stats.reads_dropped > 0);
+    CHECK(stats.lines_cut > 0 && stats.lines_cut <= stats.reads_dropped);
+    CHECK(stats.malformed == 0);
+    CHECK(stats.frames < PIPELINE_FRAMES);
+    CHECK(stats.rows + stats.samples_dropped == stats.frames);
+
+    RecordingReader reader;
+    reader.open(path);
+    CHECK(reader.rowCount() == stats.rows);
+
+    reader.close();
+    unlink(path.c_str());
+    unlink(frames.c_str());
+}
+
+// stop() ends a pipeline whose input never does
+static void testPipelineStop()
+{
+    std::string path = tempPath("stop.rec");
+    FrameLayout layout;
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+
+    RecordingWriter writer;
+    writer.create(path, layout);
+    RecordPipeline pipeline(fds[0], layout, writer);
+    pipeline.start();
+
+    const char frame[] = "[1.2345,50,50505,1000\n";
+    CHECK(write(fds[1], frame, sizeof(frame) - 1) == (ssize_t)sizeof(frame) - 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!pipeline.finished());
+
+    auto start = std::chrono::steady_clock::now();
+    pipeline.stop();
+    pipeline.join();
+    auto waited = std::chrono::steady_clock::now() - start;
+    CHECK(waited < std::chrono::seconds(1));
+    CHECK(pipeline.finished());
+    CHECK(pipeline.stats().rows == 1);
+
+    writer.close();
+    close(fds[0]);
+    close(fds[1]);
+    unlink(path.c_str());
+}
+
+// A file size limit fails the second chunk, join() throws what the writer threw
+static void testPipelineWriteError()
+{
+    std::string path = tempPath("error.rec");
+    FrameLayout layout;
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+
+    RecordingWriter writer;
+    writer.create(path, layout, 4);
+
+    rlimit old_limit;
+    getrlimit(RLIMIT_FSIZE, &old_limit);
+    rlimit limit = old_limit;
+    limit.rlim_cur = REC_PAGE_SIZE + REC_PAGE_SIZE;
+    std::signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &limit);
+
+    RecordPipeline pipeline(fds[0], layout, writer);
+    pipeline.start();
+    std::string input;
+    for (unsigned i = 0; i < 8; i++)
+        input += "[1.2345,50,50505," + std::to_string(i) + "\n";
+    CHECK(write(fds[1], input.data(), input.size()) == (ssize_t)input.size());
+
+    // The writer stops the reader itself, no stop() needed
+    int error = 0;
+    try
+    {
+        pipeline.join();
+    }
+    catch (const std::system_error &e)
+    {
+        error = e.code().value();
+    }
+    CHECK(error == EFBIG);
+    CHECK(writer.rows() == 4);
+
+    setrlimit(RLIMIT_FSIZE, &old_limit);
+    std::signal(SIGXFSZ, SIG_DFL);
+    try
+    {
+        writer.close();
+    }
+    catch (const std::system_error &)
+    {
+    }
+    close(fds[0]);
+    close(fds[1]);
+    unlink(path.c_str());
+}
+
+int main()
+{
+    testRingCapacity();
+    testRingWrap();
+    testRingFull();
+    testRingThreads();
+    testRecordingRoundTrip();
+    testRecordingNotClosed();
+    testPipelineLossless();
+    testPipelineLossy();
+    testPipelineStop();
+    testPipelineWriteError();
+
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
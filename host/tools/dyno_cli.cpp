@@ -0,0 +1,118 @@
+/*
+ * dyno_cli.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Sends commands to the device back to back and prints each reply, without
+ *  waiting for one command to finish before sending the next.
+ *
+ *      dyno_cli [--frames] <port> [command ...]
+ *
+ *  Commands come from the arguments, or one per line from stdin. Each reply
+ *  is printed in the order sent, with its status and time from start to end:
+ *
+ *      t 50 300: done 301.2 ms, late 0
+ *      c 9: error 5,1
+ *
+ *  --frames also prints the data and other frames as they arrive. Exits 1 if
+ *  any command did not finish.
+ */
+
+#include "DeviceClient.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace dyno;
+
+static const char *statusText(ReplyStatus status)
+{
+    switch (status)
+    {
+    case ReplyStatus::Done:
+        return "done";
+    case ReplyStatus::Error:
+        return "error";
+    case ReplyStatus::Flushed:
+        return "flushed";
+    case ReplyStatus::Stopped:
+        return "stopped";
+    case ReplyStatus::Reset:
+        return "reset";
+    default:
+        return "closed";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int arg = 1;
+    bool frames = false;
+    if (arg < argc && std::strcmp(argv[arg], "--frames") == 0)
+    {
+        frames = true;
+        arg++;
+    }
+    if (arg >= argc)
+    {
+        std::fprintf(stderr, "usage: %s [--frames] <port> [command ...]\n", argv[0]);
+        return 2;
+    }
+    const char *path = argv[arg++];
+
+    std::vector<std::string> commands(argv + arg, argv + argc);
+    if (commands.empty())
+    {
+        std::string line;
+        while (std::getline(std::cin, line))
+            if (!line.empty())
+                commands.push_back(line);
+    }
+
+    DeviceClient client;
+    if (frames)
+        client.onFrame([](char, const std::string &line, uint64_t host_us) {
+            std::printf("%llu %s\n", (unsigned long long)host_us, line.c_str());
+        });
+
+    try
+    {
+        client.open(path);
+    }
+    catch (const std::system_error &e)
+    {
+        std::fprintf(stderr, "%s: %s\n", path, e.what());
+        return 1;
+    }
+    client.start();
+
+    std::vector<std::future<Reply>> replies;
+    for (const std::string &command : commands)
+        replies.push_back(client.send(command));
+
+    int failed = 0;
+    for (std::future<Reply> &future : replies)
+    {
+        Reply reply = future.get();
+        std::printf("%s: %s", reply.command.c_str(), statusText(reply.status));
+        if (reply.status == ReplyStatus::Error)
+            std::printf(" %d,%d", reply.error_code, reply.error_arg);
+        if (reply.start_us)
+            std::printf(" %.1f ms", (reply.done_us - reply.start_us) / 1000.0);
+        if (reply.late_ms)
+            std::printf(", late %ld", reply.late_ms);
+        std::printf("\n");
+        for (const std::string &line : reply.lines)
+            std::printf("    %s\n", line.c_str());
+        if (reply.status != ReplyStatus::Done)
+            failed++;
+    }
+
+    client.close();
+    return failed ? 1 : 0;
+}
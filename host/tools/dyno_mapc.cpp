@@ -0,0 +1,175 @@
+/*
+ * dyno_mapc.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Compiles a throttle map file into device input.
+ *
+ *      dyno_mapc [options] <map.csv|map.yaml>
+ *
+ *      --format F       auto, stream, script or bytecode (default auto)
+ *      --name N         script name, overrides the map file
+ *      --repeat N       times the map runs, overrides the map file
+ *      --min-step-ms N  shortest time between ramp taps (default 1)
+ *      --no-fold        do not turn repetition into a loop
+ *      -o FILE          write to FILE instead of stdout
+ *
+ *  Auto picks a script when the steps fit the device's script size, the
+ *  stream of 't' and 'w' lines otherwise. Diagnostics and the predicted
+ *  trajectory error go to stderr, the exit code is 1 on any error.
+ */
+
+#include "ThrottleMap.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace dyno;
+
+static const char *formatName(MapFormat format)
+{
+    switch (format)
+    {
+    case MapFormat::Stream:
+        return "stream";
+    case MapFormat::Script:
+        return "script";
+    case MapFormat::Bytecode:
+        return "bytecode";
+    default:
+        return "auto";
+    }
+}
+
+static bool endsWith(const std::string &text, const std::string &end)
+{
+    return text.size() >= end.size() && text.compare(text.size() - end.size(), end.size(), end) == 0;
+}
+
+static void usage(const char *program)
+{
+    std::fprintf(stderr,
+                 "usage: %s [--format auto|stream|script|bytecode] [--name N] [--repeat N]\n"
+                 "          [--min-step-ms N] [--no-fold] [-o FILE] <map.csv|map.yaml>\n",
+                 program);
+}
+
+static void printDiagnostics(const std::string &path, const std::vector<Diagnostic> &diagnostics)
+{
+    for (const Diagnostic &diagnostic : diagnostics)
+    {
+        std::fprintf(stderr, "%s:", path.c_str());
+        if (diagnostic.line > 0)
+            std::fprintf(stderr, "%d:", diagnostic.line);
+        std::fprintf(stderr, " %s: %s\n", diagnostic.error ? "error" : "warning", diagnostic.message.c_str());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    CompileOptions options;
+    std::string path;
+    std::string out_path;
+    std::string name;
+    long repeat = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--format" && has_value)
+        {
+            std::string format = argv[++i];
+            if (format == "auto")
+                options.format = MapFormat::Auto;
+            else if (format == "stream")
+                options.format = MapFormat::Stream;
+            else if (format == "script")
+                options.format = MapFormat::Script;
+            else if (format == "bytecode")
+                options.format = MapFormat::Bytecode;
+            else
+            {
+                usage(argv[0]);
+                return 2;
+            }
+        }
+        else if (arg == "--name" && has_value)
+            name = argv[++i];
+        else if (arg == "--repeat" && has_value)
+            repeat = std::atol(argv[++i]);
+        else if (arg == "--min-step-ms" && has_value)
+            options.min_step_ms = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--no-fold")
+            options.fold = false;
+        else if (arg == "-o" && has_value)
+            out_path = argv[++i];
+        else if (arg[0] != '-' && path.empty())
+            path = arg;
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path.empty() || repeat < 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::fprintf(stderr, "%s: %s\n", path.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    ThrottleMap map;
+    std::vector<Diagnostic> diagnostics;
+    bool parsed = endsWith(path, ".yaml") || endsWith(path, ".yml") ? parseYaml(in, map, diagnostics)
+                                                                     : parseCsv(in, map, diagnostics);
+    printDiagnostics(path, diagnostics);
+    if (!parsed)
+        return 1;
+
+    if (!name.empty())
+        map.name = name;
+    if (repeat > 0)
+        map.repeat = (unsigned)repeat;
+
+    CompiledMap compiled = compileMap(map, options);
+    printDiagnostics(path, compiled.diagnostics);
+    if (!compiled.ok())
+        return 1;
+
+    std::string text = emitMap(map, compiled);
+    if (out_path.empty())
+        std::cout << text;
+    else
+    {
+        std::ofstream out(out_path);
+        if (!(out << text))
+        {
+            std::fprintf(stderr, "%s: %s\n", out_path.c_str(), std::strerror(errno));
+            return 1;
+        }
+    }
+
+    const TrajectoryError &error = compiled.error;
+    std::fprintf(stderr, "%s: %zu points, %s, %zu steps", path.c_str(), map.points.size(),
+                 formatName(compiled.format), compiled.steps.size());
+    if (compiled.loop_count > 1)
+        std::fprintf(stderr, " looped %u times", compiled.loop_count);
+    std::fprintf(stderr, ", %zu of %d script bytes\n", compiled.bytecode_size, MAP_SCRIPT_STEPS_MAX);
+    std::fprintf(stderr, "predicted error: max %.2f taps at %.0f ms, rms %.2f taps, end %+.0f ms\n",
+                 error.max_taps, error.max_at_ms, error.rms_taps, error.end_ms);
+    return 0;
+}
@@ -0,0 +1,272 @@
+/*
+ * dyno_rec.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Records data frames into a columnar recording and reads them back.
+ *
+ *      dyno_rec record [options] <port|-> <file.rec>
+ *      dyno_rec info <file.rec>
+ *      dyno_rec scan <file.rec> [from [to]]
+ *
+ *      --channels N     channels the firmware was built with (default 1)
+ *      --mask M         'd' command field mask in effect (default 15)
+ *      --chunk-rows N   rows per chunk (default 65536)
+ *      --stats S        print the pipeline counters every S seconds
+ *
+ *  record reads '[' and '{' frames from the port, or from stdin for '-', until
+ *  interrupted or the input ends. Other lines are ignored. Reading, decoding
+ *  and writing run on threads of their own, see RecordPipeline.h. Input from
+ *  stdin is never dropped, so replaying a capture also measures how fast the
+ *  pipeline runs. The counters and the throughput go to stderr. scan prints the
+ *  rows between two times as CSV. Times are host us, or seconds from the
+ *  first row with an 's' suffix, as in "scan run.rec 60s 120s".
+ */
+
+#include "FrameDecoder.h"
+#include "RecordPipeline.h"
+#include "Recording.h"
+#include "SerialPort.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#define SUPERVISE_MS 100
+#define DEVICE_BYTES_MAX 100000.0 // bytes/s at 1000000 baud, the fastest SerialPort sets
+
+using namespace dyno;
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void onSignal(int)
+{
+    interrupted = 1;
+}
+
+static void usage(const char *program)
+{
+    std::fprintf(stderr,
+                 "usage: %s record [--channels N] [--mask M] [--chunk-rows N] [--stats S] <port|-> <file.rec>\n"
+                 "       %s info <file.rec>\n"
+                 "       %s scan <file.rec> [from [to]]\n",
+                 program, program, program);
+}
+
+static void printStats(const PipelineStats &stats, double seconds)
+{
+    std::fprintf(stderr,
+                 "read %llu bytes, dropped %llu in %llu reads | %llu lines, %llu cut, %llu frames, %llu malformed, "
+                 "%llu samples dropped | %llu rows, %llu syncs",
+                 (unsigned long long)stats.bytes_read, (unsigned long long)stats.bytes_dropped,
+                 (unsigned long long)stats.reads_dropped, (unsigned long long)stats.lines,
+                 (unsigned long long)stats.lines_cut, (unsigned long long)stats.frames,
+                 (unsigned long long)stats.malformed, (unsigned long long)stats.samples_dropped,
+                 (unsigned long long)stats.rows, (unsigned long long)stats.syncs);
+    if (seconds > 0)
+        std::fprintf(stderr, " | %.2f MB/s, %.0f rows/s, %.0fx the fastest device", stats.bytes_read / seconds / 1e6,
+                     stats.rows / seconds, stats.bytes_read / seconds / DEVICE_BYTES_MAX);
+    std::fprintf(stderr, "\n");
+}
+
+static int record(int argc, char **argv)
+{
+    FrameLayout layout;
+    unsigned long chunk_rows = REC_CHUNK_ROWS;
+    double stats_s = 0;
+    std::vector<std::string> paths;
+
+    for (int i = 2; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--channels" && has_value)
+            layout.channels = std::strtoul(argv[++i], nullptr, 0);
+        else if (arg == "--mask" && has_value)
+            layout.mask = std::strtoul(argv[++i], nullptr, 0);
+        else if (arg == "--chunk-rows" && has_value)
+            chunk_rows = std::strtoul(argv[++i], nullptr, 0);
+        else if (arg == "--stats" && has_value)
+            stats_s = std::atof(argv[++i]);
+        else if (arg == "-" || arg[0] != '-')
+            paths.push_back(arg);
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (paths.size() != 2 || layout.channels < 1 || layout.channels > DEVICE_CHANNELS_MAX || chunk_rows == 0 ||
+        chunk_rows > 0xFFFFFFFFUL)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    SerialPort port;
+    bool from_stdin = paths[0] == "-";
+    RecordingWriter writer;
+    try
+    {
+        if (!from_stdin)
+            port.open(paths[0], DEVICE_BAUDRATE, true);
+        writer.create(paths[1], layout, chunk_rows);
+    }
+    catch (const std::system_error &e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    RecordPipeline pipeline(from_stdin ? 0 : port.fd(), layout, writer, from_stdin);
+    uint64_t start_us = hostTimeUs();
+    uint64_t printed_us = start_us;
+    pipeline.start();
+
+    while (!interrupted && !pipeline.finished())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(SUPERVISE_MS));
+        uint64_t now = hostTimeUs();
+        if (stats_s > 0 && now - printed_us >= stats_s * 1e6)
+        {
+            printStats(pipeline.stats(), (now - start_us) / 1e6);
+            printed_us = now;
+        }
+    }
+
+    pipeline.stop();
+    int status = 0;
+    try
+    {
+        pipeline.join();
+        writer.close();
+    }
+    catch (const std::system_error &e)
+    {
+        std::fprintf(stderr, "%s: %s\n", paths[1].c_str(), e.what());
+        status = 1;
+    }
+
+    std::fprintf(stderr, "%s: ", paths[1].c_str());
+    printStats(pipeline.stats(), (hostTimeUs() - start_us) / 1e6);
+    return status;
+}
+
+// Host us, or seconds from the first row with an 's' suffix
+static uint64_t parseTime(const char *text, const RecordingReader &reader)
+{
+    char *end;
+    double value = std::strtod(text, &end);
+    if (*end != 's')
+        return std::strtoull(text, nullptr, 10);
+
+    uint64_t first_us = reader.chunkCount() > 0 ? reader.chunk(0).first_us : 0;
+    return first_us + (uint64_t)(value * 1e6);
+}
+
+static int info(const RecordingReader &reader)
+{
+    const RecFileHeader &header = reader.header();
+    std::printf("channels %u, mask 0x%02X, %llu rows in %zu chunks of %u, %s\n", header.channels,
+                header.data_mask, (unsigned long long)reader.rowCount(), reader.chunkCount(), header.chunk_rows,
+                reader.closedCleanly() ? "closed" : "not closed, index rebuilt");
+    if (reader.chunkCount() > 0)
+    {
+        uint64_t first_us = reader.chunk(0).first_us;
+        uint64_t last_us = reader.chunk(reader.chunkCount() - 1).last_us;
+        std::printf("time %llu to %llu us, %.1f s\n", (unsigned long long)first_us, (unsigned long long)last_us,
+                    (last_us - first_us) / 1e6);
+    }
+    for (uint32_t c = 0; c < header.column_count; c++)
+        std::printf("column %s, %u bytes at %llu\n", header.columns[c].name, header.columns[c].width,
+                    (unsigned long long)header.columns[c].offset);
+    return 0;
+}
+
+static int scan(const RecordingReader &reader, uint64_t from_us, uint64_t to_us)
+{
+    unsigned channels = reader.header().channels;
+
+    std::printf("time_us,device_ms");
+    for (unsigned ch = 0; ch < channels; ch++)
+        std::printf(",voltage%u,position%u,ohms%u", ch, ch, ch);
+    std::printf("\n");
+
+    // Fields the frames did not carry are left empty
+    reader.scan(from_us, to_us, [channels](const ChunkView &chunk, uint32_t begin, uint32_t end) {
+        for (uint32_t r = begin; r < end; r++)
+        {
+            std::printf("%llu,", (unsigned long long)chunk.time_us[r]);
+            if (chunk.device_ms[r] != SAMPLE_NONE_MS)
+                std::printf("%llu", (unsigned long long)chunk.device_ms[r]);
+            for (unsigned ch = 0; ch < channels; ch++)
+            {
+                uint16_t voltage = chunk.voltage_100uV[ch][r];
+                if (voltage != SAMPLE_NONE_VOLTAGE)
+                    std::printf(",%u.%04u", voltage / 10000, voltage % 10000);
+                else
+                    std::printf(",");
+                if (chunk.position[ch][r] != SAMPLE_NONE_POSITION)
+                    std::printf(",%u", chunk.position[ch][r]);
+                else
+                    std::printf(",");
+                if (chunk.ohms[ch][r] != SAMPLE_NONE_OHMS)
+                    std::printf(",%u", chunk.ohms[ch][r]);
+                else
+                    std::printf(",");
+            }
+            std::printf("\n");
+        }
+        return true;
+    });
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::string command = argv[1];
+    if (command == "record")
+        return record(argc, argv);
+    if (command != "info" && command != "scan")
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    RecordingReader reader;
+    try
+    {
+        reader.open(argv[2]);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    if (command == "info")
+        return info(reader);
+
+    uint64_t from_us = argc > 3 ? parseTime(argv[3], reader) : 0;
+    uint64_t to_us = argc > 4 ? parseTime(argv[4], reader) : UINT64_MAX;
+    return scan(reader, from_us, to_us);
+}
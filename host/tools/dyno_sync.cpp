@@ -0,0 +1,106 @@
+/*
+ * dyno_sync.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Measures the offset and drift between the device and host clocks with a
+ *  series of 'y' exchanges, so data frame timestamps can be put on the host
+ *  time base.
+ *
+ *      dyno_sync <port> [exchanges] [interval_ms]
+ *
+ *  Prints one line per exchange and a summary:
+ *
+ *      sync ref_host_us=... offset_us=... drift_ppm=... bound_us=...
+ *
+ *  USB serial adapters buffer replies for up to their latency timer, so use a
+ *  few dozen exchanges and let the fit pick the fastest.
+ */
+
+#include "ClockSync.h"
+#include "SerialPort.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#define BANNER_TIMEOUT_MS 3000 // opening the port resets most Nanos
+#define REPLY_TIMEOUT_MS 1000
+
+using namespace dyno;
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <port> [exchanges] [interval_ms]\n", argv[0]);
+        return 2;
+    }
+    int exchanges = argc > 2 ? std::atoi(argv[2]) : 32;
+    int interval_ms = argc > 3 ? std::atoi(argv[3]) : 100;
+    if (exchanges < 2)
+    {
+        std::fprintf(stderr, "need at least 2 exchanges\n");
+        return 2;
+    }
+
+    SerialPort port;
+    try
+    {
+        port.open(argv[1]);
+    }
+    catch (const std::system_error &e)
+    {
+        std::fprintf(stderr, "%s: %s\n", argv[1], e.what());
+        return 1;
+    }
+
+    // Wait for the end of the reset banner, or carry on if the device did not reset
+    std::string line;
+    while (port.readLine(line, BANNER_TIMEOUT_MS))
+        if (line == ">")
+            break;
+
+    ClockSync sync;
+    for (int i = 0; i < exchanges; i++)
+    {
+        std::string request = "y " + std::to_string(i) + "\n";
+
+        // The device stamps the line end, which arrives after the whole request
+        uint64_t send_us = hostTimeUs();
+        port.writeAll(request);
+        send_us += (uint64_t)(request.size() * port.byteTimeUs());
+
+        bool replied = false;
+        while (!replied && port.readLine(line, REPLY_TIMEOUT_MS))
+        {
+            // The device stamps the reply start, we see it after the whole line
+            uint64_t recv_us = hostTimeUs() - (uint64_t)((line.size() + 2) * port.byteTimeUs());
+            if (sync.addReply(line, i, send_us, recv_us))
+            {
+                const SyncSample &s = sync.samples().back();
+                std::printf("%d rtt_us=%lld\n", i,
+                            (long long)((s.host_recv_us - s.host_send_us) - (s.device_tx_us - s.device_rx_us)));
+                replied = true;
+            }
+        }
+        if (!replied)
+            std::fprintf(stderr, "exchange %d: no reply\n", i);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    }
+
+    if (!sync.estimate())
+    {
+        std::fprintf(stderr, "too few replies\n");
+        return 1;
+    }
+
+    std::printf("sync ref_host_us=%llu offset_us=%.1f drift_ppm=%.2f bound_us=%.1f\n",
+                (unsigned long long)sync.referenceUs(), sync.offsetUs(), sync.driftPpm(), sync.errorBoundUs());
+    return 0;
+}
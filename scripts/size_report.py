@@ -0,0 +1,90 @@
+"""
+size_report.py
+
+PlatformIO extra script adding a "size_report" target. Prints static RAM
+(.data + .bss), flash (.text + .data) and the largest stack frame of every
+module, then fails the build if the totals exceed the budgets set in
+platformio.ini with custom_ram_budget and custom_flash_budget.
+
+    pio run -t size_report
+
+Stack frames come from the .su files written by -fstack-usage. They are per
+function, so the worst case call chain is not shown, only its largest link.
+"""
+
+import os
+import subprocess
+
+Import("env")
+
+
+def object_sizes(size_tool, path):
+    """Returns (text, data, bss) of an object or elf file in berkeley format"""
+    out = subprocess.check_output([size_tool, "-B", path]).decode().splitlines()
+    text, data, bss = out[1].split()[:3]
+    return int(text), int(data), int(bss)
+
+
+def max_stack_frame(su_path):
+    """Returns (bytes, function) of the largest stack frame in a .su file"""
+    largest = (0, "")
+    if not os.path.isfile(su_path):
+        return largest
+    with open(su_path) as su_file:
+        for line in su_file:
+            fields = line.rstrip().split("\t")
+            if len(fields) < 2:
+                continue
+            function = fields[0].split(":")[-1]
+            largest = max(largest, (int(fields[1]), function))
+    return largest
+
+
+def size_report(source, target, env):
+    size_tool = env.subst("$SIZETOOL")
+    build_dir = env.subst("$BUILD_DIR")
+    src_build_dir = os.path.join(build_dir, "src")
+    elf_path = env.subst("$BUILD_DIR/${PROGNAME}.elf")
+
+    row = "{:<28} {:>7} {:>7} {:>7}  {}"
+    print(row.format("module", "flash", "ram", "stack", "largest frame"))
+
+    module_flash = 0
+    module_ram = 0
+    for root, _, files in sorted(os.walk(src_build_dir)):
+        for name in sorted(files):
+            if not name.endswith(".o"):
+                continue
+            obj_path = os.path.join(root, name)
+            text, data, bss = object_sizes(size_tool, obj_path)
+            frame, function = max_stack_frame(obj_path[:-2] + ".su")
+            module = os.path.relpath(obj_path, src_build_dir)[:-2]
+            print(row.format(module, text + data, data + bss, frame, function))
+            module_flash += text + data
+            module_ram += data + bss
+
+    text, data, bss = object_sizes(size_tool, elf_path)
+    flash = text + data
+    ram = data + bss
+    print(row.format("framework and libraries", flash - module_flash, ram - module_ram, "", ""))
+    print(row.format("total", flash, ram, "", ""))
+
+    ram_budget = int(env.GetProjectOption("custom_ram_budget", 0))
+    flash_budget = int(env.GetProjectOption("custom_flash_budget", 0))
+    if ram_budget:
+        print("static ram budget {} bytes, {} headroom".format(ram_budget, ram_budget - ram))
+    if flash_budget:
+        print("flash budget {} bytes, {} left".format(flash_budget, flash_budget - flash))
+
+    if (ram_budget and ram > ram_budget) or (flash_budget and flash > flash_budget):
+        print("Error: memory budget exceeded")
+        env.Exit(1)
+
+
+env.AddCustomTarget(
+    name="size_report",
+    dependencies="$BUILD_DIR/${PROGNAME}.elf",
+    actions=[size_report],
+    title="Size Report",
+    description="Static RAM, flash and stack frame usage per module",
+)
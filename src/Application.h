@@ -13,22 +13,55 @@
 
 /* Arduino Includes */
 #include <Arduino.h>
-#include <X9C10X.h>
 
 /* HAL Includes */
-#include <HAL\HAL.h>
-#include <HAL\Timer.h>
+#include <HAL/Adc.h>
+#include <HAL/Calibration.h>
+#include <HAL/HAL.h>
+#include <HAL/Histogram.h>
+#include <HAL/Memory.h>
+#include <HAL/Script.h>
+#include <HAL/Timer.h>
+#include <HAL/Trigger.h>
+#include <HAL/Uart.h>
+#include <HAL/Watchdog.h>
+#include <HAL/X9C.h>
 
 #ifndef APPLICATION_H_
 #define APPLICATION_H_
 
 /* Settings */
 #define ECHO_EN 1
-#define S_DATA_TIMESTEP 250 // ms
+#define S_DATA_TIMESTEP 250 // ms, default data frame period
+#define S_DATA_TIMESTEP_MAX 3600000 // ms, longest period the 'd' command accepts
+
+/* Data frame fields, selected by the 'd' command mask */
+#define DATA_VOLTAGE 0x01   // voltage at divider, per channel
+#define DATA_POSITION 0x02  // pot position, per channel
+#define DATA_OHMS 0x04      // pot ohms, per channel
+#define DATA_TIMESTAMP 0x08 // timestamp of measurement
+#define DATA_FREE_RAM 0x10  // bytes between heap and stack
+#define DATA_OVERRUNS 0x20  // loop deadline overruns
+#define DATA_DEFAULT_MASK (DATA_VOLTAGE | DATA_POSITION | DATA_OHMS | DATA_TIMESTAMP)
+#define DATA_ALL_MASK 0x3F
+#define DATA_BATCH_MAX 8           // most samples in one batched frame
+#define DATA_BATCH_LATENCY_MAX 60000 // ms, longest a sample may wait in a batch
+#define CHANNEL_MASK_ALL ((1 << POT_CHANNELS) - 1) // channel mask bits this build has pots for
+#define SCRIPT_STEPS_PER_PASS 8 // script steps that take no time run together, up to this many per loop pass
+#define SYNC_PROBE_TAPS 10      // taps the wiper moves between the two looks of a resync
+#define SYNC_TOLERANCE 2        // taps a measured position may stray from the tracked one
+#define SYNC_CHECK_PERIOD 1000  // ms between background checks of the tracked positions
+#define SYNC_CHECK_COUNT 3      // checks in a row out of tolerance that flag a desync
+#define RECALL_ON 1             // config value that turns wiper recall on, erased EEPROM reads as off
+#define BOOT_SETTLE_COUNTS 2    // ADC counts a settled reading may still move by per filter latency
+#define BOOT_SETTLE_TIMEOUT 100 // ms, longest the boot waits for the measurements to settle
+#define RECALL_STILL_MS 10000   // ms a wiper must stay put before it is stored, spares the chips' store endurance
 
 /* Parameters */
 #define BAUDRATE 115200 // baud/s
 #define S_TIMEOUT 1000  // ms between serial characters until timeout
+#define WDT_TIMEOUT WDTO_250MS // MCU resets after this long without an in-budget loop pass
+#define LOOP_BUDGET_US 20000   // loop passes longer than this are deadline overruns
 
 /* Macros */
 #define MS_IN_SECONDS 1000 // milliseconds in a second
@@ -36,13 +69,16 @@
 #define ASCII_LF 10
 #define ASCII_CR 13
 #define CMD_CHAR_LEN 20    // maximum length of commands in chars
+#define CMD_QUEUE_LEN 4    // command lines kept while another command runs
 
 typedef enum
 {
     Idle,
     Executing,
     Linear,
-    Waiting
+    Waiting,
+    Scripting,
+    Syncing
 } _appStates; // states for the serial reader
 
 typedef enum
@@ -51,6 +87,194 @@ typedef enum
     Reading
 } _parserStates; // states for the string word parser
 
+/* Response codes, sent as ?<code>[,<argument>] in terse mode. The numbers
+   are part of the protocol, add new codes at the end */
+typedef enum
+{
+    RespOk = 0,
+    RespUnknownCommand = 1,
+    RespBadArgument = 2,
+    RespThrottleBounds = 3,
+    RespTimeBounds = 4,
+    RespChannelBounds = 5,
+    RespOversampleBounds = 6,
+    RespFieldMaskBounds = 7,
+    RespBatchBounds = 8,
+    RespEdgeBounds = 9,
+    RespCountBounds = 10,
+    RespVoltageBounds = 11,
+    RespOnlyRecording = 12,
+    RespNameTooLong = 13,
+    RespNotRecording = 14,
+    RespLoopNotClosed = 15,
+    RespLoopsTooDeep = 16,
+    RespNoLoop = 17,
+    RespEepromBusy = 18,
+    RespScriptFull = 19,
+    RespScriptNotFound = 20,
+    RespScriptExists = 21,
+    RespScriptCorrupt = 22,
+    RespCurveNotRising = 23,
+    RespVoltageTimeout = 24,
+    RespQueueFull = 25,
+    RESP_CODES
+} _responses;
+
+// A response packs its code with the index of the argument it is about, 0 for none
+#define RESPONSE_ARG_SHIFT 5
+#define RESPONSE_ARG(code, arg) ((code) | ((arg) << RESPONSE_ARG_SHIFT))
+#define RESPONSE_CODE(response) ((response) & ((1 << RESPONSE_ARG_SHIFT) - 1))
+
+typedef enum
+{
+    StageNone,
+    StageSetup,
+    StageLED,
+    StagePoll,
+    StageData,
+    StageSerialRX,
+    StageCommand,
+    StageRamp,
+    StageScript,
+    StageSync
+} _loopStages; // stage markers kept across resets by the watchdog
+
+typedef enum
+{
+    BootCore,   // Arduino core start up, before setup()
+    BootUart,   // pins, UART and the banner
+    BootInit,   // application, ADC, EEPROM and calibration
+    BootPots,   // wiper recall or homing
+    BootSettle, // until the measurements settle
+    BOOT_PHASES
+} _bootPhases; // phases of setup() timed for the boot report
+
+/** =================================================
+ * Position, measurement and ramp state of one potentiometer channel
+ */
+struct _Channel
+{
+    // Started with the ramp, expires at the planned time of the next step
+    SWTimer linear_cmd_timer;
+
+    uint32_t pot_ohms;
+    double pot_v;
+    uint8_t pot_pos;
+
+    int target_pos;
+    uint64_t ramping_time;
+    int steps; // steps left
+
+    // Step k of n is planned k * ramping_time / n ms after the start, kept
+    // exact by spreading the remainder of the division over the steps
+    uint8_t step_count;
+    uint8_t step_rem;
+    uint8_t step_err;
+    uint32_t step_ms;
+
+    // Background checks in a row that found the wiper away from its tracked
+    // position, and whether this desync has been reported
+    uint8_t desync_count;
+    bool desync;
+};
+typedef struct _Channel Channel;
+
+/** =================================================
+ * One data frame worth of measurements, as kept in a batch
+ */
+struct _DataSample
+{
+    unsigned long timestamp;
+    uint16_t pot_v_100uV[POT_CHANNELS]; // voltage at divider in 0.1 mV
+    uint8_t pot_pos[POT_CHANNELS];
+    uint16_t free_ram;
+    uint16_t overruns;
+};
+typedef struct _DataSample DataSample;
+
+/** =================================================
+ * Samples waiting to be sent as one batched frame
+ */
+struct _DataBatch
+{
+    uint8_t count;
+    DataSample samples[DATA_BATCH_MAX];
+};
+typedef struct _DataBatch DataBatch;
+
+/** =================================================
+ * Command lines received while another command runs, started in order
+ */
+struct _CommandQueue
+{
+    uint8_t head;
+    uint8_t count;
+    char lines[CMD_QUEUE_LEN][CMD_CHAR_LEN + 1];
+    unsigned long line_us[CMD_QUEUE_LEN]; // micros() at which each line end was received
+};
+typedef struct _CommandQueue CommandQueue;
+
+/** =================================================
+ * Progress of the running script against its planned schedule
+ */
+struct _ScriptRun
+{
+    bool running;
+    bool recording;      // script command lines are compiled into the script instead of run
+    uint8_t pc;          // offset of the next step
+    uint16_t steps;      // steps started so far, counting every loop pass
+    uint16_t worst_step; // step that started latest against the plan
+
+    unsigned long start_ms;
+    unsigned long planned_ms; // planned start of the next step, from start_ms
+    long worst_late_ms;
+    long end_late_ms;
+
+    // Loops being recorded, the body start of each open loop by nesting depth
+    uint8_t loop_depth;
+    uint8_t loop_start[SCRIPT_LOOP_DEPTH];
+
+    // Passes left of each running loop, by counter slot
+    uint16_t loop_left[SCRIPT_LOOP_DEPTH];
+
+    // Voltage wait in progress, ended by a crossing of voltage_mv or a timeout
+    bool voltage_wait;
+    bool voltage_rising;
+    bool voltage_timeout;
+    uint8_t voltage_channel;
+    uint16_t voltage_mv;
+};
+typedef struct _ScriptRun ScriptRun;
+
+/** =================================================
+ * Progress of a wiper resync or calibration sweep, one settled measurement per phase
+ */
+struct _WiperSync
+{
+    bool active;
+    bool calibrating; // sweeping the calibration curve instead of locating the wiper
+    uint8_t channel;  // channel being measured
+    uint8_t phase;    // resync look or calibration point measured next
+    int8_t dir;       // direction of the resync probe move
+    uint8_t tracked;  // tracked position before the resync, returned to at the end
+    uint8_t estimate; // position found by the first look
+
+    // Started after every move, expires once the ADC shows the new position
+    SWTimer settle_timer;
+};
+typedef struct _WiperSync WiperSync;
+
+/** =================================================
+ * Wiper positions held in the X9C non-volatile memory, mirrored in the EEPROM
+ * config block so the boot knows what the chips recalled at power up
+ */
+struct _WiperRecall
+{
+    uint8_t mode;                     // RECALL_ON, or off
+    uint8_t stored[POT_CHANNELS_MAX]; // position each chip holds, 0xFF if unknown
+};
+typedef struct _WiperRecall WiperRecall;
+
 /** =================================================
  * Primary struct for the application
  */
@@ -61,26 +285,37 @@ struct _Application
     SWTimer wait_cmd_timer;
     SWTimer pot_test_timer;
     SWTimer adc_settling_timer;
-    SWTimer linear_cmd_timer;
     SWTimer data_step_timer;
     SWTimer serial_timeout_timer;
+    SWTimer health_timer;
+    SWTimer batch_timer;
+    SWTimer sync_check_timer;
+    SWTimer recall_timer; // restarted whenever a wiper moves
 
-    uint32_t pot_ohms;
-    double pot_v;
-    uint8_t pot_pos;
+    Channel channels[POT_CHANNELS];
+    uint8_t channel_mask; // channels addressed by 't' and 's' commands
+    uint8_t data_mask;    // DATA_* fields sent in data frames
+    uint8_t batch_len;    // samples per batched frame, 1 sends plain frames
     unsigned long mes_timestamp;
-
-    int target_pos;
-    uint64_t ramping_time;
-    int steps;
+    ScriptRun script_run;
+    WiperSync wiper_sync;
 
     _appStates appState;
 
     bool new_value_flag;
     bool cmd_finished_flag;
     bool cmd_high_priority;
+    bool health_enabled;
+    bool trigger_fired; // an edge arrived while a command was armed
+    bool ramp_report;   // a 't' ramp finished, its completion error goes in the '>' frame
+    long ramp_late_ms;  // how long after its planned end the last ramp finished
+    bool terse;         // responses are sent as codes, see _responses
+    uint8_t last_response; // last response other than RespOk, explained by 'h'
+    char last_cmd;         // command it answered
     
-    String command;
+    char command[CMD_CHAR_LEN + 1];
+    unsigned long command_us;           // micros() at which the command's line end was received
+    char trigger_cmd[CMD_CHAR_LEN + 1]; // command armed by 'a', empty if none
 };
 typedef struct _Application Application;
 
@@ -96,6 +331,69 @@ void InitializePins();
 /** Store new potentiometer values from the pot object and real measurements */
 void pollPot(Application *app_p);
 
+/** Starts or replaces the ramp of every selected channel from its current position */
+void rampStart(Application *app_p, int target, uint64_t time);
+
+/** Moves a channel's step timer on to the planned time of its next step */
+void rampPlanNext(Channel *ch_p);
+
+/** Issues every step due by the ramp plans, missed ones in a batch, in shared pulses */
+void rampStep(Application *app_p);
+
+/** Returns true while any channel has ramp steps remaining */
+bool rampActive(Application *app_p);
+
+/** Compiles a step into the script being recorded, returns a response */
+uint8_t scriptRecord(uint8_t op, int8_t arg, uint16_t value, uint32_t time_ms);
+
+/** Records the start of a loop, its counter slot is its nesting depth */
+uint8_t scriptLoopOpen(Application *app_p, uint16_t count);
+
+/** Records the end of the innermost open loop */
+uint8_t scriptLoopClose(Application *app_p);
+
+/** Returns true once the script step in progress is done */
+bool scriptReady(Application *app_p);
+
+/** Returns false if a channel step of the script in SRAM selects none of the fitted channels */
+bool scriptChannelsFit(const Script *script_p);
+
+/** Starts running the script in SRAM from its first step */
+void scriptStart(Application *app_p);
+
+/** Starts the next script step and checks it against the schedule, false at the end */
+bool scriptStep(Application *app_p);
+
+/** Starts locating the wiper of every selected channel, or sweeping the calibration curve */
+void syncStart(Application *app_p, bool calibrating);
+
+/** Takes the next settled measurement of a resync or sweep, false once it is done */
+bool syncStep(Application *app_p);
+
+/** Measures the next calibration point, false once the curve is complete */
+bool calibrateStep(Application *app_p, uint16_t mv);
+
+/** Compares the settled measurements against the tracked positions and flags desyncs */
+void syncCheck(Application *app_p);
+
+/** Ends a boot phase and starts the next */
+void bootPhase(uint8_t phase, unsigned long *phase_us_p);
+
+/** Waits for every channel's measurement to settle, false after timeout_ms */
+bool adcWaitSettled(uint16_t timeout_ms);
+
+/** Adopts the wiper positions the chips recalled where the ADC confirms them, homes the rest */
+void recallBoot();
+
+/** Stores the wipers that settled away from their stored positions */
+void recallStore(Application *app_p);
+
+/** Starts the pending chip stores once the mirror write is done */
+void recallService();
+
+/** Turns wiper recall on or off */
+uint8_t recallSet(bool on);
+
 /** Heatbeat of the Arduino */
 void WatchdogLED(Application *app_p);
 
@@ -105,20 +403,98 @@ void primaryFSM(Application *app_p);
 /** Check serial RX and attempt to execute command */
 bool checkSerialRX(Application *app_p);
 
+/** Adds a line to the end of the command queue, false if it is full */
+bool commandPush(const char *line, unsigned long line_us);
+
+/** Takes the oldest line off the command queue, false if it is empty */
+bool commandPop(char *line, unsigned long *line_us_p);
+
 /** Prints data from the application struct */
 void serialPrintData(Application *app_p);
 
+/** Prints the comma before every data field but the first */
+void serialPrintSeparator(bool *first_p);
+
+/** Captures the current measurements as a data sample */
+DataSample dataSample(Application *app_p);
+
+/** Prints the fields of a sample selected by mask, with timestamp as the time field */
+void serialPrintSample(DataSample *sample_p, uint8_t mask, unsigned long timestamp);
+
+/** Adds the current measurements to the batch, sending it when full */
+void batchAdd(Application *app_p);
+
+/** Sends the batched samples as one frame with a shared base timestamp */
+void serialPrintBatch(Application *app_p);
+
 /** Cycles potentiometer for testing */
 void potSweep(Application *app_p);
 
 /** Parses an input for valid commands */
-void executeCommand(Application *app_p, String input);
+void executeCommand(Application *app_p, char *input);
 
-/** Parses an input for valid commands */
-String nextWord(String input, bool reset);
+/** Parses the 'e' script subcommands, returns a response */
+uint8_t executeScriptCommand(Application *app_p, const char *input);
+
+/** Returns the response to a script storage result */
+uint8_t scriptResponse(ScriptResult result);
+
+/** Parses the 'h' response subcommands, returns a response */
+uint8_t executeResponseCommand(Application *app_p, const char *input);
+
+/** Returns the verbose text of a response code */
+const __FlashStringHelper *responseText(uint8_t code);
+
+/** Prints a response as a code in terse mode, as text otherwise */
+void serialPrintResponse(Application *app_p, uint8_t response, char cmd);
+
+/** Prints the verbose text of a response, naming the command when it is known */
+void serialPrintResponseText(uint8_t response, char cmd);
+
+/** Copies the next word of the input into word */
+void nextWord(const char *input, char *word, bool reset);
 
 /** Returns true if the given string is only numeric */
-bool isNumeric(String str);
+bool isNumeric(const char *str);
+
+/** Prints stack high-water mark, free RAM and heap usage */
+void serialPrintHealth();
+
+/** Prints the loop period histogram bins, the longest period and the overrun count */
+void serialPrintHistogram(Histogram *hist_p, uint16_t overruns);
+
+/** Answers a clock sync request with the receive and transmit times in us */
+void serialPrintSync(const char *seq, unsigned long rx_us);
+
+/** Prints the steps run and the worst and final lateness of a finished script */
+void serialPrintScript(Application *app_p);
+
+/** Prints the stored scripts, the free EEPROM and the boot script */
+void serialPrintScriptList();
+
+/** Prints a marker number and the time it was reached in us */
+void serialPrintMarker(uint16_t marker);
+
+/** Ends a ramp command with its completion error */
+void serialPrintRampEnd(Application *app_p);
+
+/** Prints where a resync found a channel's wiper against where it was tracked */
+void serialPrintResync(uint8_t ch, uint8_t found, uint8_t tracked, bool following);
+
+/** Prints the time to ready and the time of each boot phase */
+void serialPrintBoot(bool settled);
+
+/** Prints the recall mode, the stored positions and the time to ready of the last boot */
+void serialPrintRecall();
+
+/** Prints the calibration curve */
+void serialPrintCalibration();
+
+/** Prints a desync found by the background check */
+void serialPrintDesync(uint8_t ch, uint8_t found, uint8_t tracked);
+
+/** Prints a captured trigger edge as its us timestamp and sequence number */
+void serialPrintTrigger(TriggerEvent *event_p);
 
 /** Prints a single char terminated by '\0'*/
 void serialPrintChar(char c);
@@ -126,6 +502,15 @@ void serialPrintChar(char c);
 /** Raises specific flags for high priority commands */
 void checkPriority(Application *app_p, char* cmd);
 
+/** Zeroes every pot from the RX interrupt when the stop byte arrives */
+void emergencyStop();
+
+/** Records the latency of a stop whose wipers just reached zero */
+void estopLatency(unsigned long start_us);
+
+/** Prints the last and worst emergency stop latency */
+void serialPrintStop();
+
 /** Resets the application variables and states */
 void resetApplication(Application *app_p);
 
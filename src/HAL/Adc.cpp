@@ -0,0 +1,185 @@
+/*
+ * Adc.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <HAL/Adc.h>
+#include <util/atomic.h>
+
+// Channel setup
+static uint8_t mux[ADC_CHANNELS_MAX];
+static uint8_t channel_count = 0;
+
+// Filter setup
+static uint8_t extra_bits = 0;
+static uint8_t median_len = 1;
+
+// Accumulator of the channel being converted
+static volatile uint8_t current = 0;
+static volatile uint32_t sum = 0;
+static volatile uint16_t sum_count = 0;
+static volatile bool discard = false;
+
+// Latest decimated results per channel, newest at history_i
+static volatile uint16_t history[ADC_CHANNELS_MAX][ADC_MEDIAN_MAX];
+static volatile uint8_t history_i[ADC_CHANNELS_MAX];
+static volatile uint8_t history_fill[ADC_CHANNELS_MAX];
+
+// Starts a conversion of the current channel
+static void Adc_start()
+{
+    ADMUX = _BV(REFS0) | mux[current]; // AVcc reference, like analogRead
+    ADCSRA |= _BV(ADSC);
+}
+
+// Clears accumulators and history, must run with the ADC interrupt blocked
+static void Adc_clear()
+{
+    current = 0;
+    sum = 0;
+    sum_count = 0;
+    discard = true; // a conversion may be running on the old mux
+    for (uint8_t ch = 0; ch < ADC_CHANNELS_MAX; ch++)
+    {
+        history_i[ch] = 0;
+        history_fill[ch] = 0;
+    }
+}
+
+// Conversion complete, accumulate and publish when enough samples are in
+ISR(ADC_vect)
+{
+    uint16_t sample = ADC;
+
+    // The first conversion after a mux change is still settling
+    if (discard)
+        discard = false;
+    else
+    {
+        sum += sample;
+        sum_count++;
+    }
+
+    if (sum_count >= ((uint16_t)1 << (2 * extra_bits)))
+    {
+        uint8_t ch = current;
+        uint8_t i = (history_i[ch] + 1) % ADC_MEDIAN_MAX;
+        history[ch][i] = sum >> extra_bits;
+        history_i[ch] = i;
+        if (history_fill[ch] < ADC_MEDIAN_MAX)
+            history_fill[ch]++;
+
+        sum = 0;
+        sum_count = 0;
+        current = (ch + 1) % channel_count;
+        discard = channel_count > 1;
+    }
+
+    Adc_start();
+}
+
+// Configure the pins and start converting
+void Adc_begin(const uint8_t *pins, uint8_t count)
+{
+    if (count > ADC_CHANNELS_MAX)
+        count = ADC_CHANNELS_MAX;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        channel_count = count;
+        for (uint8_t ch = 0; ch < count; ch++)
+            mux[ch] = (pins[ch] >= A0 ? pins[ch] - A0 : pins[ch]) & 0x07;
+
+        Adc_clear();
+
+        // Enabled, interrupt on completion, 16 MHz / 128 ADC clock
+        ADCSRA = _BV(ADEN) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+        Adc_start();
+    }
+}
+
+// Change oversampling and median length
+bool Adc_configure(uint8_t new_extra_bits, uint8_t new_median_len)
+{
+    if (new_extra_bits > ADC_EXTRA_BITS_MAX)
+        return false;
+    if (new_median_len != 1 && new_median_len != 3 && new_median_len != 5)
+        return false;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        extra_bits = new_extra_bits;
+        median_len = new_median_len;
+        Adc_clear();
+    }
+    return true;
+}
+
+// Median of the newest results of a channel
+uint16_t Adc_read(uint8_t channel)
+{
+    uint16_t values[ADC_MEDIAN_MAX];
+    uint8_t len;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        len = min(median_len, history_fill[channel]);
+        uint8_t i = history_i[channel];
+        for (uint8_t n = 0; n < len; n++)
+        {
+            values[n] = history[channel][i];
+            i = (i + ADC_MEDIAN_MAX - 1) % ADC_MEDIAN_MAX;
+        }
+    }
+
+    if (len == 0)
+        return 0;
+
+    // Insertion sort, at most five values
+    for (uint8_t n = 1; n < len; n++)
+    {
+        uint16_t value = values[n];
+        uint8_t m = n;
+        while (m > 0 && values[m - 1] > value)
+        {
+            values[m] = values[m - 1];
+            m--;
+        }
+        values[m] = value;
+    }
+
+    return values[(len - 1) / 2];
+}
+
+// Extra bits of resolution from oversampling
+uint8_t Adc_extraBits()
+{
+    return extra_bits;
+}
+
+// Every channel has filled its median
+bool Adc_ready()
+{
+    bool ready = channel_count > 0;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        for (uint8_t ch = 0; ch < channel_count; ch++)
+            ready &= history_fill[ch] >= median_len;
+    }
+    return ready;
+}
+
+// Worst case delay from a step at the input to a settled result
+uint16_t Adc_latencyMs()
+{
+    // A result may have started just before the step, then the median needs
+    // a majority of new results
+    uint32_t conversions = ((uint32_t)1 << (2 * extra_bits)) + (channel_count > 1 ? 1 : 0);
+    uint32_t results = 1 + (median_len + 1) / 2;
+    uint32_t total = conversions * results * max(channel_count, (uint8_t)1);
+
+    return (total * 1000 + ADC_CONVERSIONS_PER_S - 1) / ADC_CONVERSIONS_PER_S;
+}
@@ -0,0 +1,45 @@
+/*
+ * Adc.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Interrupt driven ADC with oversampling and decimation. Each result is the
+ *  sum of 4^n conversions shifted right by n, giving 10 + n bits, optionally
+ *  passed through a median of the last 3 or 5 results to reject spikes.
+ *  Channels are converted in turn, one result at a time.
+ *
+ *  Conversions run at 16 MHz / 128 / 13 = ~9600 per second, so every extra
+ *  bit divides the result rate by four.
+ */
+
+/* Arduino Driver Includes */
+#include <Arduino.h>
+
+#ifndef ADC_H_
+#define ADC_H_
+
+#define ADC_CHANNELS_MAX 2      // channels that can be converted
+#define ADC_EXTRA_BITS_MAX 4    // 256x oversampling, 14 bit results
+#define ADC_MEDIAN_MAX 5        // longest median filter
+#define ADC_CONVERSIONS_PER_S 9615
+
+// Starts converting the given analog pins continuously
+void Adc_begin(const uint8_t *pins, uint8_t count);
+
+// Sets the oversampling (0 to ADC_EXTRA_BITS_MAX extra bits) and median length (1, 3 or 5)
+bool Adc_configure(uint8_t extra_bits, uint8_t median_len);
+
+// Returns the latest filtered result of a channel, full scale is ADC_MAX << Adc_extraBits()
+uint16_t Adc_read(uint8_t channel);
+
+// Returns the number of extra bits the results carry
+uint8_t Adc_extraBits();
+
+// Returns how long a step change takes to fully reach Adc_read, in ms
+uint16_t Adc_latencyMs();
+
+// Returns true once every channel has a full median of results since Adc_begin or Adc_configure
+bool Adc_ready();
+
+#endif /* ADC_H_ */
@@ -0,0 +1,98 @@
+/*
+ * Calibration.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <HAL/Calibration.h>
+#include <HAL/X9C.h>
+
+static Calibration cal;
+
+// A curve is valid if no point reads erased EEPROM and it never falls
+static bool Calibration_valid(const uint16_t *mv)
+{
+    for (uint8_t i = 0; i < CAL_POINTS; i++)
+    {
+        if (mv[i] == 0xFFFF || (i > 0 && mv[i] < mv[i - 1]))
+            return false;
+    }
+    return true;
+}
+
+// Load the stored curve, the ideal divider when there is none
+void Calibration_begin(uint16_t full_scale_mv)
+{
+    eeprom_read_block(cal.mv, (const void *)(uintptr_t)CONFIG_CAL_ADDR, sizeof(cal.mv));
+    cal.stored = Calibration_valid(cal.mv);
+    if (cal.stored)
+        return;
+
+    for (uint8_t i = 0; i < CAL_POINTS; i++)
+        cal.mv[i] = ((uint32_t)Calibration_point(i) * full_scale_mv + X9C_MAX_POS / 2) / X9C_MAX_POS;
+}
+
+// Points are evenly spaced, the last one lands on the top tap
+uint8_t Calibration_point(uint8_t point)
+{
+    return min(point * CAL_SPACING, X9C_MAX_POS);
+}
+
+// Replace one point of the curve
+void Calibration_set(uint8_t point, uint16_t mv)
+{
+    if (point < CAL_POINTS)
+        cal.mv[point] = mv;
+}
+
+// Write the curve to the config block, a falling curve means a sweep went wrong
+ScriptResult Calibration_save()
+{
+    if (!Calibration_valid(cal.mv))
+        return ScriptCorrupt;
+
+    ScriptResult result = Script_writeConfig(CONFIG_CAL_ADDR, cal.mv, sizeof(cal.mv));
+    if (result == ScriptOk)
+        cal.stored = true;
+    return result;
+}
+
+// Returns true once a measured curve is in use
+bool Calibration_stored()
+{
+    return cal.stored;
+}
+
+// Interpolate between the points either side of the position
+uint16_t Calibration_mv(uint8_t position)
+{
+    if (position >= X9C_MAX_POS)
+        return cal.mv[CAL_POINTS - 1];
+
+    uint8_t i = position / CAL_SPACING;
+    uint8_t offset = position - i * CAL_SPACING;
+    uint8_t span = Calibration_point(i + 1) - Calibration_point(i);
+    return cal.mv[i] + ((uint32_t)(cal.mv[i + 1] - cal.mv[i]) * offset + span / 2) / span;
+}
+
+// Binary search of the curve for the first position at or above the voltage
+uint8_t Calibration_position(uint16_t mv)
+{
+    uint8_t low = 0;
+    uint8_t high = X9C_MAX_POS;
+
+    while (low < high)
+    {
+        uint8_t mid = (low + high) / 2;
+        if (Calibration_mv(mid) < mv)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    // The position below may be nearer
+    if (low > 0 && mv - Calibration_mv(low - 1) < Calibration_mv(low) - mv)
+        low--;
+    return low;
+}
@@ -0,0 +1,54 @@
+/*
+ * Calibration.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Measured voltage at the divider against wiper position. The curve is
+ *  sampled every CAL_SPACING taps, linear in between, and shared by every
+ *  channel. It is stored in the EEPROM config block and, until one has been
+ *  measured, the unloaded divider stands in for it.
+ *
+ *  The X9C is open loop, so the curve is the only way back from a voltage to
+ *  the position the wiper is really at.
+ */
+
+/* Arduino Driver Includes */
+#include <Arduino.h>
+#include <HAL/Script.h>
+
+#ifndef CALIBRATION_H_
+#define CALIBRATION_H_
+
+#define CAL_POINTS 10  // curve points, the last one at X9C_MAX_POS
+#define CAL_SPACING 11 // taps between curve points
+
+struct _Calibration
+{
+    uint16_t mv[CAL_POINTS]; // voltage at each point, never decreasing
+    bool stored;             // false while the ideal curve stands in
+};
+typedef struct _Calibration Calibration;
+
+// Loads the stored curve, or the ideal one for a full scale voltage if none is valid
+void Calibration_begin(uint16_t full_scale_mv);
+
+// Returns the position of a curve point
+uint8_t Calibration_point(uint8_t point);
+
+// Replaces a curve point while a sweep measures the curve
+void Calibration_set(uint8_t point, uint16_t mv);
+
+// Checks the measured curve and starts writing it to EEPROM in the background
+ScriptResult Calibration_save();
+
+// Returns true if the curve in use was measured rather than ideal
+bool Calibration_stored();
+
+// Returns the voltage expected at a position
+uint16_t Calibration_mv(uint8_t position);
+
+// Returns the position whose expected voltage is nearest to a measured one
+uint8_t Calibration_position(uint16_t mv);
+
+#endif /* CALIBRATION_H_ */
@@ -20,18 +20,41 @@
 #define S_R_CHAR '<'        // transmission recieved char
 #define S_E_CHAR '>'        // transmission terminated char
 #define S_D_CHAR '['        // data begin char
+#define S_B_CHAR '{'        // batched data begin char
 #define S_HP_CHAR '!'       // high priority command char
+#define S_H_CHAR '$'        // memory health frame begin char
+#define S_L_CHAR '%'        // loop period histogram begin char
+#define S_Y_CHAR '~'        // clock sync reply begin char
+#define S_T_CHAR '^'        // trigger edge frame begin char
+#define S_X_CHAR '&'        // script report begin char
+#define S_K_CHAR '#'        // marker frame begin char
+#define S_W_CHAR '*'        // wiper desync frame begin char
+#define S_Q_CHAR '?'        // terse response code begin char
+#define S_STOP_CHAR 0x1B    // emergency stop byte (ESC), acted on in the RX interrupt
 
 // Pins for LEDs
 #define LED_PIN 13
 
-// Pins for 100k Potentiometer
+// Number of potentiometer channels fitted, e.g. 2 for throttle and regen brake
+#ifndef POT_CHANNELS
+#define POT_CHANNELS 1
+#endif
+#define POT_CHANNELS_MAX 2 // channels with pins assigned below
+
+// Pins for 100k Potentiometer, channel 0
 #define CS_PIN 4
 #define INC_PIN 3
 #define UD_PIN 2
 
+// Pins for 100k Potentiometer, channel 1
+// INC shares PORTD with channel 0 so both step on the same port write
+#define CS1_PIN 7
+#define INC1_PIN 5
+#define UD1_PIN 6
+
 // Analog measurement macros
-#define POT_MES_PIN A0     // potentiometer voltage monitoring pin
+#define POT_MES_PIN A0     // potentiometer voltage monitoring pin, channel 0
+#define POT1_MES_PIN A1    // potentiometer voltage monitoring pin, channel 1
 #define ADC_MAX 1024       // steps
 #define V_POT_MAX 4.71     // V
 #define ADC_SETTLE_TIME 10 // ms
@@ -0,0 +1,34 @@
+/*
+ * Histogram.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <HAL/Histogram.h>
+
+// Clear the histogram
+void Histogram_reset(Histogram *hist_p)
+{
+    memset(hist_p->bins, 0, sizeof(hist_p->bins));
+    hist_p->max_us = 0;
+}
+
+// Add a value to the histogram
+void Histogram_add(Histogram *hist_p, uint32_t value_us)
+{
+    // Bin index is the position of the highest set bit above the minimum
+    uint8_t bin = 0;
+    uint32_t scaled = value_us >> HISTOGRAM_MIN_SHIFT;
+    while (scaled != 0 && bin < HISTOGRAM_BINS - 1)
+    {
+        scaled >>= 1;
+        bin++;
+    }
+
+    if (hist_p->bins[bin] != UINT16_MAX)
+        hist_p->bins[bin]++;
+
+    if (value_us > hist_p->max_us)
+        hist_p->max_us = value_us;
+}
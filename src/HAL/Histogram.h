@@ -0,0 +1,37 @@
+/*
+ * Histogram.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Log2 binned histogram of durations in microseconds. Bin 0 counts values
+ *  below 64 us, bin i counts values in [2^(i+5), 2^(i+6)) us and the last bin
+ *  also takes everything longer.
+ */
+
+/* Arduino Driver Includes */
+#include <Arduino.h>
+
+#ifndef HISTOGRAM_H_
+#define HISTOGRAM_H_
+
+#define HISTOGRAM_BINS 16      // last bin starts at ~1 s
+#define HISTOGRAM_MIN_SHIFT 6  // bin 0 holds values below 2^6 us
+
+struct _Histogram
+{
+    // Number of values in each bin, saturating at 65535
+    uint16_t bins[HISTOGRAM_BINS];
+
+    // Largest value seen since the last reset
+    uint32_t max_us;
+};
+typedef struct _Histogram Histogram;
+
+// Clears every bin and the maximum
+void Histogram_reset(Histogram *hist_p);
+
+// Counts a value in its bin
+void Histogram_add(Histogram *hist_p, uint32_t value_us);
+
+#endif /* HISTOGRAM_H_ */
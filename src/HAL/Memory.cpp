@@ -0,0 +1,82 @@
+/*
+ * Memory.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <HAL/Memory.h>
+
+// Symbols provided by the avr-libc linker script and malloc
+extern uint8_t _end;
+extern uint8_t __stack;
+extern uint8_t __heap_start;
+extern char *__brkval;
+
+struct __freelist
+{
+    size_t sz;
+    struct __freelist *nx;
+};
+extern struct __freelist *__flp;
+
+/**
+ * Paints everything between the end of .bss and the top of the stack with
+ * MEMORY_CANARY. Runs from .init1, before the stack pointer is used, so it is
+ * written in assembly and must not be called.
+ */
+void Memory_paint(void) __attribute__((naked, used, section(".init1")));
+void Memory_paint(void)
+{
+    __asm volatile("    ldi r30, lo8(_end)\n"
+                   "    ldi r31, hi8(_end)\n"
+                   "    ldi r24, %0\n"
+                   "    ldi r25, hi8(__stack)\n"
+                   "    rjmp 2f\n"
+                   "1:\n"
+                   "    st Z+, r24\n"
+                   "2:\n"
+                   "    cpi r30, lo8(__stack)\n"
+                   "    cpc r31, r25\n"
+                   "    brlo 1b\n"
+                   "    breq 1b\n"
+                   :
+                   : "i"(MEMORY_CANARY));
+}
+
+// Top of the heap, or its start while nothing is allocated
+static uint8_t *Memory_heapEnd()
+{
+    return __brkval != 0 ? (uint8_t *)__brkval : &__heap_start;
+}
+
+// Measure current and worst case RAM usage
+MemoryStats Memory_stats()
+{
+    MemoryStats stats;
+    uint8_t *heap_end_p = Memory_heapEnd();
+    uint8_t stack_top;
+
+    // Walk up from the heap until the first byte the stack has overwritten
+    uint8_t *p = heap_end_p;
+    while (p <= &__stack && *p == MEMORY_CANARY)
+        p++;
+
+    stats.stack_peak = &__stack - p + 1;
+    stats.min_free = p - heap_end_p;
+    stats.free_now = &stack_top - heap_end_p;
+    stats.heap_used = heap_end_p - &__heap_start;
+
+    stats.heap_free_list = 0;
+    for (struct __freelist *fp = __flp; fp != 0; fp = fp->nx)
+        stats.heap_free_list += fp->sz + sizeof(size_t);
+
+    return stats;
+}
+
+// Gap between the heap and this function's stack frame
+uint16_t Memory_freeRam()
+{
+    uint8_t stack_top;
+    return &stack_top - Memory_heapEnd();
+}
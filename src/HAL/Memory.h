@@ -0,0 +1,43 @@
+/*
+ * Memory.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Runtime RAM instrumentation. Free RAM is painted with a canary before
+ *  main() runs, so the deepest stack reach can be found later by scanning for
+ *  the first overwritten byte.
+ */
+
+/* Arduino Driver Includes */
+#include <Arduino.h>
+
+#ifndef MEMORY_H_
+#define MEMORY_H_
+
+#define MEMORY_CANARY 0xC5 // value painted over free RAM at startup
+
+struct _MemoryStats
+{
+    // Largest number of stack bytes ever in use
+    uint16_t stack_peak;
+
+    // Smallest gap there has ever been between the heap and the stack
+    uint16_t min_free;
+
+    // Current gap between the heap and the stack
+    uint16_t free_now;
+
+    // Bytes claimed by the heap, and the part of that sitting on the free list
+    uint16_t heap_used;
+    uint16_t heap_free_list;
+};
+typedef struct _MemoryStats MemoryStats;
+
+// Measures the stack high-water mark, free RAM and heap fragmentation
+MemoryStats Memory_stats();
+
+// Returns the current gap between heap and stack, cheap enough for every frame
+uint16_t Memory_freeRam();
+
+#endif /* MEMORY_H_ */
@@ -0,0 +1,379 @@
+/*
+ * Script.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <HAL/Script.h>
+
+#define SCRIPT_LIST_ADDR 2 // first record, after the signature
+#define SCRIPT_LIST_END CONFIG_EEPROM_ADDR
+#define SCRIPT_END_MARK 0xFF
+
+// Operand flags of an opcode
+#define SCRIPT_HAS_ARG 0x01
+#define SCRIPT_HAS_VALUE 0x02
+#define SCRIPT_HAS_TIME 0x04
+
+/**
+ * Background EEPROM write. An end mark can be written before the copy, so a
+ * record being appended is never followed by stale records, or after it, so
+ * records being moved down are never cut off. Address 0 means no mark.
+ */
+struct _ScriptJob
+{
+    uint16_t mark_first;
+    uint16_t dst;
+    const uint8_t *src_p; // SRAM source, or NULL to copy from EEPROM at src
+    uint16_t src;
+    uint16_t count;
+    uint16_t mark_last;
+};
+typedef struct _ScriptJob ScriptJob;
+
+static ScriptJob job;
+static const uint8_t signature[2] = {'T', 'S'};
+static char boot_name[SCRIPT_NAME_LEN]; // source of a boot name write
+
+static uint8_t Script_readByte(uint16_t addr)
+{
+    return eeprom_read_byte((const uint8_t *)(uintptr_t)addr);
+}
+
+static void Script_startJob(uint16_t mark_first, uint16_t dst, const uint8_t *src_p, uint16_t src,
+                            uint16_t count, uint16_t mark_last)
+{
+    job.mark_first = mark_first;
+    job.dst = dst;
+    job.src_p = src_p;
+    job.src = src;
+    job.count = count;
+    job.mark_last = mark_last;
+}
+
+// Pads or cuts a name to the stored width
+static void Script_packName(const char *name, char *packed)
+{
+    strncpy(packed, name, SCRIPT_NAME_LEN);
+}
+
+/**
+ * Walks the record list. Returns the address of the record named name, or 0
+ * if there is none, and the address just past the last record in *end_p.
+ * A record that would run into the config block ends the list.
+ */
+static uint16_t Script_find(const char *name, uint16_t *end_p)
+{
+    char packed[SCRIPT_NAME_LEN];
+    uint16_t addr = SCRIPT_LIST_ADDR;
+    uint16_t found = 0;
+
+    if (name != NULL)
+        Script_packName(name, packed);
+
+    while (addr + SCRIPT_HEADER_LEN <= SCRIPT_LIST_END)
+    {
+        uint8_t len = Script_readByte(addr);
+        if (len > SCRIPT_STEPS_MAX || addr + SCRIPT_HEADER_LEN + len > SCRIPT_LIST_END)
+            break;
+
+        if (name != NULL && found == 0)
+        {
+            uint8_t i = 0;
+            while (i < SCRIPT_NAME_LEN && Script_readByte(addr + 1 + i) == (uint8_t)packed[i])
+                i++;
+            if (i == SCRIPT_NAME_LEN)
+                found = addr;
+        }
+        addr += SCRIPT_HEADER_LEN + len;
+    }
+
+    *end_p = addr;
+    return found;
+}
+
+// Checksum over the length and the steps
+static uint8_t Script_sum(const Script *script_p)
+{
+    uint8_t sum = script_p->len;
+    for (uint8_t i = 0; i < script_p->len; i++)
+        sum += script_p->steps[i];
+    return sum;
+}
+
+// Write the signature and an empty list if EEPROM holds something else
+void Script_begin()
+{
+    if (Script_readByte(0) == signature[0] && Script_readByte(1) == signature[1])
+        return;
+
+    Script_startJob(SCRIPT_LIST_ADDR, 0, signature, 0, sizeof(signature), 0);
+}
+
+/**
+ * Starts the next byte write of the job. Bytes that already hold the right
+ * value are skipped without a write, which also saves EEPROM wear.
+ */
+void Script_service()
+{
+    while (Script_busy())
+    {
+        if (!eeprom_is_ready())
+            return;
+
+        uint16_t addr;
+        uint8_t value;
+        if (job.mark_first != 0)
+        {
+            addr = job.mark_first;
+            value = SCRIPT_END_MARK;
+            job.mark_first = 0;
+        }
+        else if (job.count != 0)
+        {
+            addr = job.dst++;
+            value = job.src_p != NULL ? *job.src_p++ : Script_readByte(job.src++);
+            job.count--;
+        }
+        else
+        {
+            addr = job.mark_last;
+            value = SCRIPT_END_MARK;
+            job.mark_last = 0;
+        }
+
+        if (Script_readByte(addr) != value)
+        {
+            eeprom_write_byte((uint8_t *)(uintptr_t)addr, value);
+            return;
+        }
+    }
+}
+
+bool Script_busy()
+{
+    return job.mark_first != 0 || job.count != 0 || job.mark_last != 0;
+}
+
+// Empty the script and set its name
+void Script_clear(Script *script_p, const char *name)
+{
+    script_p->len = 0;
+    Script_packName(name, script_p->name);
+    script_p->sum = 0;
+}
+
+// Operands that follow each opcode, or 0 for an unknown opcode
+static uint8_t Script_operands(uint8_t op)
+{
+    switch (op)
+    {
+    case SCRIPT_RAMP:
+        return SCRIPT_HAS_ARG | SCRIPT_HAS_TIME;
+    case SCRIPT_WAIT:
+        return SCRIPT_HAS_TIME;
+    case SCRIPT_SET:
+    case SCRIPT_STEP:
+    case SCRIPT_CHANNELS:
+        return SCRIPT_HAS_ARG;
+    case SCRIPT_LOOP:
+    case SCRIPT_NEXT:
+        return SCRIPT_HAS_ARG | SCRIPT_HAS_VALUE;
+    case SCRIPT_WAIT_V:
+        return SCRIPT_HAS_VALUE | SCRIPT_HAS_TIME;
+    case SCRIPT_MARK:
+        return SCRIPT_HAS_VALUE;
+    default:
+        return 0;
+    }
+}
+
+// Bytes a step takes, opcode included
+static uint8_t Script_stepSize(uint8_t operands)
+{
+    return 1 + ((operands & SCRIPT_HAS_ARG) ? 1 : 0) + ((operands & SCRIPT_HAS_VALUE) ? 2 : 0) +
+           ((operands & SCRIPT_HAS_TIME) ? 3 : 0);
+}
+
+// Encode a step at the end of the script
+bool Script_append(Script *script_p, const ScriptStep *step_p)
+{
+    uint8_t operands = Script_operands(step_p->op);
+    uint8_t size = Script_stepSize(operands);
+
+    if (operands == 0 || script_p->len + size > SCRIPT_STEPS_MAX)
+        return false;
+
+    uint8_t *p = &script_p->steps[script_p->len];
+    *p++ = step_p->op;
+    if (operands & SCRIPT_HAS_ARG)
+        *p++ = step_p->arg;
+    if (operands & SCRIPT_HAS_VALUE)
+    {
+        *p++ = step_p->value;
+        *p++ = step_p->value >> 8;
+    }
+    if (operands & SCRIPT_HAS_TIME)
+    {
+        *p++ = step_p->time_ms;
+        *p++ = step_p->time_ms >> 8;
+        *p++ = step_p->time_ms >> 16;
+    }
+
+    script_p->len += size;
+    return true;
+}
+
+// Decode the step at the program counter
+bool Script_decode(const Script *script_p, uint8_t *pc_p, ScriptStep *step_p)
+{
+    const uint8_t *p = &script_p->steps[*pc_p];
+
+    if (*pc_p >= script_p->len)
+        return false;
+
+    step_p->op = *p++;
+    step_p->arg = 0;
+    step_p->value = 0;
+    step_p->time_ms = 0;
+
+    uint8_t operands = Script_operands(step_p->op);
+    if (operands == 0 || *pc_p + Script_stepSize(operands) > script_p->len)
+        return false;
+
+    if (operands & SCRIPT_HAS_ARG)
+        step_p->arg = *p++;
+    if (operands & SCRIPT_HAS_VALUE)
+    {
+        step_p->value = p[0] | (p[1] << 8);
+        p += 2;
+    }
+    if (operands & SCRIPT_HAS_TIME)
+    {
+        step_p->time_ms = p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+        p += 3;
+    }
+
+    *pc_p = p - script_p->steps;
+    return true;
+}
+
+// Append the script to the list in the background
+ScriptResult Script_save(Script *script_p)
+{
+    uint16_t end;
+
+    if (Script_busy())
+        return ScriptBusy;
+    if (Script_find(script_p->name, &end) != 0)
+        return ScriptExists;
+
+    uint16_t size = SCRIPT_HEADER_LEN + script_p->len;
+    if (end + size > SCRIPT_LIST_END)
+        return ScriptFull;
+
+    script_p->sum = Script_sum(script_p);
+    uint16_t mark = end + size < SCRIPT_LIST_END ? end + size : 0;
+    Script_startJob(mark, end, (const uint8_t *)script_p, 0, size, 0);
+    return ScriptOk;
+}
+
+// Copy a script into SRAM
+ScriptResult Script_load(Script *script_p, const char *name)
+{
+    uint16_t end;
+
+    if (Script_busy())
+        return ScriptBusy;
+
+    uint16_t addr = Script_find(name, &end);
+    if (addr == 0)
+        return ScriptNotFound;
+
+    uint8_t len = Script_readByte(addr);
+    eeprom_read_block(script_p, (const void *)(uintptr_t)addr, SCRIPT_HEADER_LEN + len);
+    if (script_p->sum != Script_sum(script_p))
+        return ScriptCorrupt;
+    return ScriptOk;
+}
+
+// Move the records after the script down over it in the background
+ScriptResult Script_delete(const char *name)
+{
+    uint16_t end;
+
+    if (Script_busy())
+        return ScriptBusy;
+
+    uint16_t addr = Script_find(name, &end);
+    if (addr == 0)
+        return ScriptNotFound;
+
+    uint16_t next = addr + SCRIPT_HEADER_LEN + Script_readByte(addr);
+    Script_startJob(0, addr, NULL, next, end - next, addr + (end - next));
+    return ScriptOk;
+}
+
+// Name and length of the index-th record
+bool Script_entry(uint8_t index, char *name, uint8_t *len_p)
+{
+    uint16_t addr = SCRIPT_LIST_ADDR;
+    uint16_t end;
+
+    Script_find(NULL, &end);
+    for (uint8_t i = 0; addr < end; i++)
+    {
+        if (i == index)
+        {
+            *len_p = Script_readByte(addr);
+            eeprom_read_block(name, (const void *)(uintptr_t)(addr + 1), SCRIPT_NAME_LEN);
+            name[SCRIPT_NAME_LEN] = '\0';
+            return true;
+        }
+        addr += SCRIPT_HEADER_LEN + Script_readByte(addr);
+    }
+    return false;
+}
+
+uint16_t Script_free()
+{
+    uint16_t end;
+    Script_find(NULL, &end);
+    return SCRIPT_LIST_END - end;
+}
+
+// Write the boot script name into the config block in the background
+ScriptResult Script_setBoot(const char *name)
+{
+    uint16_t end;
+
+    if (Script_busy())
+        return ScriptBusy;
+    if (name[0] != '\0' && Script_find(name, &end) == 0)
+        return ScriptNotFound;
+
+    Script_packName(name, boot_name);
+    Script_startJob(0, CONFIG_BOOT_ADDR, (const uint8_t *)boot_name, 0, SCRIPT_NAME_LEN, 0);
+    return ScriptOk;
+}
+
+// Read the boot script name, erased EEPROM reads as 0xFF
+bool Script_bootName(char *name)
+{
+    eeprom_read_block(name, (const void *)(uintptr_t)CONFIG_BOOT_ADDR, SCRIPT_NAME_LEN);
+    name[SCRIPT_NAME_LEN] = '\0';
+    return name[0] != '\0' && (uint8_t)name[0] != 0xFF;
+}
+
+// Write settings into the config block in the background, never past its end
+ScriptResult Script_writeConfig(uint16_t addr, const void *src_p, uint8_t len)
+{
+    if (Script_busy())
+        return ScriptBusy;
+    if (addr < CONFIG_EEPROM_ADDR || addr + len > E2END + 1)
+        return ScriptFull;
+
+    Script_startJob(0, addr, (const uint8_t *)src_p, 0, len, 0);
+    return ScriptOk;
+}
@@ -0,0 +1,125 @@
+/*
+ * Script.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Named throttle scripts in EEPROM. A script is bytecode for a small VM,
+ *  compiled from command lines, run from a copy in SRAM so EEPROM is never
+ *  read mid-run. Each step is an opcode followed by the operands it uses, an
+ *  8 bit argument, a 16 bit value and a 24 bit time, in that order.
+ *
+ *  Loops need no stack. A loop's nesting depth is fixed when it is compiled,
+ *  so its LOOP and NEXT steps name a counter slot of their own.
+ *
+ *  EEPROM holds a 2 byte signature, then the records back to back up to the
+ *  config block in the top 32 bytes. A record is the first bytes of the
+ *  Script struct, header then steps, and a length byte of 0xFF ends the list.
+ *
+ *  An EEPROM byte takes 3.4 ms to write, so saves, deletes and config writes
+ *  run in the background one byte at a time from Script_service().
+ */
+
+/* Arduino Driver Includes */
+#include <Arduino.h>
+#include <avr/eeprom.h>
+
+#ifndef SCRIPT_H_
+#define SCRIPT_H_
+
+#define SCRIPT_NAME_LEN 8    // chars, shorter names are padded with '\0'
+#define SCRIPT_STEPS_MAX 240 // bytes of steps per script, the size of the SRAM copy
+#define SCRIPT_LOOP_DEPTH 4  // loop nesting levels, one counter slot each
+#define SCRIPT_TIME_MAX 0xFFFFFFUL // ms, longest ramp or wait a step can hold
+#define CONFIG_EEPROM_SIZE 32 // bytes at the top of EEPROM kept for settings
+#define CONFIG_EEPROM_ADDR (E2END + 1 - CONFIG_EEPROM_SIZE)
+#define CONFIG_BOOT_ADDR CONFIG_EEPROM_ADDR                    // boot script name
+#define CONFIG_CAL_ADDR (CONFIG_BOOT_ADDR + SCRIPT_NAME_LEN)    // wiper calibration, see Calibration.h
+#define CONFIG_CAL_LEN 20                                       // bytes, CAL_POINTS values of 16 bits
+#define CONFIG_RECALL_ADDR (CONFIG_CAL_ADDR + CONFIG_CAL_LEN)   // wiper recall mode and stored positions
+
+// Step opcodes and their operands
+#define SCRIPT_RAMP 't'     // position, 24 bit time in ms
+#define SCRIPT_SET 'p'      // position
+#define SCRIPT_STEP 's'     // signed step count
+#define SCRIPT_WAIT 'w'     // 24 bit time in ms
+#define SCRIPT_CHANNELS 'c' // channel mask
+#define SCRIPT_LOOP 'l'     // counter slot, repeat count
+#define SCRIPT_NEXT 'n'     // counter slot, offset of the first step of the loop body
+#define SCRIPT_WAIT_V 'v'   // voltage in mV, 24 bit timeout in ms, 0 waits forever
+#define SCRIPT_MARK 'k'     // marker number
+
+typedef enum
+{
+    ScriptOk,
+    ScriptBusy,     // a background EEPROM write is still running
+    ScriptFull,     // no room left in the script or in EEPROM
+    ScriptNotFound,
+    ScriptExists,
+    ScriptCorrupt   // checksum mismatch, the record was not fully written
+} ScriptResult;
+
+struct _ScriptStep
+{
+    uint8_t op;
+    int8_t arg;     // position, step count, channel mask or counter slot
+    uint16_t value; // repeat count, jump offset, voltage or marker number
+    uint32_t time_ms;
+};
+typedef struct _ScriptStep ScriptStep;
+
+// Record layout in EEPROM, the header fields must stay first and in order
+struct _Script
+{
+    uint8_t len;                  // bytes of steps
+    char name[SCRIPT_NAME_LEN];   // not terminated when SCRIPT_NAME_LEN long
+    uint8_t sum;                  // checksum of len and steps
+    uint8_t steps[SCRIPT_STEPS_MAX];
+};
+typedef struct _Script Script;
+
+#define SCRIPT_HEADER_LEN (sizeof(Script) - SCRIPT_STEPS_MAX)
+
+// Formats EEPROM in the background if it does not hold a script list yet
+void Script_begin();
+
+// Writes the next byte of a background job, call every loop pass
+void Script_service();
+
+// Returns true while a background write is running
+bool Script_busy();
+
+// Empties a script and names it, names longer than SCRIPT_NAME_LEN are cut
+void Script_clear(Script *script_p, const char *name);
+
+// Appends a step. Returns false if it does not fit
+bool Script_append(Script *script_p, const ScriptStep *step_p);
+
+// Decodes the step at *pc_p and advances it. Returns false at the end
+bool Script_decode(const Script *script_p, uint8_t *pc_p, ScriptStep *step_p);
+
+// Starts writing a script to EEPROM. The script must not change until Script_busy() is false
+ScriptResult Script_save(Script *script_p);
+
+// Copies a script from EEPROM into SRAM and checks it
+ScriptResult Script_load(Script *script_p, const char *name);
+
+// Starts removing a script, later records move down to close the gap
+ScriptResult Script_delete(const char *name);
+
+// Copies the terminated name and length of the index-th script. Returns false past the last one
+bool Script_entry(uint8_t index, char *name, uint8_t *len_p);
+
+// Bytes of EEPROM left for scripts
+uint16_t Script_free();
+
+// Starts writing the name of the script to run at boot, an empty name clears it
+ScriptResult Script_setBoot(const char *name);
+
+// Copies the boot script name, terminated, into SCRIPT_NAME_LEN + 1 chars. Returns false if none is set
+bool Script_bootName(char *name);
+
+// Starts writing bytes into the config block. They must not change until Script_busy() is false
+ScriptResult Script_writeConfig(uint16_t addr, const void *src_p, uint8_t len);
+
+#endif /* SCRIPT_H_ */
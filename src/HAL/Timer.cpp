@@ -5,7 +5,11 @@
  *      Author: Colton Tshudy
  */
 
-#include <HAL\Timer.h>
+#include <HAL/Timer.h>
+
+#ifdef DYNO_SIM
+#include <HAL/sim/Sim.h>
+#endif
 
 // Construct a new timer with a wait time in milliseconds
 SWTimer SWTimer_construct(uint64_t waitTime)
@@ -35,6 +39,13 @@ uint64_t SWTimer_elapsedTimeMS(SWTimer *timer_p)
 bool SWTimer_expired(SWTimer *timer_p)
 {
     uint64_t elapsed_ms = SWTimer_elapsedTimeMS(timer_p);
+
+#ifdef DYNO_SIM
+    // Lets the simulator's virtual clock jump straight to the deadline
+    if (elapsed_ms < timer_p->waitTime_ms)
+        Sim_wakeAtMs(timer_p->startCounter + timer_p->waitTime_ms);
+#endif
+
     return elapsed_ms >= timer_p->waitTime_ms;
 }
 
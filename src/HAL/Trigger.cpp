@@ -0,0 +1,76 @@
+/*
+ * Trigger.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <HAL/Trigger.h>
+#include <util/atomic.h>
+
+#define TRIGGER_TICKS_PER_US 2 // Timer1 runs at 16 MHz / 8
+
+// Ring buffer, head is written by the capture interrupt and tail by the main loop
+static volatile TriggerEvent queue[TRIGGER_QUEUE_SIZE];
+static volatile uint8_t head = 0;
+static volatile uint8_t tail = 0;
+static volatile uint16_t seq = 0;
+
+/**
+ * Converts the capture to micros() time. Timer1 has kept counting since the
+ * edge, so the ticks elapsed are taken off the current time. The result
+ * carries the 4 us resolution of micros(). A capture left waiting more than
+ * 32 ms, one Timer1 period, would alias, but nothing holds interrupts off
+ * that long.
+ */
+ISR(TIMER1_CAPT_vect)
+{
+    uint16_t elapsed = TCNT1 - ICR1;
+    unsigned long now_us = micros();
+
+    seq++;
+    uint8_t next = (head + 1) & (TRIGGER_QUEUE_SIZE - 1);
+    if (next == tail) // drop the edge if the queue is full
+        return;
+
+    queue[head].us = now_us - elapsed / TRIGGER_TICKS_PER_US;
+    queue[head].seq = seq;
+    head = next;
+}
+
+// Configure Timer1 for input capture on the selected edge
+void Trigger_begin(uint8_t edge)
+{
+    pinMode(TRIGGER_PIN, INPUT);
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        TIMSK1 &= ~_BV(ICIE1);
+        if (edge == TRIGGER_OFF)
+            return;
+
+        // Normal mode at clk/8. The noise canceler needs 4 equal samples
+        // before a capture, which delays it 0.25 us and rejects glitches
+        TCCR1A = 0;
+        TCCR1B = _BV(ICNC1) | _BV(CS11) | (edge == TRIGGER_RISING ? _BV(ICES1) : 0);
+
+        // Changing the edge can raise the capture flag, clear it by writing 1
+        TIFR1 = _BV(ICF1);
+        TIMSK1 |= _BV(ICIE1);
+    }
+}
+
+// Take the oldest edge off the queue
+bool Trigger_read(TriggerEvent *event_p)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (head == tail)
+            return false;
+
+        event_p->us = queue[tail].us;
+        event_p->seq = queue[tail].seq;
+        tail = (tail + 1) & (TRIGGER_QUEUE_SIZE - 1);
+    }
+    return true;
+}
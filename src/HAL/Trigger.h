@@ -0,0 +1,46 @@
+/*
+ * Trigger.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  External trigger input on ICP1 (D8), timestamped by Timer1 input capture.
+ *  The capture unit latches the timer on the edge itself, so the timestamp
+ *  does not depend on interrupt latency. Edges are queued with a sequence
+ *  number for the main loop to report, and a gap in the sequence shows the
+ *  host that the queue overflowed.
+ *
+ *  Timer1 is taken over, so analogWrite on D9 and D10 is not available.
+ */
+
+/* Arduino Driver Includes */
+#include <Arduino.h>
+
+#ifndef TRIGGER_H_
+#define TRIGGER_H_
+
+#define TRIGGER_PIN 8        // ICP1, the only pin Timer1 captures on
+#define TRIGGER_QUEUE_SIZE 8 // edges, must be a power of two
+
+// Edge selection for Trigger_begin
+#define TRIGGER_OFF 0
+#define TRIGGER_RISING 1
+#define TRIGGER_FALLING 2
+
+struct _TriggerEvent
+{
+    // micros() time of the edge
+    unsigned long us;
+
+    // Edges captured since boot, counting the ones dropped from a full queue
+    uint16_t seq;
+};
+typedef struct _TriggerEvent TriggerEvent;
+
+// Starts capturing the given edge, or stops capturing with TRIGGER_OFF
+void Trigger_begin(uint8_t edge);
+
+// Takes the oldest captured edge off the queue. Returns false if there is none
+bool Trigger_read(TriggerEvent *event_p);
+
+#endif /* TRIGGER_H_ */
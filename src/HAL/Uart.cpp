@@ -0,0 +1,156 @@
+/*
+ * Uart.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <HAL/Uart.h>
+#include <util/atomic.h>
+
+UartPort Uart;
+
+// Ring buffers, head is written by the producer and tail by the consumer
+static volatile uint8_t rx_buffer[UART_RX_BUFFER_SIZE];
+static volatile uint8_t rx_head = 0;
+static volatile uint8_t rx_tail = 0;
+static volatile uint8_t tx_buffer[UART_TX_BUFFER_SIZE];
+static volatile uint8_t tx_head = 0;
+static volatile uint8_t tx_tail = 0;
+static bool tx_written = false; // flush() has nothing to wait for until the first write
+
+// Stop byte and the handler run when it arrives
+static volatile uint8_t stop_byte = 0;
+static void (*volatile stop_handler)(void) = NULL;
+
+// Arrival times of the line ends in the RX buffer, taken as close to the wire
+// as possible, and of the last one read
+static volatile unsigned long line_times_us[UART_LINE_TIMES];
+static volatile uint8_t line_head = 0;
+static uint8_t line_tail = 0;
+static unsigned long line_time_us = 0;
+
+// Received byte, either handled as a stop or queued for read()
+ISR(USART_RX_vect)
+{
+    bool frame_error = UCSR0A & _BV(FE0);
+    uint8_t c = UDR0;
+
+    if (frame_error)
+        return;
+
+    if (stop_handler != NULL && c == stop_byte)
+    {
+        stop_handler();
+        return;
+    }
+
+    uint8_t next = (rx_head + 1) & (UART_RX_BUFFER_SIZE - 1);
+    if (next != rx_tail) // drop the byte if the buffer is full
+    {
+        rx_buffer[rx_head] = c;
+        rx_head = next;
+
+        if (c == '\n' || c == '\r')
+        {
+            line_times_us[line_head & (UART_LINE_TIMES - 1)] = micros();
+            line_head++;
+        }
+    }
+}
+
+// Data register empty, send the next queued byte
+static void Uart_txNext()
+{
+    UDR0 = tx_buffer[tx_tail];
+    tx_tail = (tx_tail + 1) & (UART_TX_BUFFER_SIZE - 1);
+
+    if (tx_head == tx_tail)
+        UCSR0B &= ~_BV(UDRIE0);
+}
+
+ISR(USART_UDRE_vect)
+{
+    Uart_txNext();
+}
+
+void UartPort::begin(unsigned long baud)
+{
+    // Double speed mode, matching the Arduino core's baud rate error
+    uint16_t setting = (F_CPU / 4 / baud - 1) / 2;
+    UCSR0A = _BV(U2X0);
+    UBRR0H = setting >> 8;
+    UBRR0L = setting;
+
+    UCSR0C = _BV(UCSZ01) | _BV(UCSZ00); // 8 data bits, no parity, 1 stop bit
+    UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+}
+
+int UartPort::available()
+{
+    return (rx_head - rx_tail) & (UART_RX_BUFFER_SIZE - 1);
+}
+
+int UartPort::read()
+{
+    if (rx_head == rx_tail)
+        return -1;
+
+    uint8_t c = rx_buffer[rx_tail];
+    if (c == '\n' || c == '\r')
+    {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            line_time_us = line_times_us[line_tail & (UART_LINE_TIMES - 1)];
+        }
+        line_tail++;
+    }
+    rx_tail = (rx_tail + 1) & (UART_RX_BUFFER_SIZE - 1);
+    return c;
+}
+
+size_t UartPort::write(uint8_t c)
+{
+    uint8_t next = (tx_head + 1) & (UART_TX_BUFFER_SIZE - 1);
+
+    // Buffer full. With interrupts off the UDRE interrupt never runs, so
+    // drain the buffer by polling instead of waiting forever
+    while (next == tx_tail)
+    {
+        if (!(SREG & _BV(SREG_I)) && (UCSR0A & _BV(UDRE0)))
+            Uart_txNext();
+    }
+
+    tx_buffer[tx_head] = c;
+    tx_written = true;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        tx_head = next;
+        UCSR0A = _BV(U2X0) | _BV(TXC0); // clear transmit complete for flush()
+        UCSR0B |= _BV(UDRIE0);
+    }
+    return 1;
+}
+
+void UartPort::flush()
+{
+    if (!tx_written)
+        return;
+
+    while ((UCSR0B & _BV(UDRIE0)) || !(UCSR0A & _BV(TXC0)))
+        ;
+}
+
+unsigned long UartPort::lineTime()
+{
+    return line_time_us;
+}
+
+void UartPort::onStop(uint8_t stop_char, void (*handler)(void))
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        stop_byte = stop_char;
+        stop_handler = handler;
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * Uart.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Interrupt driven driver for USART0, used in place of the Arduino Serial
+ *  object so the receive interrupt is ours. A stop byte registered with
+ *  onStop() is acted on inside the interrupt and never reaches the RX buffer.
+ */
+
+/* Arduino Driver Includes */
+#include <Arduino.h>
+#include <Print.h>
+
+#ifndef UART_H_
+#define UART_H_
+
+#define UART_RX_BUFFER_SIZE 64 // bytes, must be a power of two
+#define UART_TX_BUFFER_SIZE 64 // bytes, must be a power of two
+#define UART_LINE_TIMES 8       // line end times kept for unread lines, must be a power of two
+
+class UartPort : public Print
+{
+public:
+    // Starts the port in 8N1 with receive interrupts enabled
+    void begin(unsigned long baud);
+
+    // Number of received bytes waiting in the RX buffer
+    int available();
+
+    // Returns the next received byte, or -1 if there is none
+    int read();
+
+    // Queues a byte for transmission, blocking while the TX buffer is full
+    virtual size_t write(uint8_t c);
+    using Print::write;
+
+    // Blocks until every queued byte has left the shift register
+    void flush();
+
+    // Calls handler from the RX interrupt whenever stop_char is received
+    void onStop(uint8_t stop_char, void (*handler)(void));
+
+    // micros() at which the CR or LF last returned by read() was received. With
+    // more than UART_LINE_TIMES line ends unread, the older ones read the time
+    // of a later one
+    unsigned long lineTime();
+};
+
+extern UartPort Uart;
+
+#endif /* UART_H_ */
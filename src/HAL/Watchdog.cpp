@@ -0,0 +1,64 @@
+/*
+ * Watchdog.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <HAL/Watchdog.h>
+
+// Not cleared by the C runtime, so these keep their value across a reset
+static uint8_t reset_cause __attribute__((section(".noinit")));
+static uint8_t stage __attribute__((section(".noinit")));
+static uint8_t last_stage __attribute__((section(".noinit")));
+
+/**
+ * Saves the reset cause and stage, then stops the watchdog before the
+ * constructors and setup() run. After a watchdog reset the watchdog is still
+ * running with its shortest timeout. Runs from .init3 and must not be called.
+ */
+void Watchdog_init(void) __attribute__((naked, used, section(".init3")));
+void Watchdog_init(void)
+{
+    // Optiboot clears MCUSR but hands its value over in r2
+    uint8_t bootloader_mcusr;
+    __asm volatile("mov %0, r2" : "=r"(bootloader_mcusr));
+
+    reset_cause = MCUSR != 0 ? MCUSR : bootloader_mcusr;
+    MCUSR = 0;
+    wdt_disable();
+
+    // A power on reset leaves .noinit holding garbage
+    last_stage = (reset_cause & _BV(PORF)) ? 0 : stage;
+    stage = 0;
+}
+
+// Arm the watchdog
+void Watchdog_begin(uint8_t timeout)
+{
+    wdt_enable(timeout);
+}
+
+// Restart the watchdog timeout
+void Watchdog_kick()
+{
+    wdt_reset();
+}
+
+// Record the running stage
+void Watchdog_stage(uint8_t new_stage)
+{
+    stage = new_stage;
+}
+
+// Reset flags of the last reset
+uint8_t Watchdog_resetCause()
+{
+    return reset_cause;
+}
+
+// Stage running when the last reset happened
+uint8_t Watchdog_lastStage()
+{
+    return last_stage;
+}
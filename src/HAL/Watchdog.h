@@ -0,0 +1,38 @@
+/*
+ * Watchdog.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  AVR hardware watchdog with a loop stage marker. The reset cause and the
+ *  stage the loop was in when the MCU reset are kept in .noinit RAM, so they
+ *  survive a watchdog reset and can be reported at startup.
+ *
+ *  The bootloader must disable the watchdog after a watchdog reset. Optiboot
+ *  (nanoatmega328new) does. The old Nano bootloader does not and will keep
+ *  resetting until power is cycled.
+ */
+
+/* Arduino Driver Includes */
+#include <Arduino.h>
+#include <avr/wdt.h>
+
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+// Arms the watchdog with one of the WDTO_* timeouts from avr/wdt.h
+void Watchdog_begin(uint8_t timeout);
+
+// Restarts the watchdog timeout
+void Watchdog_kick();
+
+// Records which part of the loop is running
+void Watchdog_stage(uint8_t stage);
+
+// MCUSR flags of the last reset (PORF, EXTRF, BORF, WDRF)
+uint8_t Watchdog_resetCause();
+
+// Stage that was recorded when the last reset happened
+uint8_t Watchdog_lastStage();
+
+#endif /* WATCHDOG_H_ */
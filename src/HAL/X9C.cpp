@@ -0,0 +1,361 @@
+/*
+ * X9C.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <HAL/X9C.h>
+#include <util/atomic.h>
+
+#ifdef DYNO_SIM
+#include <HAL/sim/Sim.h>
+#endif
+
+#define X9C_MAX_PORTS 3 // INC pins of a group span at most this many ports
+
+// Set by X9C_halt, blocks every other wiper movement until X9C_release
+static volatile bool halted = false;
+
+// A store cycle is running since store_us, the chips ignore INC until it ends
+static volatile bool storing = false;
+static volatile unsigned long store_us = 0;
+
+// Set by X9C_halt when it found a store cycle running, X9C_finishHalt drives to 0
+static volatile bool halt_pending = false;
+
+/**
+ * Waits out a store cycle still in progress. Can run with interrupts off, so
+ * the time left is read once and then spent in delayMicroseconds.
+ */
+static void X9C_waitStore()
+{
+    if (!storing)
+        return;
+
+    unsigned long elapsed = micros() - store_us;
+    if (elapsed < X9C_STORE_US)
+    {
+        unsigned long left = X9C_STORE_US - elapsed;
+        while (left > 0)
+        {
+            uint16_t wait = min(left, 1000UL);
+            delayMicroseconds(wait);
+            left -= wait;
+        }
+    }
+    storing = false;
+}
+
+// An INC port register and the INC pins of the group that live on it
+struct _X9CPort
+{
+    volatile uint8_t *out_p;
+    uint8_t mask;
+};
+typedef struct _X9CPort X9CPort;
+
+/**
+ * Pulses INC on every selected chip and updates the tracked positions. Chips
+ * are selected by a non-zero direction. INC pins sharing a port are toggled
+ * with one write, so the whole group moves together.
+ *
+ * Setup and each pulse run with interrupts off and check the halt latch, so
+ * a halt from an interrupt can never be followed by a stray step.
+ *
+ * @param pots:    Group of potentiometers
+ * @param dir:     Direction for each pot, -1, 0 or +1
+ * @param count:   Number of pots in the group
+ * @param pulses:  Number of INC pulses to send
+ * @param halting: True when called by X9C_halt, ignores the halt latch
+ */
+static void X9C_pulseGroup(X9C *pots, const int8_t *dir, uint8_t count, uint8_t pulses, bool halting)
+{
+    X9CPort ports[X9C_MAX_PORTS];
+    uint8_t port_count = 0;
+    uint8_t sent = 0;
+
+    // X9C_halt never gets here during a store cycle, so this wait never runs in an interrupt
+    X9C_waitStore();
+
+    // Set direction, select the chips and gather INC masks per port
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (halted && !halting)
+            return;
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            if (dir[i] == 0)
+                continue;
+
+            digitalWrite(pots[i].inc_pin, HIGH);
+            digitalWrite(pots[i].ud_pin, dir[i] > 0 ? HIGH : LOW);
+            digitalWrite(pots[i].cs_pin, LOW);
+
+            volatile uint8_t *out_p = portOutputRegister(digitalPinToPort(pots[i].inc_pin));
+            uint8_t p = 0;
+            while (p < port_count && ports[p].out_p != out_p)
+                p++;
+            if (p == port_count)
+            {
+                if (port_count == X9C_MAX_PORTS)
+                    continue;
+                ports[p].out_p = out_p;
+                ports[p].mask = 0;
+                port_count++;
+            }
+            ports[p].mask |= digitalPinToBitMask(pots[i].inc_pin);
+        }
+    }
+
+    if (port_count == 0)
+        return;
+
+    delayMicroseconds(1); // CS to INC setup
+
+    // The wiper moves on the falling edge of INC
+    while (sent < pulses)
+    {
+        bool stop = false;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+        {
+            if (halted && !halting)
+                stop = true;
+            else
+            {
+                for (uint8_t p = 0; p < port_count; p++)
+                    *ports[p].out_p |= ports[p].mask;
+                delayMicroseconds(1); // INC high period
+                for (uint8_t p = 0; p < port_count; p++)
+                    *ports[p].out_p &= ~ports[p].mask;
+            }
+        }
+        if (stop)
+            break;
+        sent++;
+        delayMicroseconds(1); // INC low period
+    }
+
+    // Deselect while INC is low so the position is not stored, then idle INC high
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (dir[i] == 0)
+            continue;
+        digitalWrite(pots[i].cs_pin, HIGH);
+        digitalWrite(pots[i].inc_pin, HIGH);
+    }
+
+    // A halt that interrupted us has already zeroed the tracked positions
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (halted && !halting)
+            return;
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            int16_t position = pots[i].position + dir[i] * (int16_t)sent;
+            pots[i].position = constrain(position, 0, X9C_MAX_POS);
+        }
+    }
+}
+
+// Construct a new potentiometer on the given pins
+X9C X9C_construct(uint8_t cs_pin, uint8_t inc_pin, uint8_t ud_pin, uint32_t max_ohms)
+{
+    X9C pot;
+
+    pot.cs_pin = cs_pin;
+    pot.inc_pin = inc_pin;
+    pot.ud_pin = ud_pin;
+    pot.max_ohms = max_ohms;
+    pot.position = 0;
+
+    return pot;
+}
+
+// Configure the pins with the chip deselected. The idle levels are set before
+// the pins drive, so no edge at boot can move the recalled wiper
+void X9C_begin(X9C *pot_p)
+{
+    digitalWrite(pot_p->cs_pin, HIGH);
+    digitalWrite(pot_p->inc_pin, HIGH);
+
+    pinMode(pot_p->cs_pin, OUTPUT);
+    pinMode(pot_p->inc_pin, OUTPUT);
+    pinMode(pot_p->ud_pin, OUTPUT);
+}
+
+// Move the wiper to a position
+void X9C_setPosition(X9C *pot_p, uint8_t position, bool forced)
+{
+    if (position > X9C_MAX_POS)
+        position = X9C_MAX_POS;
+
+    int8_t dir;
+
+    // Drive into the bottom end stop so the tracked position is known
+    if (forced)
+    {
+        dir = -1;
+        X9C_pulseGroup(pot_p, &dir, 1, X9C_MAX_POS, false);
+    }
+
+    if (position == pot_p->position)
+        return;
+
+    dir = position > pot_p->position ? 1 : -1;
+    uint8_t pulses = dir > 0 ? position - pot_p->position : pot_p->position - position;
+    X9C_pulseGroup(pot_p, &dir, 1, pulses, false);
+}
+
+// Returns the tracked wiper position
+uint8_t X9C_getPosition(X9C *pot_p)
+{
+    return pot_p->position;
+}
+
+// Correct the tracked position. A halt has zeroed the wiper and wins over a measurement
+void X9C_resync(X9C *pot_p, uint8_t position)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (!halted)
+            pot_p->position = min(position, (uint8_t)X9C_MAX_POS);
+    }
+}
+
+// Select the chip with INC high and deselect it again, CS rising with INC high stores
+void X9C_store(X9C *pot_p)
+{
+    // Waits with interrupts on, a store cycle is long enough to lose a stop byte
+    X9C_waitStore();
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (halted)
+            return;
+
+        digitalWrite(pot_p->inc_pin, HIGH);
+        digitalWrite(pot_p->cs_pin, LOW);
+        delayMicroseconds(1); // CS to INC setup
+        digitalWrite(pot_p->cs_pin, HIGH);
+        store_us = micros();
+        storing = true;
+    }
+}
+
+// True while a store cycle runs and the chips ignore INC
+bool X9C_storeBusy()
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (storing && micros() - store_us >= X9C_STORE_US)
+            storing = false;
+    }
+
+#ifdef DYNO_SIM
+    // Lets the simulator's virtual clock jump straight to the end of the cycle
+    if (storing)
+        Sim_wakeAtUs(store_us + X9C_STORE_US);
+#endif
+
+    return storing;
+}
+
+// Returns the tracked wiper resistance, rounded to the nearest ohm
+uint32_t X9C_getOhms(X9C *pot_p)
+{
+    return X9C_positionToOhms(pot_p, pot_p->position);
+}
+
+// Returns the wiper resistance at a position, rounded to the nearest ohm
+uint32_t X9C_positionToOhms(X9C *pot_p, uint8_t position)
+{
+    return (position * pot_p->max_ohms + X9C_MAX_POS / 2) / X9C_MAX_POS;
+}
+
+// Step a group of pots by one tap each, clamping at the end stops
+void X9C_stepGroup(X9C *pots, const int8_t *dir, uint8_t count)
+{
+    int8_t clamped[X9C_MAX_GROUP];
+
+    if (count > X9C_MAX_GROUP)
+        count = X9C_MAX_GROUP;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        clamped[i] = dir[i];
+        if ((dir[i] > 0 && pots[i].position >= X9C_MAX_POS) || (dir[i] < 0 && pots[i].position == 0))
+            clamped[i] = 0;
+    }
+
+    X9C_pulseGroup(pots, clamped, count, 1, false);
+}
+
+// Full travel to 0 of every pot, so the result does not depend on the tracked position
+static void X9C_haltTravel(X9C *pots, uint8_t count)
+{
+    int8_t dir[X9C_MAX_GROUP];
+
+    if (count > X9C_MAX_GROUP)
+        count = X9C_MAX_GROUP;
+
+    for (uint8_t i = 0; i < count; i++)
+        dir[i] = -1;
+
+    X9C_pulseGroup(pots, dir, count, X9C_MAX_POS, true);
+
+    for (uint8_t i = 0; i < count; i++)
+        pots[i].position = 0;
+}
+
+// Drive every pot to 0 together and block other movement
+void X9C_halt(X9C *pots, uint8_t count)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        halted = true;
+
+        // The chips ignore INC until a store cycle ends. Waiting it out here
+        // would keep interrupts off for up to X9C_STORE_US
+        if (storing && micros() - store_us < X9C_STORE_US)
+        {
+            halt_pending = true;
+            return;
+        }
+        X9C_haltTravel(pots, count);
+    }
+}
+
+// Drive to 0 once the store cycle a halt found running is over
+bool X9C_finishHalt(X9C *pots, uint8_t count)
+{
+    if (!halt_pending || X9C_storeBusy())
+        return false;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        halt_pending = false;
+        X9C_haltTravel(pots, count);
+    }
+    return true;
+}
+
+// Returns true while a halt waits for a store cycle to end
+bool X9C_haltPending()
+{
+    return halt_pending;
+}
+
+// Allow the pots to move again after a halt
+void X9C_release()
+{
+    halted = false;
+}
+
+// Returns true between X9C_halt and X9C_release
+bool X9C_isHalted()
+{
+    return halted;
+}
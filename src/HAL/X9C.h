@@ -0,0 +1,91 @@
+/*
+ * X9C.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Driver for one or more X9C10x digital potentiometers. Chips whose INC pins
+ *  share a port are pulsed with a single port write, so a group of channels
+ *  moves one step in the time a single chip would.
+ *
+ *  Each chip can also store its wiper in non-volatile memory, recalled when
+ *  the chip powers up. The store cycle takes X9C_STORE_US and the chip
+ *  ignores INC until it is over, so the next move waits for it.
+ */
+
+/* Arduino Driver Includes */
+#include <Arduino.h>
+
+#ifndef X9C_H_
+#define X9C_H_
+
+#define X9C_MAX_POS 99 // highest wiper tap of the X9C family
+#define X9C_MAX_GROUP 4 // most pots stepped together by X9C_stepGroup
+#define X9C_STORE_US 20000 // non-volatile store cycle, tWR
+
+struct _X9C
+{
+    // Control pins of the chip
+    uint8_t cs_pin;
+    uint8_t inc_pin;
+    uint8_t ud_pin;
+
+    // End to end resistance of the chip
+    uint32_t max_ohms;
+
+    // Tracked wiper position. The X9C is open loop, so this is only a belief
+    uint8_t position;
+};
+typedef struct _X9C X9C;
+
+// Constructs a potentiometer. All potentiometers must be constructed before beginning them.
+X9C X9C_construct(uint8_t cs_pin, uint8_t inc_pin, uint8_t ud_pin, uint32_t max_ohms);
+
+// Configures the control pins and deselects the chip
+void X9C_begin(X9C *pot_p);
+
+// Moves the wiper to a position. Forced moves drive to 0 first, ignoring the tracked position.
+void X9C_setPosition(X9C *pot_p, uint8_t position, bool forced);
+
+// Returns the tracked wiper position
+uint8_t X9C_getPosition(X9C *pot_p);
+
+// Replaces the tracked position with one the wiper was measured at, without moving it
+void X9C_resync(X9C *pot_p, uint8_t position);
+
+// Stores the wiper in the chip's non-volatile memory, to be recalled at its next power up.
+// Rated for 100,000 stores, so call it only once the wiper has settled somewhere new.
+void X9C_store(X9C *pot_p);
+
+// True while a store cycle runs, a store or move started now would wait for it
+bool X9C_storeBusy();
+
+// Returns the tracked wiper resistance in ohms
+uint32_t X9C_getOhms(X9C *pot_p);
+
+// Returns the wiper resistance in ohms at a given position
+uint32_t X9C_positionToOhms(X9C *pot_p, uint8_t position);
+
+// Steps every pot in the group by dir[i] (-1, 0 or +1) using shared INC pulses
+void X9C_stepGroup(X9C *pots, const int8_t *dir, uint8_t count);
+
+// Drives every pot in the group to 0 at once and blocks any other movement until
+// X9C_release. Runs with interrupts off and is safe to call from an interrupt.
+// During a store cycle the chips ignore INC, so it only blocks movement and
+// leaves the travel to X9C_finishHalt.
+void X9C_halt(X9C *pots, uint8_t count);
+
+// Drives the pots to 0 for a halt that found a store cycle running, once the
+// cycle is over. Returns true if it did, call it until X9C_haltPending is false
+bool X9C_finishHalt(X9C *pots, uint8_t count);
+
+// Returns true while a halt waits for a store cycle to end
+bool X9C_haltPending();
+
+// Allows the pots to move again after X9C_halt
+void X9C_release();
+
+// Returns true while the pots are halted
+bool X9C_isHalted();
+
+#endif /* X9C_H_ */
@@ -0,0 +1,178 @@
+/*
+ * Adc.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Simulated ADC. Conversions happen at the real rate on the simulated
+ *  clock and go through the same oversampling, channel switching and median
+ *  as the interrupt driven driver, so results lag the analog model the way
+ *  the hardware's do. Conversions due since the last read are run when the
+ *  firmware next looks, back to at most what can still reach a result.
+ */
+
+#include <HAL/Adc.h>
+#include <HAL/HAL.h>
+
+#define SIM_CONVERSION_US (1000000UL / ADC_CONVERSIONS_PER_S)
+
+static uint8_t pins[ADC_CHANNELS_MAX];
+static uint8_t channel_count = 0;
+
+static uint8_t extra_bits = 0;
+static uint8_t median_len = 1;
+
+// Accumulator of the channel being converted, as in the interrupt
+static uint8_t current = 0;
+static uint32_t sum = 0;
+static uint16_t sum_count = 0;
+static bool discard = false;
+
+static uint16_t history[ADC_CHANNELS_MAX][ADC_MEDIAN_MAX];
+static uint8_t history_i[ADC_CHANNELS_MAX];
+static uint8_t history_fill[ADC_CHANNELS_MAX];
+
+static unsigned long next_conversion_us = 0;
+
+static void Adc_clear()
+{
+    current = 0;
+    sum = 0;
+    sum_count = 0;
+    discard = true; // a conversion may be running on the old mux
+    for (uint8_t ch = 0; ch < ADC_CHANNELS_MAX; ch++)
+    {
+        history_i[ch] = 0;
+        history_fill[ch] = 0;
+    }
+    next_conversion_us = micros() + SIM_CONVERSION_US;
+}
+
+// One conversion, the body of the real ADC interrupt
+static void Adc_convert()
+{
+    uint16_t sample = analogRead(pins[current]);
+
+    if (discard)
+        discard = false;
+    else
+    {
+        sum += sample;
+        sum_count++;
+    }
+
+    if (sum_count >= ((uint16_t)1 << (2 * extra_bits)))
+    {
+        uint8_t ch = current;
+        uint8_t i = (history_i[ch] + 1) % ADC_MEDIAN_MAX;
+        history[ch][i] = sum >> extra_bits;
+        history_i[ch] = i;
+        if (history_fill[ch] < ADC_MEDIAN_MAX)
+            history_fill[ch]++;
+
+        sum = 0;
+        sum_count = 0;
+        current = (ch + 1) % channel_count;
+        discard = channel_count > 1;
+    }
+}
+
+// Runs the conversions due by now. Older ones than a full median of results are skipped
+static void Adc_catchUp()
+{
+    if (channel_count == 0)
+        return;
+
+    unsigned long now_us = micros();
+    unsigned long span = ((1UL << (2 * extra_bits)) + 1) * (ADC_MEDIAN_MAX + 1) * channel_count;
+    if ((long)(now_us - next_conversion_us) > (long)(span * SIM_CONVERSION_US))
+        next_conversion_us = now_us - span * SIM_CONVERSION_US;
+
+    while ((long)(now_us - next_conversion_us) >= 0)
+    {
+        Adc_convert();
+        next_conversion_us += SIM_CONVERSION_US;
+    }
+}
+
+void Adc_begin(const uint8_t *new_pins, uint8_t count)
+{
+    if (count > ADC_CHANNELS_MAX)
+        count = ADC_CHANNELS_MAX;
+
+    channel_count = count;
+    for (uint8_t ch = 0; ch < count; ch++)
+        pins[ch] = new_pins[ch];
+    Adc_clear();
+}
+
+bool Adc_configure(uint8_t new_extra_bits, uint8_t new_median_len)
+{
+    if (new_extra_bits > ADC_EXTRA_BITS_MAX)
+        return false;
+    if (new_median_len != 1 && new_median_len != 3 && new_median_len != 5)
+        return false;
+
+    extra_bits = new_extra_bits;
+    median_len = new_median_len;
+    Adc_clear();
+    return true;
+}
+
+uint16_t Adc_read(uint8_t channel)
+{
+    uint16_t values[ADC_MEDIAN_MAX];
+
+    Adc_catchUp();
+    if (channel >= channel_count)
+        return 0;
+
+    uint8_t len = min(median_len, history_fill[channel]);
+    uint8_t i = history_i[channel];
+    for (uint8_t n = 0; n < len; n++)
+    {
+        values[n] = history[channel][i];
+        i = (i + ADC_MEDIAN_MAX - 1) % ADC_MEDIAN_MAX;
+    }
+    if (len == 0)
+        return 0;
+
+    for (uint8_t n = 1; n < len; n++)
+    {
+        uint16_t value = values[n];
+        uint8_t m = n;
+        while (m > 0 && values[m - 1] > value)
+        {
+            values[m] = values[m - 1];
+            m--;
+        }
+        values[m] = value;
+    }
+
+    return values[(len - 1) / 2];
+}
+
+uint8_t Adc_extraBits()
+{
+    return extra_bits;
+}
+
+// Same bound as the real driver, the simulated conversions keep the same pace
+uint16_t Adc_latencyMs()
+{
+    uint32_t conversions = ((uint32_t)1 << (2 * extra_bits)) + (channel_count > 1 ? 1 : 0);
+    uint32_t results = 1 + (median_len + 1) / 2;
+    uint32_t total = conversions * results * max(channel_count, (uint8_t)1);
+
+    return (total * 1000 + ADC_CONVERSIONS_PER_S - 1) / ADC_CONVERSIONS_PER_S;
+}
+
+bool Adc_ready()
+{
+    bool ready = channel_count > 0;
+
+    Adc_catchUp();
+    for (uint8_t ch = 0; ch < channel_count; ch++)
+        ready &= history_fill[ch] >= median_len;
+    return ready;
+}
@@ -0,0 +1,87 @@
+/*
+ * Arduino.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Stand-in for the Arduino core in the native simulator build, covering
+ *  only what the firmware uses. Pins and ports are plain arrays, time comes
+ *  from the host clock and interrupts are signals, see Sim.h.
+ */
+
+#ifndef SIM_ARDUINO_H_
+#define SIM_ARDUINO_H_
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Print.h>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+// Analog pins follow D13, as on the Nano
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+#define SIM_PINS 22
+#define SIM_PORTS 3 // pins 0-7, 8-15 and 16-21, standing in for PORTD, PORTB and PORTC
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+// Sketch entry points, called by the simulator's main()
+void setup();
+void loop();
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+extern volatile uint8_t Sim_ports[SIM_PORTS];
+#define digitalPinToPort(pin) ((pin) / 8)
+#define digitalPinToBitMask(pin) ((uint8_t)(1 << ((pin) % 8)))
+#define portOutputRegister(port) (&Sim_ports[(port)])
+
+void noInterrupts();
+void interrupts();
+
+/* Registers of the peripherals that are simulated below their driver */
+#define _BV(bit) (1 << (bit))
+#define ISR(vector, ...) extern "C" void vector(void)
+
+// Timer1 input capture, see Sim_pulse
+extern volatile uint8_t TCCR1A, TCCR1B, TIMSK1, TIFR1;
+extern volatile uint16_t TCNT1, ICR1;
+#define CS11 1
+#define ICES1 6
+#define ICNC1 7
+#define ICIE1 5
+#define ICF1 5
+#define TIMER1_CAPT_vect Sim_timer1Capture
+
+#endif /* SIM_ARDUINO_H_ */
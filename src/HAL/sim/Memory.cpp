@@ -0,0 +1,23 @@
+/*
+ * Memory.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Host memory says nothing about the 2 KB of the Nano, so the simulator
+ *  reports zeros.
+ */
+
+#include <HAL/Memory.h>
+
+MemoryStats Memory_stats()
+{
+    MemoryStats stats;
+    memset(&stats, 0, sizeof(stats));
+    return stats;
+}
+
+uint16_t Memory_freeRam()
+{
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * Print.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <Print.h>
+#include <stdio.h>
+#include <string.h>
+
+size_t Print::write(const char *str)
+{
+    return write((const uint8_t *)str, strlen(str));
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        write(buffer[i]);
+    return size;
+}
+
+size_t Print::print(const __FlashStringHelper *str)
+{
+    return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const char *str)
+{
+    return write(str);
+}
+
+size_t Print::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char n, int base)
+{
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(int n, int base)
+{
+    return print((long)n, base);
+}
+
+size_t Print::print(unsigned int n, int base)
+{
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(long n, int base)
+{
+    if (base == DEC && n < 0)
+        return print('-') + print((unsigned long)-n, base);
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    char text[24];
+    snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", n);
+    return write(text);
+}
+
+size_t Print::print(double n, int digits)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%.*f", digits, n);
+    return write(text);
+}
+
+size_t Print::println()
+{
+    return write((uint8_t)'\r') + write((uint8_t)'\n');
+}
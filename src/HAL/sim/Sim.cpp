@@ -0,0 +1,426 @@
+/*
+ * Sim.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <HAL/sim/Sim.h>
+#include <HAL/sim/SimAnalog.h>
+#include <HAL/sim/SimX9C.h>
+#include <HAL/Trigger.h>
+#include <avr/eeprom.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <util/atomic.h>
+
+#define SIM_IDLE_US 100 // sleep per loop pass, keeps the simulator off 100% of a host core
+#define SIM_PASS_US 100 // virtual time of a loop pass
+#define SIM_QUIET_PASSES 4 // idle passes in a row before the virtual clock jumps
+#define SIM_EEPROM_WRITE_US 3400 // EEPROM byte write time of the ATmega328
+#define SIM_END_WAIT_MS 86400000UL // longest @> wait by default, a virtual day
+#define SIM_SCRIPT_LINE_LEN 128
+#define SIM_NEVER ULONG_MAX
+
+// What the input script waits for before its next line
+enum _SimWait
+{
+    SimReady,
+    SimTime, // the virtual clock to reach wait_us
+    SimEnd   // a '>' line for every line sent, or the clock to reach wait_us
+};
+typedef enum _SimWait SimWait;
+
+volatile uint8_t Sim_ports[SIM_PORTS];
+static uint8_t pin_modes[SIM_PINS];
+
+// Timer1 registers. TCNT1 does not count, so captures read as just taken
+volatile uint8_t TCCR1A, TCCR1B, TIMSK1, TIFR1;
+volatile uint16_t TCNT1, ICR1;
+extern "C" void TIMER1_CAPT_vect(void);
+
+static struct timespec start_time;
+
+// Virtual clock and the earliest deadline asked for during the current pass
+static bool virtual_time = false;
+static unsigned long now_us = 0;
+static unsigned long wake_us = SIM_NEVER;
+static bool active = false;
+static uint8_t quiet_passes = 0;
+
+// Input script state, see Sim.h
+static char script_line[SIM_SCRIPT_LINE_LEN];
+static size_t script_sent = 0;
+static size_t script_len = 0;
+static SimWait script_wait = SimReady;
+static unsigned long wait_us = 0;
+static unsigned long lines_sent = 0;
+static unsigned long boot_end_lines = 0; // '>' lines written by setup
+
+static uint8_t eeprom[E2END + 1];
+static FILE *eeprom_file = NULL; // backing file from DYNO_SIM_EEPROM, if set
+static unsigned long eeprom_ready_us = 0;
+
+static void Sim_onSignal(int signal)
+{
+    if (signal == SIGUSR1)
+        Sim_pulse(TRIGGER_PIN);
+}
+
+static sigset_t Sim_interruptSet()
+{
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    return set;
+}
+
+void Sim_maskInterrupts(sigset_t *saved_p)
+{
+    sigset_t set = Sim_interruptSet();
+    sigprocmask(SIG_BLOCK, &set, saved_p);
+}
+
+void Sim_restoreInterrupts(const sigset_t *saved_p)
+{
+    sigprocmask(SIG_SETMASK, saved_p, NULL);
+}
+
+SimAtomic::SimAtomic() : done_(false)
+{
+    Sim_maskInterrupts(&saved_);
+}
+
+SimAtomic::~SimAtomic()
+{
+    Sim_restoreInterrupts(&saved_);
+}
+
+void noInterrupts()
+{
+    sigset_t set = Sim_interruptSet();
+    sigprocmask(SIG_BLOCK, &set, NULL);
+}
+
+void interrupts()
+{
+    sigset_t set = Sim_interruptSet();
+    sigprocmask(SIG_UNBLOCK, &set, NULL);
+}
+
+bool Sim_isVirtual()
+{
+    return virtual_time;
+}
+
+void Sim_wakeAtMs(unsigned long ms)
+{
+    Sim_wakeAtUs(ms * 1000);
+}
+
+void Sim_wakeAtUs(unsigned long us)
+{
+    if (us < wake_us)
+        wake_us = us;
+}
+
+void Sim_markActive()
+{
+    active = true;
+}
+
+unsigned long micros()
+{
+    if (virtual_time)
+        return now_us;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start_time.tv_sec) * 1000000UL + now.tv_nsec / 1000 - start_time.tv_nsec / 1000;
+}
+
+unsigned long millis()
+{
+    return micros() / 1000;
+}
+
+void delay(unsigned long ms)
+{
+    delayMicroseconds(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    SimX9C_poll();
+    if (virtual_time)
+    {
+        now_us += us;
+        return;
+    }
+
+    unsigned long start_us = micros();
+    while (micros() - start_us < us)
+        ;
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin < SIM_PINS)
+        pin_modes[pin] = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin >= SIM_PINS)
+        return;
+
+    Sim_markActive();
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        if (value)
+            Sim_ports[digitalPinToPort(pin)] |= digitalPinToBitMask(pin);
+        else
+            Sim_ports[digitalPinToPort(pin)] &= ~digitalPinToBitMask(pin);
+    }
+    SimX9C_poll();
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (pin >= SIM_PINS)
+        return LOW;
+    return (Sim_ports[digitalPinToPort(pin)] & digitalPinToBitMask(pin)) ? HIGH : LOW;
+}
+
+int analogRead(uint8_t pin)
+{
+    return SimAnalog_read(pin);
+}
+
+uint8_t eeprom_read_byte(const uint8_t *addr)
+{
+    return eeprom[(uintptr_t)addr & E2END];
+}
+
+void eeprom_write_byte(uint8_t *addr, uint8_t value)
+{
+    uintptr_t i = (uintptr_t)addr & E2END;
+    eeprom[i] = value;
+    eeprom_ready_us = micros() + SIM_EEPROM_WRITE_US;
+    Sim_markActive();
+    if (eeprom_file != NULL)
+    {
+        fseek(eeprom_file, i, SEEK_SET);
+        fputc(value, eeprom_file);
+        fflush(eeprom_file);
+    }
+}
+
+int eeprom_is_ready()
+{
+    if ((long)(eeprom_ready_us - micros()) > 0)
+    {
+        Sim_wakeAtUs(eeprom_ready_us);
+        return 0;
+    }
+    return 1;
+}
+
+void eeprom_read_block(void *dst, const void *src, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        ((uint8_t *)dst)[i] = eeprom_read_byte((const uint8_t *)src + i);
+}
+
+// Erased EEPROM reads 0xFF. A backing file is created erased if it is new or short
+static void Sim_openEeprom()
+{
+    memset(eeprom, 0xFF, sizeof(eeprom));
+
+    const char *path = getenv("DYNO_SIM_EEPROM");
+    if (path == NULL)
+        return;
+
+    eeprom_file = fopen(path, "r+b");
+    if (eeprom_file == NULL)
+        eeprom_file = fopen(path, "w+b");
+    if (eeprom_file == NULL)
+        return;
+
+    size_t stored = fread(eeprom, 1, sizeof(eeprom), eeprom_file);
+    if (stored < sizeof(eeprom))
+    {
+        fseek(eeprom_file, 0, SEEK_SET);
+        fwrite(eeprom, 1, sizeof(eeprom), eeprom_file);
+        fflush(eeprom_file);
+    }
+}
+
+// Both edges of the pulse pass, so a capture happens whichever edge is selected
+void Sim_pulse(uint8_t pin)
+{
+    if (pin != TRIGGER_PIN || pin_modes[pin] == OUTPUT)
+        return;
+
+    Sim_markActive();
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+        ICR1 = TCNT1;
+        if (TIMSK1 & _BV(ICIE1))
+            TIMER1_CAPT_vect();
+    }
+}
+
+// Runs one directive of the input script, see Sim.h
+static void Sim_directive(const char *directive)
+{
+    char *end;
+    if (strncmp(directive, "pulse", 5) == 0)
+        Sim_pulse(TRIGGER_PIN);
+    else if (strncmp(directive, "analog", 6) == 0)
+    {
+        const char *pin = directive + 6;
+        while (isspace(*pin) || *pin == 'A')
+            pin++;
+        long index = strtol(pin, &end, 10);
+        long counts = strtol(end, NULL, 10);
+        Sim_setAnalog(A0 + index, counts);
+    }
+    else if (strncmp(directive, "wiper", 5) == 0)
+    {
+        long channel = strtol(directive + 5, &end, 10);
+        long position = strtol(end, NULL, 10);
+        SimX9C_setWiper(channel, position);
+    }
+    else if (strncmp(directive, "model", 5) == 0)
+    {
+        if (!SimAnalog_configure(directive + 5))
+            fprintf(stderr, "sim: bad model @%s", directive);
+    }
+    else if (directive[0] == '>')
+    {
+        long ms = strtol(directive + 1, &end, 10);
+        script_wait = SimEnd;
+        wait_us = now_us + (end == directive + 1 ? SIM_END_WAIT_MS : ms) * 1000;
+    }
+    else if (isdigit(directive[0]))
+    {
+        script_wait = SimTime;
+        wait_us = now_us + strtoul(directive, NULL, 10) * 1000;
+    }
+    else
+    {
+        fprintf(stderr, "sim: unknown directive @%s", directive);
+        exit(2);
+    }
+}
+
+/**
+ * Feeds the input script to the UART. Lines go out once the previous wait is
+ * over, as fast as the RX buffer takes them. Returns false once the script
+ * has ended.
+ */
+static bool Sim_feedScript()
+{
+    for (;;)
+    {
+        if (script_wait == SimEnd && Sim_uartEndLines() - boot_end_lines >= lines_sent)
+            script_wait = SimReady;
+        if (script_wait != SimReady)
+        {
+            if (now_us < wait_us)
+                return true;
+            if (script_wait == SimEnd)
+            {
+                fprintf(stderr, "sim: no '>' by %lu ms\n", now_us / 1000);
+                exit(1);
+            }
+            script_wait = SimReady;
+        }
+
+        while (script_sent < script_len)
+        {
+            if (!Sim_uartReceive(script_line[script_sent]))
+                return true;
+            script_sent++;
+        }
+
+        if (fgets(script_line, sizeof(script_line), stdin) == NULL)
+            return Sim_uartPending();
+
+        script_sent = 0;
+        script_len = 0;
+        if (script_line[0] == '@')
+            Sim_directive(script_line + 1);
+        else
+        {
+            script_len = strlen(script_line);
+            lines_sent++;
+        }
+    }
+}
+
+/**
+ * Advances the virtual clock past a loop pass. State changes that write
+ * nothing, like a timer moving the FSM on, take effect a pass or two later,
+ * so the clock only jumps to the earliest deadline, the timers' or the
+ * script's, after SIM_QUIET_PASSES passes with nothing to do.
+ */
+static void Sim_advance()
+{
+    unsigned long next_us = now_us + SIM_PASS_US;
+    bool input_waiting = Sim_uartPending() || (script_wait == SimReady && script_sent < script_len);
+
+    quiet_passes = active || input_waiting ? 0 : quiet_passes + 1;
+    if (quiet_passes >= SIM_QUIET_PASSES)
+    {
+        quiet_passes = 0;
+        unsigned long deadline_us = wake_us;
+        if (script_wait != SimReady && wait_us < deadline_us)
+            deadline_us = wait_us;
+        if (deadline_us != SIM_NEVER && deadline_us > next_us)
+            next_us = deadline_us;
+    }
+
+    now_us = next_us;
+    wake_us = SIM_NEVER;
+    active = false;
+}
+
+// Unit tests under test/ bring their own main
+#ifndef PIO_UNIT_TESTING
+int main()
+{
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    Sim_openEeprom();
+    SimX9C_begin();
+    virtual_time = getenv("DYNO_SIM_VIRTUAL") != NULL;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = Sim_onSignal;
+    action.sa_mask = Sim_interruptSet();
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, NULL);
+
+    setup();
+    if (virtual_time)
+    {
+        boot_end_lines = Sim_uartEndLines();
+        while (Sim_feedScript())
+        {
+            loop();
+            Sim_advance();
+        }
+        fflush(stdout);
+        return 0;
+    }
+
+    for (;;)
+    {
+        loop();
+        usleep(SIM_IDLE_US);
+    }
+}
+#endif
@@ -0,0 +1,79 @@
+/*
+ * Sim.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Native simulator of the Nano, built with pio run -e native. The firmware
+ *  runs unchanged on top of it. The UART is stdin and stdout, analog pins
+ *  read the divider model of SimAnalog.h and simulated interrupts are signals:
+ *
+ *      .pio/build/native/program
+ *      kill -USR1 <pid>    pulses the trigger pin, D8
+ *
+ *  EEPROM is kept in the file named by DYNO_SIM_EEPROM, if set, and the
+ *  X9C stored positions in the one named by DYNO_SIM_X9C.
+ *
+ *  With DYNO_SIM_VIRTUAL set, time is virtual. Each loop pass costs
+ *  SIM_PASS_US. Once a few passes in a row have written no pin, byte or
+ *  EEPROM cell, the clock jumps straight to the earliest deadline a software
+ *  timer or the input asked for, so a run takes as long as its busy loop
+ *  passes, not its virtual time.
+ *  Output depends only on the input. Stdin is then a script of lines sent
+ *  to the UART and directives:
+ *
+ *      @<ms>               let ms pass before the next line
+ *      @> [ms]             wait until every line sent has been answered with
+ *                          a '>' line, at most ms or SIM_END_WAIT_MS, else
+ *                          exit with an error
+ *      @pulse              pulse the trigger pin
+ *      @analog <pin> <n>   fix the ADC reading of A<pin> at n counts
+ *      @model <params>     change analog model parameters, see SimAnalog.h
+ *      @wiper <ch> <pos>   move a wiper behind the firmware's back, a lost step
+ *
+ *  The simulator exits once the script ends.
+ *
+ *  Timer1 input capture is simulated at the register level, so the real
+ *  trigger driver is the one under test.
+ */
+
+#include <Arduino.h>
+#include <signal.h>
+
+#ifndef SIM_H_
+#define SIM_H_
+
+// Pulses a digital input. A pulse on D8 is captured by Timer1 if capture is enabled
+void Sim_pulse(uint8_t pin);
+
+// Fixes the 10 bit ADC reading of an analog pin, in place of the analog model
+void Sim_setAnalog(uint8_t pin, uint16_t counts);
+
+// Returns true when the clock is virtual
+bool Sim_isVirtual();
+
+// Asks for a loop pass at or before a millis() or micros() time, so a virtual clock
+// does not jump past it. Ignored with the host clock.
+void Sim_wakeAtMs(unsigned long ms);
+void Sim_wakeAtUs(unsigned long us);
+
+// Marks the current loop pass as busy, so the virtual clock does not jump after it
+void Sim_markActive();
+
+// Hands a received byte to the simulated UART as its RX interrupt would. Returns
+// false when the RX buffer is full.
+bool Sim_uartReceive(uint8_t c);
+
+// Returns true while received bytes wait to be read
+bool Sim_uartPending();
+
+// Number of lines starting with '>' the firmware has written
+unsigned long Sim_uartEndLines();
+
+// Masks the signals standing in for interrupts, saving the previous mask
+void Sim_maskInterrupts(sigset_t *saved_p);
+
+// Restores a mask saved by Sim_maskInterrupts
+void Sim_restoreInterrupts(const sigset_t *saved_p);
+
+#endif /* SIM_H_ */
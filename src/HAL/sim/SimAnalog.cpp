@@ -0,0 +1,214 @@
+/*
+ * SimAnalog.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <HAL/HAL.h>
+#include <HAL/X9C.h>
+#include <HAL/sim/Sim.h>
+#include <HAL/sim/SimAnalog.h>
+#include <HAL/sim/SimX9C.h>
+
+#define SIM_ANALOG_FIXED 0xFFFF // no fixed reading, the pin follows the model
+
+struct _SimAnalogModel
+{
+    double supply;
+    double ohms;
+    double wiper;
+    double load;
+    double cap;
+    double noise;
+    uint64_t seed;
+};
+typedef struct _SimAnalogModel SimAnalogModel;
+
+// Node of a channel, settling from start_v at start_us toward target_v
+struct _SimNode
+{
+    double start_v;
+    double target_v;
+    double tau_us;
+    unsigned long start_us;
+};
+typedef struct _SimNode SimNode;
+
+static const uint8_t mes_pins[POT_CHANNELS_MAX] = {POT_MES_PIN, POT1_MES_PIN};
+
+static SimAnalogModel model;
+static SimNode nodes[POT_CHANNELS_MAX];
+static uint16_t fixed[SIM_PINS - A0];
+static uint64_t noise_state;
+static FILE *trace_file = NULL;
+static bool started = false;
+
+// Steady voltage and time constant of a channel's node at its wiper position
+static void SimAnalog_settle(uint8_t channel, double *volts_p, double *tau_us_p)
+{
+    double ratio = (double)SimX9C_wiper(channel) / X9C_MAX_POS;
+    double top = model.ohms * (1 - ratio);
+    double bottom = model.ohms * ratio;
+    double source_v = model.supply * ratio;
+    double source_ohms = model.wiper + (top + bottom > 0 ? top * bottom / (top + bottom) : 0);
+
+    if (model.load > 0)
+    {
+        *volts_p = source_v * model.load / (source_ohms + model.load);
+        source_ohms = source_ohms * model.load / (source_ohms + model.load);
+    }
+    else
+        *volts_p = source_v;
+    *tau_us_p = source_ohms * model.cap * 1e6;
+}
+
+static double SimAnalog_nodeVolts(uint8_t channel, unsigned long now_us)
+{
+    SimNode *node_p = &nodes[channel];
+    if (node_p->tau_us <= 0)
+        return node_p->target_v;
+    double decay = exp(-(double)(now_us - node_p->start_us) / node_p->tau_us);
+    return node_p->target_v + (node_p->start_v - node_p->target_v) * decay;
+}
+
+// Standard normal deviate from a xorshift generator, the same sequence for the same seed
+static double SimAnalog_gaussian()
+{
+    double u[2];
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        noise_state ^= noise_state << 13;
+        noise_state ^= noise_state >> 7;
+        noise_state ^= noise_state << 17;
+        u[i] = ((noise_state >> 11) + 0.5) / 9007199254740992.0; // 2^53
+    }
+    return sqrt(-2 * log(u[0])) * cos(2 * M_PI * u[1]);
+}
+
+static bool SimAnalog_set(const char *name, double value)
+{
+    if (strcmp(name, "supply") == 0)
+        model.supply = value;
+    else if (strcmp(name, "ohms") == 0)
+        model.ohms = value;
+    else if (strcmp(name, "wiper") == 0)
+        model.wiper = value;
+    else if (strcmp(name, "load") == 0)
+        model.load = value;
+    else if (strcmp(name, "cap") == 0)
+        model.cap = value;
+    else if (strcmp(name, "noise") == 0)
+        model.noise = value;
+    else if (strcmp(name, "seed") == 0)
+    {
+        model.seed = (uint64_t)value;
+        noise_state = model.seed ? model.seed : 1;
+    }
+    else
+        return false;
+    return true;
+}
+
+// Defaults, then DYNO_SIM_ANALOG and DYNO_SIM_TRACE, on first use
+static void SimAnalog_begin()
+{
+    if (started)
+        return;
+    started = true;
+
+    for (uint8_t i = 0; i < SIM_PINS - A0; i++)
+        fixed[i] = SIM_ANALOG_FIXED;
+    SimAnalog_configure(SIM_ANALOG_DEFAULTS);
+
+    const char *spec = getenv("DYNO_SIM_ANALOG");
+    if (spec != NULL && !SimAnalog_configure(spec))
+        fprintf(stderr, "sim: bad DYNO_SIM_ANALOG %s\n", spec);
+
+    const char *path = getenv("DYNO_SIM_TRACE");
+    if (path != NULL)
+        trace_file = fopen(path, "w");
+
+    for (uint8_t ch = 0; ch < POT_CHANNELS_MAX; ch++)
+    {
+        SimAnalog_settle(ch, &nodes[ch].target_v, &nodes[ch].tau_us);
+        nodes[ch].start_v = nodes[ch].target_v;
+    }
+}
+
+bool SimAnalog_configure(const char *spec)
+{
+    SimAnalog_begin();
+
+    char name[16];
+    double value;
+    int used;
+    bool ok = true;
+
+    while (sscanf(spec, " %15[^=,]=%lf%n", name, &value, &used) == 2)
+    {
+        ok &= SimAnalog_set(name, value);
+        spec += used;
+        if (*spec == ',')
+            spec++;
+    }
+    while (isspace(*spec))
+        spec++;
+
+    // New parameters apply from now, from wherever the nodes are
+    for (uint8_t ch = 0; ch < POT_CHANNELS_MAX; ch++)
+        SimAnalog_wiperMoved(ch);
+    return ok && *spec == '\0';
+}
+
+void SimAnalog_wiperMoved(uint8_t channel)
+{
+    SimAnalog_begin();
+    if (channel >= POT_CHANNELS_MAX)
+        return;
+
+    unsigned long now_us = micros();
+    SimNode *node_p = &nodes[channel];
+    node_p->start_v = SimAnalog_nodeVolts(channel, now_us);
+    node_p->start_us = now_us;
+    SimAnalog_settle(channel, &node_p->target_v, &node_p->tau_us);
+
+    if (trace_file != NULL)
+    {
+        fprintf(trace_file, "%lu,%u,%u,%.6f\n", now_us, channel, SimX9C_wiper(channel), node_p->target_v);
+        fflush(trace_file);
+    }
+}
+
+uint16_t SimAnalog_read(uint8_t pin)
+{
+    SimAnalog_begin();
+    if (pin < A0 || pin >= SIM_PINS)
+        return 0;
+    if (fixed[pin - A0] != SIM_ANALOG_FIXED)
+        return fixed[pin - A0];
+
+    for (uint8_t ch = 0; ch < POT_CHANNELS_MAX; ch++)
+    {
+        if (mes_pins[ch] != pin)
+            continue;
+
+        double counts = SimAnalog_nodeVolts(ch, micros()) / model.supply * ADC_MAX;
+        counts += model.noise * SimAnalog_gaussian();
+        return constrain(floor(counts), 0, ADC_MAX - 1);
+    }
+    return 0;
+}
+
+double SimAnalog_volts(uint8_t channel)
+{
+    SimAnalog_begin();
+    return channel < POT_CHANNELS_MAX ? SimAnalog_nodeVolts(channel, micros()) : 0;
+}
+
+void Sim_setAnalog(uint8_t pin, uint16_t counts)
+{
+    SimAnalog_begin();
+    if (pin >= A0 && pin < SIM_PINS)
+        fixed[pin - A0] = counts;
+}
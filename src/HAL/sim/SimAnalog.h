@@ -0,0 +1,58 @@
+/*
+ * SimAnalog.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Analog model of the measured divider of each channel. The X9C is a
+ *  potentiometer across the supply, with its wiper resistance in series with
+ *  the output, loaded by the controller's input resistance and filtered by
+ *  the capacitance on the node:
+ *
+ *      supply --[ R (1 - p) ]--+--[ R p ]-- gnd
+ *                              |
+ *                           wiper_ohms
+ *                              |
+ *                              +---- load_ohms || cap_f ---- gnd     -> ADC
+ *
+ *  After a wiper move the node settles exponentially, with the time constant
+ *  of the Thevenin resistance of the divider and wiper, parallel to the load,
+ *  times the capacitance. Conversions add Gaussian noise and quantize to 10
+ *  bits against the supply, which is also the ADC reference.
+ *
+ *  Parameters are a comma separated list of name=value, from DYNO_SIM_ANALOG
+ *  or the @model directive, over SIM_ANALOG_DEFAULTS:
+ *
+ *      supply   supply and reference voltage, V
+ *      ohms     end to end resistance of the pot
+ *      wiper    wiper resistance, ohms
+ *      load     controller input resistance, ohms, 0 for none
+ *      cap      capacitance on the node, F
+ *      noise    conversion noise, standard deviation in counts
+ *      seed     noise generator seed
+ *
+ *  With DYNO_SIM_TRACE set to a file path, every wiper move is written there
+ *  as time_us,channel,position,settled_v, the ground truth to compare the
+ *  firmware's frames against.
+ */
+
+#include <Arduino.h>
+
+#ifndef SIM_ANALOG_H_
+#define SIM_ANALOG_H_
+
+#define SIM_ANALOG_DEFAULTS "supply=4.71,ohms=100000,wiper=40,load=1e6,cap=100e-9,noise=0.5,seed=1"
+
+// Sets model parameters from a name=value list. Returns false on an unknown name
+bool SimAnalog_configure(const char *spec);
+
+// Starts the settling of a channel's node toward its new wiper position
+void SimAnalog_wiperMoved(uint8_t channel);
+
+// Returns a 10 bit conversion of an analog pin at the current time
+uint16_t SimAnalog_read(uint8_t pin);
+
+// Returns the noise free voltage of a channel's node at the current time
+double SimAnalog_volts(uint8_t channel);
+
+#endif /* SIM_ANALOG_H_ */
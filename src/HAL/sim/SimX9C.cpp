@@ -0,0 +1,121 @@
+/*
+ * SimX9C.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ */
+
+#include <HAL/HAL.h>
+#include <HAL/X9C.h>
+#include <HAL/sim/SimAnalog.h>
+#include <HAL/sim/SimX9C.h>
+
+struct _SimX9CChip
+{
+    uint8_t cs_pin;
+    uint8_t inc_pin;
+    uint8_t ud_pin;
+
+    // Pin levels as the chip last saw them, low like the ports at reset
+    uint8_t cs;
+    uint8_t inc;
+    uint8_t ud;
+
+    uint8_t wiper;
+    uint8_t stored; // non-volatile copy, recalled at power on
+    bool storing;
+    unsigned long store_us; // start of the last store cycle
+};
+typedef struct _SimX9CChip SimX9CChip;
+
+static SimX9CChip chips[POT_CHANNELS_MAX] = {
+    {CS_PIN, INC_PIN, UD_PIN, LOW, LOW, LOW, 0, 0, false, 0},
+    {CS1_PIN, INC1_PIN, UD1_PIN, LOW, LOW, LOW, 0, 0, false, 0},
+};
+
+static FILE *nv_file = NULL; // backing file from DYNO_SIM_X9C, if set
+
+// A new or short file reads as every wiper stored at 0
+void SimX9C_begin()
+{
+    const char *path = getenv("DYNO_SIM_X9C");
+    if (path == NULL)
+        return;
+
+    nv_file = fopen(path, "r+b");
+    if (nv_file == NULL)
+        nv_file = fopen(path, "w+b");
+    if (nv_file == NULL)
+        return;
+
+    for (uint8_t ch = 0; ch < POT_CHANNELS_MAX; ch++)
+    {
+        int stored = fgetc(nv_file);
+        chips[ch].stored = stored == EOF ? 0 : min(stored, X9C_MAX_POS);
+        SimX9C_setWiper(ch, chips[ch].stored);
+    }
+}
+
+static void SimX9C_store(uint8_t ch)
+{
+    chips[ch].stored = chips[ch].wiper;
+    chips[ch].storing = true;
+    chips[ch].store_us = micros();
+
+    if (nv_file == NULL)
+        return;
+    fseek(nv_file, 0, SEEK_SET);
+    for (uint8_t i = 0; i < POT_CHANNELS_MAX; i++)
+        fputc(chips[i].stored, nv_file);
+    fflush(nv_file);
+}
+
+void SimX9C_poll()
+{
+    for (uint8_t ch = 0; ch < POT_CHANNELS_MAX; ch++)
+    {
+        SimX9CChip *chip_p = &chips[ch];
+        uint8_t ud = digitalRead(chip_p->ud_pin);
+        uint8_t inc = digitalRead(chip_p->inc_pin);
+        uint8_t cs = digitalRead(chip_p->cs_pin);
+
+        // U/D is set up before INC moves and INC before CS rises
+        chip_p->ud = ud;
+
+        if (chip_p->storing && micros() - chip_p->store_us >= SIM_X9C_STORE_US)
+            chip_p->storing = false;
+
+        if (inc != chip_p->inc)
+        {
+            if (inc == LOW && chip_p->cs == LOW && !chip_p->storing)
+            {
+                if (chip_p->ud == HIGH && chip_p->wiper < X9C_MAX_POS)
+                    SimX9C_setWiper(ch, chip_p->wiper + 1);
+                else if (chip_p->ud == LOW && chip_p->wiper > 0)
+                    SimX9C_setWiper(ch, chip_p->wiper - 1);
+            }
+            chip_p->inc = inc;
+        }
+
+        if (cs != chip_p->cs)
+        {
+            if (cs == HIGH && chip_p->inc == HIGH)
+                SimX9C_store(ch);
+            chip_p->cs = cs;
+        }
+    }
+}
+
+uint8_t SimX9C_wiper(uint8_t channel)
+{
+    return channel < POT_CHANNELS_MAX ? chips[channel].wiper : 0;
+}
+
+void SimX9C_setWiper(uint8_t channel, uint8_t position)
+{
+    if (channel >= POT_CHANNELS_MAX)
+        return;
+
+    chips[channel].wiper = min(position, (uint8_t)X9C_MAX_POS);
+    SimAnalog_wiperMoved(channel);
+}
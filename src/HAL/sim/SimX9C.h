@@ -0,0 +1,37 @@
+/*
+ * SimX9C.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Pin level model of the X9C chips wired as in HAL.h. The wiper moves on
+ *  falling INC edges while CS is low and is stored when CS rises with INC
+ *  high, as in the datasheet, so the wiper here is the truth the firmware's
+ *  tracked position can be checked against.
+ *
+ *  A store takes SIM_X9C_STORE_US, during which INC is ignored. The stored
+ *  positions are kept in the file named by DYNO_SIM_X9C, if set, and are
+ *  recalled into the wipers when the simulator starts, like a power up.
+ */
+
+#include <Arduino.h>
+
+#ifndef SIM_X9C_H_
+#define SIM_X9C_H_
+
+#define SIM_X9C_STORE_US 20000 // store cycle of the X9C, tWR
+
+// Recalls the stored positions, call once before setup()
+void SimX9C_begin();
+
+// Follows the chip pins. The X9C driver writes INC straight to the port, so
+// this runs on every digitalWrite and delay, where the levels can have changed.
+void SimX9C_poll();
+
+// Returns the true wiper position of a channel
+uint8_t SimX9C_wiper(uint8_t channel);
+
+// Moves the wiper of a channel without INC pulses, like a glitch would
+void SimX9C_setWiper(uint8_t channel, uint8_t position);
+
+#endif /* SIM_X9C_H_ */
@@ -0,0 +1,130 @@
+/*
+ * Uart.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Simulated UART on stdin and stdout. Received bytes are taken from stdin
+ *  whenever the firmware looks for them, which stands in for the RX interrupt.
+ *  With a virtual clock the simulator hands over the bytes instead, see Sim.h.
+ */
+
+#include <HAL/Uart.h>
+#include <HAL/sim/Sim.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+UartPort Uart;
+
+static uint8_t rx_buffer[UART_RX_BUFFER_SIZE];
+static uint8_t rx_head = 0;
+static uint8_t rx_tail = 0;
+
+static uint8_t stop_byte = 0;
+static void (*stop_handler)(void) = NULL;
+static unsigned long line_times_us[UART_LINE_TIMES];
+static uint8_t line_head = 0;
+static uint8_t line_tail = 0;
+static unsigned long line_time_us = 0;
+
+static bool tx_line_start = true;
+static unsigned long tx_end_lines = 0;
+
+// Handles stop bytes the way the RX interrupt does
+bool Sim_uartReceive(uint8_t c)
+{
+    if (stop_handler != NULL && c == stop_byte)
+    {
+        stop_handler();
+        return true;
+    }
+
+    uint8_t next = (rx_head + 1) & (UART_RX_BUFFER_SIZE - 1);
+    if (next == rx_tail)
+        return false;
+
+    if (c == '\n' || c == '\r')
+    {
+        line_times_us[line_head & (UART_LINE_TIMES - 1)] = micros();
+        line_head++;
+    }
+
+    rx_buffer[rx_head] = c;
+    rx_head = next;
+    return true;
+}
+
+bool Sim_uartPending()
+{
+    return rx_head != rx_tail;
+}
+
+unsigned long Sim_uartEndLines()
+{
+    return tx_end_lines;
+}
+
+// Takes whatever stdin has. Bytes that do not fit are dropped, as on the device
+static void Uart_receive()
+{
+    if (Sim_isVirtual())
+        return;
+
+    uint8_t c;
+    while (::read(STDIN_FILENO, &c, 1) == 1)
+        Sim_uartReceive(c);
+}
+
+void UartPort::begin(unsigned long /* baud */)
+{
+    if (!Sim_isVirtual())
+        fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+}
+
+int UartPort::available()
+{
+    Uart_receive();
+    return (rx_head - rx_tail) & (UART_RX_BUFFER_SIZE - 1);
+}
+
+int UartPort::read()
+{
+    Uart_receive();
+    if (rx_head == rx_tail)
+        return -1;
+
+    Sim_markActive();
+    uint8_t c = rx_buffer[rx_tail];
+    if (c == '\n' || c == '\r')
+        line_time_us = line_times_us[line_tail++ & (UART_LINE_TIMES - 1)];
+    rx_tail = (rx_tail + 1) & (UART_RX_BUFFER_SIZE - 1);
+    return c;
+}
+
+size_t UartPort::write(uint8_t c)
+{
+    Sim_markActive();
+    putchar(c);
+    if (tx_line_start && c == '>')
+        tx_end_lines++;
+    tx_line_start = c == '\n';
+    if (c == '\n' && !Sim_isVirtual())
+        fflush(stdout);
+    return 1;
+}
+
+void UartPort::flush()
+{
+    fflush(stdout);
+}
+
+unsigned long UartPort::lineTime()
+{
+    return line_time_us;
+}
+
+void UartPort::onStop(uint8_t stop_char, void (*handler)(void))
+{
+    stop_byte = stop_char;
+    stop_handler = handler;
+}
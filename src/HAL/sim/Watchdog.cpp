@@ -0,0 +1,35 @@
+/*
+ * Watchdog.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Simulated watchdog. Nothing resets the simulator, so every start is a
+ *  power on.
+ */
+
+#include <HAL/Watchdog.h>
+
+#define SIM_PORF 0x01 // power on reset flag of MCUSR
+
+void Watchdog_begin(uint8_t /* timeout */)
+{
+}
+
+void Watchdog_kick()
+{
+}
+
+void Watchdog_stage(uint8_t /* stage */)
+{
+}
+
+uint8_t Watchdog_resetCause()
+{
+    return SIM_PORF;
+}
+
+uint8_t Watchdog_lastStage()
+{
+    return 0;
+}
@@ -0,0 +1,26 @@
+/*
+ * eeprom.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  EEPROM for the native simulator build. Writes take as long as on the
+ *  ATmega328, though the data is there at once. Set
+ *  DYNO_SIM_EEPROM to a file path to keep the contents between runs.
+ */
+
+#ifndef SIM_EEPROM_H_
+#define SIM_EEPROM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define E2END 0x3FF // last EEPROM address of the ATmega328
+
+int eeprom_is_ready();
+
+uint8_t eeprom_read_byte(const uint8_t *addr);
+void eeprom_write_byte(uint8_t *addr, uint8_t value);
+void eeprom_read_block(void *dst, const void *src, size_t size);
+
+#endif /* SIM_EEPROM_H_ */
@@ -0,0 +1,24 @@
+/*
+ * wdt.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Watchdog timeouts for the native simulator build.
+ */
+
+#ifndef SIM_WDT_H_
+#define SIM_WDT_H_
+
+#define WDTO_15MS 0
+#define WDTO_30MS 1
+#define WDTO_60MS 2
+#define WDTO_120MS 3
+#define WDTO_250MS 4
+#define WDTO_500MS 5
+#define WDTO_1S 6
+#define WDTO_2S 7
+#define WDTO_4S 8
+#define WDTO_8S 9
+
+#endif /* SIM_WDT_H_ */
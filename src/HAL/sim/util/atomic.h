@@ -0,0 +1,41 @@
+/*
+ * atomic.h
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  ATOMIC_BLOCK for the native simulator build. Simulated interrupts are
+ *  signals, so the block masks them and restores the previous mask on the
+ *  way out, including through return and break.
+ */
+
+#ifndef SIM_ATOMIC_H_
+#define SIM_ATOMIC_H_
+
+#include <signal.h>
+
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON 1
+
+class SimAtomic
+{
+public:
+    SimAtomic();
+    ~SimAtomic();
+
+    // True on the first pass only, so the block body runs once
+    bool once()
+    {
+        bool first = !done_;
+        done_ = true;
+        return first;
+    }
+
+private:
+    sigset_t saved_;
+    bool done_;
+};
+
+#define ATOMIC_BLOCK(type) for (SimAtomic sim_atomic_; sim_atomic_.once();)
+
+#endif /* SIM_ATOMIC_H_ */
@@ -4,9 +4,6 @@
  * @brief This is the main class for DynoControl, a firmware for Arduino to
  * control a 100k digital potentiometer to act as a surrogate throttle for BOLT
  *
- * @bug Not a bug, but Arduino "String" is super terrible for memory management.
- * Consider swapping for char[]
- *
  * @ingroup default
  *
  * @author Colton Tshudy
@@ -15,43 +12,110 @@
  */
 
 #include <Arduino.h>
+#include <util/atomic.h>
 #include <Application.h>
-#include <HAL\HAL.h>
-#include <HAL\Timer.h>
-#include <X9C10X.h>
-
-#define VERSION 0.72 // Added ADC settling timer back
-
-Application app;       // Application struct
-X9C10X pot(POT_MAX_R); // Digital potentiometer
+#include <HAL/Adc.h>
+#include <HAL/Calibration.h>
+#include <HAL/HAL.h>
+#include <HAL/Histogram.h>
+#include <HAL/Memory.h>
+#include <HAL/Script.h>
+#include <HAL/Timer.h>
+#include <HAL/Trigger.h>
+#include <HAL/Uart.h>
+#include <HAL/Watchdog.h>
+#include <HAL/X9C.h>
+
+#define VERSION 0.92 // Commands queued while another runs
+
+Application app;        // Application struct
+X9C pots[POT_CHANNELS]; // Digital potentiometers, one per channel
+Histogram loop_hist;    // Loop period histogram, survives 'q' resets
+uint16_t loop_overruns; // Loop passes over LOOP_BUDGET_US, survives 'q' resets
+DataBatch data_batch;   // Samples waiting for a batched frame
+CommandQueue command_queue; // Lines waiting for the running command to finish
+Script script;          // SRAM copy of the script being run or recorded
+WiperRecall recall;     // Wiper recall settings, source of their config writes
+uint8_t store_pending;  // Channels whose chip store has not started, one bit each
+bool recall_flush;      // Store the wipers now, a stop or reset left them at zero
+unsigned long ready_us; // Time from reset to the first '>'
+unsigned long boot_us[BOOT_PHASES]; // Time spent in each phase of setup()
+
+// Emergency stop state, written by the RX interrupt
+volatile bool estop_flag = false;     // stop handled, application reset pending
+volatile uint16_t estop_us = 0;       // latency of the last stop
+volatile uint16_t estop_worst_us = 0; // worst latency since boot
+volatile unsigned long estop_start_us;  // entry of a stop still waiting on a store cycle
+
+// Pins of each potentiometer channel
+const uint8_t cs_pins[POT_CHANNELS_MAX] = {CS_PIN, CS1_PIN};
+const uint8_t inc_pins[POT_CHANNELS_MAX] = {INC_PIN, INC1_PIN};
+const uint8_t ud_pins[POT_CHANNELS_MAX] = {UD_PIN, UD1_PIN};
+const uint8_t mes_pins[POT_CHANNELS_MAX] = {POT_MES_PIN, POT1_MES_PIN};
 
 /** =================================================
  * Setup before loop
  */
 void setup()
 {
+  Watchdog_stage(StageSetup);
+  unsigned long phase_us = micros();
+  boot_us[BootCore] = phase_us;
+
   // Initializes the pins
   InitializePins();
 
   // Begins UART communication
-  Serial.begin(BAUDRATE);
+  Uart.begin(BAUDRATE);
 
-  // Startup message
-  String startup_message = "";
-  startup_message.concat("Throttle Mapper Ver. ");
-  startup_message.concat(VERSION);
-  Serial.println(startup_message);
+  // Startup message, with the cause of the last reset and where the loop was
+  Uart.print(F("Throttle Mapper Ver. "));
+  Uart.print(VERSION);
+  Uart.print(F(", reset 0x"));
+  Uart.print(Watchdog_resetCause(), HEX);
+  Uart.print(F(" stage "));
+  Uart.println(Watchdog_lastStage());
+  bootPhase(BootUart, &phase_us);
+
+  // The banner fits the TX buffer and drains in the background while the
+  // rest of the boot runs, homing included
 
   // Constructs the application struct
   app = Application_construct();
+  Histogram_reset(&loop_hist);
 
   // Potentiometer initialization
-  pot.begin(INC_PIN, UD_PIN, CS_PIN);
-  pot.setPosition(0, true);
-
-  delay(20); // Startup delay
-
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    pots[ch] = X9C_construct(cs_pins[ch], inc_pins[ch], ud_pins[ch], POT_MAX_R);
+    X9C_begin(&pots[ch]);
+  }
+  Uart.onStop(S_STOP_CHAR, emergencyStop);
+  Adc_begin(mes_pins, POT_CHANNELS);
+  Script_begin();
+  Calibration_begin(V_POT_MAX * 1000);
+  bootPhase(BootInit, &phase_us);
+
+  recallBoot();
+  bootPhase(BootPots, &phase_us);
+
+  // Ready once the measurements show where the wipers ended up
+  bool settled = adcWaitSettled(BOOT_SETTLE_TIMEOUT);
+  bootPhase(BootSettle, &phase_us);
+
+  Watchdog_begin(WDT_TIMEOUT);
+  ready_us = phase_us;
+  serialPrintBoot(settled);
   serialPrintChar(S_E_CHAR);
+
+  // Run the boot script, if one is set, so the rig works without a host
+  char boot_name[SCRIPT_NAME_LEN + 1];
+  if (Script_bootName(boot_name) && Script_load(&script, boot_name) == ScriptOk && scriptChannelsFit(&script))
+  {
+    serialPrintChar(S_R_CHAR);
+    scriptStart(&app);
+    app.appState = Executing;
+  }
 }
 
 /** =================================================
@@ -59,11 +123,25 @@ void setup()
  */
 void loop()
 {
+  // Time between successive loop passes
+  static unsigned long last_loop_us = micros();
+  unsigned long now_us = micros();
+  Histogram_add(&loop_hist, now_us - last_loop_us);
+  last_loop_us = now_us;
+
   // Should blink every second, if not, the Arduino is hung
+  Watchdog_stage(StageLED);
   WatchdogLED(&app);
 
   // Primary loop for application
   Application_loop(&app);
+
+  // Only a pass within budget kicks the watchdog, so a hung or repeatedly
+  // overrunning loop resets the MCU
+  if (micros() - now_us <= LOOP_BUDGET_US)
+    Watchdog_kick();
+  else if (loop_overruns != UINT16_MAX)
+    loop_overruns++;
 }
 
 /**
@@ -77,25 +155,54 @@ Application Application_construct()
   app.watchdog_timer = SWTimer_construct(MS_IN_SECONDS);
   app.pot_test_timer = SWTimer_construct(100);                 // every 0.05 seconds
   app.wait_cmd_timer = SWTimer_construct(0);                   // default initialization
-  app.linear_cmd_timer = SWTimer_construct(0);                 // default initialization
-  app.adc_settling_timer = SWTimer_construct(ADC_SETTLE_TIME); // ADC timer for settling time
+  app.adc_settling_timer = SWTimer_construct(ADC_SETTLE_TIME + Adc_latencyMs()); // ADC settling and filter delay
   app.data_step_timer = SWTimer_construct(S_DATA_TIMESTEP);    // time between data logs
   app.serial_timeout_timer = SWTimer_construct(S_TIMEOUT);     // time between data logs
+  app.health_timer = SWTimer_construct(0);                     // set by 'm' command
 
-  app.pot_v = 0;
-  app.pot_ohms = 0;
-  app.pot_pos = 0;
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    Channel *ch_p = &app.channels[ch];
+    ch_p->linear_cmd_timer = SWTimer_construct(0); // default initialization
+
+    ch_p->pot_v = 0;
+    ch_p->pot_ohms = 0;
+    ch_p->pot_pos = 0;
+
+    ch_p->target_pos = 0;
+    ch_p->ramping_time = 0;
+    ch_p->steps = 0;
+    ch_p->step_count = 0;
+    ch_p->step_rem = 0;
+    ch_p->step_err = 0;
+    ch_p->step_ms = 0;
+    ch_p->desync_count = 0;
+    ch_p->desync = 0;
+  }
+  app.channel_mask = 1; // channel 0 only
+  app.data_mask = DATA_DEFAULT_MASK;
+  app.batch_len = 1;
+  app.batch_timer = SWTimer_construct(0);
   app.mes_timestamp = 0;
-
-  app.target_pos = 0;
-  app.ramping_time = 0;
-  app.steps = 0;
+  memset(&app.script_run, 0, sizeof(app.script_run));
+  memset(&app.wiper_sync, 0, sizeof(app.wiper_sync));
+  app.sync_check_timer = SWTimer_construct(SYNC_CHECK_PERIOD);
+  app.recall_timer = SWTimer_construct(RECALL_STILL_MS);
+  SWTimer_start(&app.recall_timer);
 
   app.new_value_flag = 1;
   app.cmd_finished_flag = 0;
   app.cmd_high_priority = 0;
+  app.health_enabled = 0;
+  app.trigger_fired = 0;
+  app.ramp_report = 0;
+  app.ramp_late_ms = 0;
+  app.terse = 0;
+  app.last_response = RespOk;
+  app.last_cmd = '\0';
 
-  app.command = "";
+  memset(app.command, '\0', sizeof(app.command));
+  memset(app.trigger_cmd, '\0', sizeof(app.trigger_cmd));
 
   app.appState = Idle;
 
@@ -107,38 +214,121 @@ Application Application_construct()
  */
 void Application_loop(Application *app_p)
 {
-  // Track last potentiometer position
-  static uint32_t old_pot_pos = 0;
+  // Track last potentiometer positions
+  static uint8_t old_pot_pos[POT_CHANNELS];
+
+  // Drive to zero for a stop that found a store cycle running
+  if (X9C_finishHalt(pots, POT_CHANNELS))
+  {
+    unsigned long start_us;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      start_us = estop_start_us;
+    }
+    estopLatency(start_us);
+  }
+
+  // Finish an emergency stop. The pots were zeroed by the RX interrupt, or above
+  if (estop_flag && !X9C_haltPending())
+  {
+    estop_flag = false;
+    serialPrintStop();
+    command_queue.count = 0;
+    bool terse = app_p->terse;
+    *app_p = Application_construct();
+    app_p->terse = terse;
+    X9C_release();
+    recall_flush = true;
+  }
 
-  // Poll potentiometer
+  // Poll potentiometers
+  Watchdog_stage(StagePoll);
   pollPot(app_p);
 
+  // Report trigger edges as soon as they are captured, inline with the data
+  // frames. An edge also starts the armed command, if there is one
+  TriggerEvent event;
+  while (Trigger_read(&event))
+  {
+    serialPrintTrigger(&event);
+    if (app_p->trigger_cmd[0] != '\0')
+      app_p->trigger_fired = true;
+  }
+
   // Check for change in data. Used to forcibly capture high frequency changes
-  if (app_p->pot_pos != old_pot_pos)
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
   {
-    SWTimer_start(&app_p->adc_settling_timer);
-    app_p->new_value_flag = 1;
+    if (app_p->channels[ch].pot_pos != old_pot_pos[ch])
+    {
+      SWTimer_start(&app_p->adc_settling_timer);
+      SWTimer_start(&app_p->recall_timer);
+      app_p->new_value_flag = 1;
+    }
   }
 
   // Output serial data every <S_DATA_TIMESTEP> ms
+  Watchdog_stage(StageData);
   // Wait after pot % changes to allow ADC to settle
   if (SWTimer_expired(&app_p->adc_settling_timer))
   {
     if (SWTimer_expired(&app_p->data_step_timer) || app_p->new_value_flag)
     {
       SWTimer_start(&app_p->data_step_timer);
-      serialPrintData(app_p);
+      if (app_p->batch_len > 1)
+        batchAdd(app_p);
+      else
+        serialPrintData(app_p);
       app_p->new_value_flag = 0;
     }
   }
 
+  // Check the tracked positions against the settled measurements now and
+  // then, so a wiper that lost steps during a long run is noticed
+  if (app_p->appState != Syncing && !rampActive(app_p) &&
+      SWTimer_expired(&app_p->adc_settling_timer) && SWTimer_expired(&app_p->sync_check_timer))
+  {
+    SWTimer_start(&app_p->sync_check_timer);
+    syncCheck(app_p);
+  }
+
+  // Store the wipers in the chips once they have stayed put, so a power
+  // cycle brings them back. After a stop at once, so it never brings back
+  // the throttle that was stopped
+  if (store_pending)
+    recallService();
+  if (recall.mode == RECALL_ON && !rampActive(app_p) && (recall_flush || SWTimer_expired(&app_p->recall_timer)))
+    recallStore(app_p);
+
+  // Send a batch once its oldest sample reaches the latency bound, or when
+  // batching was switched off
+  if (data_batch.count > 0 && (app_p->batch_len <= 1 || SWTimer_expired(&app_p->batch_timer)))
+    serialPrintBatch(app_p);
+
+  // Output memory health frames when enabled by the 'm' command
+  if (app_p->health_enabled && SWTimer_expired(&app_p->health_timer))
+  {
+    SWTimer_start(&app_p->health_timer);
+    serialPrintHealth();
+  }
+
+  // Write the next byte of a background EEPROM save
+  Script_service();
+
   // This could be printed during state transitions, but placing it here allows
   // for one final serial print of measurements before it tells serial that a
   // command has concluded
   if (app_p->cmd_finished_flag)
   {
     app_p->cmd_finished_flag = false;
-    serialPrintChar(S_E_CHAR);
+    if (data_batch.count > 0)
+      serialPrintBatch(app_p);
+    if (app_p->ramp_report)
+    {
+      app_p->ramp_report = false;
+      serialPrintRampEnd(app_p);
+    }
+    else
+      serialPrintChar(S_E_CHAR);
   }
 
   // Handles serial command inputs
@@ -150,7 +340,9 @@ void Application_loop(Application *app_p)
     serialPrintChar(S_HP_CHAR);
     executeCommand(app_p, app_p->command);
   }
-  old_pot_pos = app_p->pot_pos;
+
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+    old_pot_pos[ch] = app_p->channels[ch].pot_pos;
 }
 
 /** =================================================
@@ -165,7 +357,49 @@ void Application_loop(Application *app_p)
 void primaryFSM(Application *app_p)
 {
   _appStates state = app_p->appState;
-  bool cmd_in_queue = checkSerialRX(app_p);
+  Watchdog_stage(StageSerialRX);
+  bool received = checkSerialRX(app_p);
+  bool cmd_in_queue = false;
+
+  // Sync requests are answered in every state so clocks can be aligned mid-run
+  if (received && state != Idle && tolower(app_p->command[0]) == 'y')
+  {
+    serialPrintChar(S_R_CHAR);
+    executeCommand(app_p, app_p->command);
+    serialPrintChar(S_E_CHAR);
+    received = false;
+  }
+
+  // Retarget commands replace the ramp in flight and complete at once
+  if (received && state == Linear && tolower(app_p->command[0]) == 'u')
+  {
+    serialPrintChar(S_R_CHAR);
+    executeCommand(app_p, app_p->command);
+    serialPrintChar(S_E_CHAR);
+    received = false;
+  }
+
+  // Other lines wait their turn behind the running command, so a host can
+  // send ahead. A high priority line skips the queue and runs from
+  // Application_loop, unless nothing is waiting anyway
+  bool high_priority = app_p->cmd_high_priority && (state != Idle || command_queue.count > 0);
+  if (received && !high_priority && !commandPush(app_p->command, app_p->command_us))
+    serialPrintResponse(app_p, RespQueueFull, tolower(app_p->command[0]));
+
+  if (state == Idle && !high_priority)
+  {
+    cmd_in_queue = commandPop(app_p->command, &app_p->command_us);
+
+    // An armed command runs once, on the first edge that finds the FSM idle
+    if (!cmd_in_queue && app_p->trigger_fired)
+    {
+      strcpy(app_p->command, app_p->trigger_cmd);
+      app_p->command_us = micros();
+      app_p->trigger_cmd[0] = '\0';
+      app_p->trigger_fired = false;
+      cmd_in_queue = true;
+    }
+  }
 
   switch (state)
   {
@@ -179,12 +413,22 @@ void primaryFSM(Application *app_p)
     break;
 
   case Executing:
+    if (app_p->script_run.running)
+    {
+      state = Scripting;
+      break;
+    }
+    if (app_p->wiper_sync.active)
+    {
+      state = Syncing;
+      break;
+    }
     if (!SWTimer_expired(&app_p->wait_cmd_timer))
     {
       state = Waiting;
       break;
     }
-    if (app_p->steps != 0)
+    if (rampActive(app_p))
     {
       state = Linear;
       break;
@@ -194,15 +438,10 @@ void primaryFSM(Application *app_p)
     break;
 
   case Linear:
-    if (SWTimer_expired(&app_p->linear_cmd_timer))
-    {
-      int direction = app_p->target_pos > app_p->pot_pos ? 1 : -1;
-      pot.setPosition(app_p->pot_pos + direction);
-      app_p->steps--;
-      SWTimer_start(&app_p->linear_cmd_timer);
-    }
-    if (app_p->steps == 0)
+    rampStep(app_p);
+    if (!rampActive(app_p))
     {
+      app_p->ramp_report = true;
       app_p->cmd_finished_flag = true;
       state = Idle;
     }
@@ -215,6 +454,30 @@ void primaryFSM(Application *app_p)
       state = Idle;
     }
     break;
+
+  case Scripting:
+    // Steps run back to back, each once the step before it is done
+    rampStep(app_p);
+    for (uint8_t i = 0; i < SCRIPT_STEPS_PER_PASS && scriptReady(app_p); i++)
+    {
+      if (!scriptStep(app_p))
+      {
+        serialPrintScript(app_p);
+        app_p->cmd_finished_flag = true;
+        state = Idle;
+        break;
+      }
+    }
+    break;
+
+  case Syncing:
+    if (!syncStep(app_p))
+    {
+      app_p->wiper_sync.active = false;
+      app_p->cmd_finished_flag = true;
+      state = Idle;
+    }
+    break;
   }
 
   app_p->appState = state;
@@ -224,15 +487,15 @@ void primaryFSM(Application *app_p)
 bool checkSerialRX(Application *app_p)
 {
   static uint8_t ser_i = 0;
-  static char input[CMD_CHAR_LEN];
+  static char input[CMD_CHAR_LEN + 1];
   bool valid_cmd = false;
 
   // When the first character is recieved, keep reading until a newline
   // character or timeout
-  if (Serial.available())
+  if (Uart.available())
   {
     SWTimer_start(&app_p->serial_timeout_timer);
-    char serialChar = Serial.read();
+    char serialChar = Uart.read();
     if(serialChar == ASCII_CR)
       serialChar = ASCII_LF;
     input[ser_i] = serialChar;
@@ -242,9 +505,10 @@ bool checkSerialRX(Application *app_p)
       checkPriority(app_p, input);
       
       if (ECHO_EN)
-        Serial.print(input); // echo
+        Uart.print(input); // echo
 
-      app_p->command = input;
+      strcpy(app_p->command, input);
+      app_p->command_us = Uart.lineTime();
       valid_cmd = true;
     }
 
@@ -261,246 +525,1710 @@ bool checkSerialRX(Application *app_p)
   return valid_cmd;
 }
 
+// Lines are kept whole, a ring of CMD_QUEUE_LEN of them
+bool commandPush(const char *line, unsigned long line_us)
+{
+  if (command_queue.count >= CMD_QUEUE_LEN)
+    return false;
+
+  uint8_t i = (command_queue.head + command_queue.count) % CMD_QUEUE_LEN;
+  strcpy(command_queue.lines[i], line);
+  command_queue.line_us[i] = line_us;
+  command_queue.count++;
+  return true;
+}
+
+bool commandPop(char *line, unsigned long *line_us_p)
+{
+  if (command_queue.count == 0)
+    return false;
+
+  strcpy(line, command_queue.lines[command_queue.head]);
+  *line_us_p = command_queue.line_us[command_queue.head];
+  command_queue.head = (command_queue.head + 1) % CMD_QUEUE_LEN;
+  command_queue.count--;
+  return true;
+}
+
 /**
  * Polls the potentiometer object for new values, and uses the ADC to measure
  * the actual voltage at the divider created by the potentiometer
  */
-// this uses analogread, which is blocking.
-// consider changing to non-blocking analogread function
+// ADC results are converted in the background by the ADC interrupt
 void pollPot(Application *app_p)
 {
+  uint32_t full_scale = (uint32_t)ADC_MAX << Adc_extraBits();
+
   // Poll for new potentiometer values
-  app_p->pot_v = double(analogRead(POT_MES_PIN)) / ADC_MAX * V_POT_MAX;
-  app_p->pot_ohms = pot.getOhm();
-  app_p->pot_pos = pot.getPosition();
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    Channel *ch_p = &app_p->channels[ch];
+    ch_p->pot_v = double(Adc_read(ch)) / full_scale * V_POT_MAX;
+    ch_p->pot_ohms = X9C_getOhms(&pots[ch]);
+    ch_p->pot_pos = X9C_getPosition(&pots[ch]);
+  }
   app_p->mes_timestamp = millis();
 }
 
 /**
- * Executs a command based on the serial input string
+ * Starts a ramp to target over time ms on every selected channel. Step timing
+ * is computed from the channel's current position, so calling this during a
+ * ramp retargets it without waiting for it to finish.
+ *
+ * Steps are planned at absolute times from the start, the last one at the
+ * end of the ramp, so a late step does not push back the ones after it.
  */
-void executeCommand(Application *app_p, String input)
+void rampStart(Application *app_p, int target, uint64_t time)
 {
-  // Return string, if needed
-  String output_text = "Fail";
-  String arg1 = "";
-  String arg2 = "";
+  app_p->ramp_late_ms = 0;
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    if (!(app_p->channel_mask & (1 << ch)))
+      continue;
+
+    Channel *ch_p = &app_p->channels[ch];
+    ch_p->target_pos = target;
+    ch_p->ramping_time = time;
+    ch_p->steps = abs(target - X9C_getPosition(&pots[ch]));
+    if (ch_p->steps == 0)
+      continue;
+
+    ch_p->step_count = ch_p->steps;
+    ch_p->step_ms = ch_p->ramping_time / ch_p->steps;
+    ch_p->step_rem = ch_p->ramping_time % ch_p->steps;
+    ch_p->step_err = 0;
+    ch_p->linear_cmd_timer = SWTimer_construct(0);
+    SWTimer_start(&ch_p->linear_cmd_timer);
+    rampPlanNext(ch_p);
+  }
+}
 
-  input.toLowerCase();
+// Bresenham style, so no division is needed per step
+void rampPlanNext(Channel *ch_p)
+{
+  ch_p->linear_cmd_timer.waitTime_ms += ch_p->step_ms;
+  ch_p->step_err += ch_p->step_rem;
+  if (ch_p->step_err >= ch_p->step_count)
+  {
+    ch_p->step_err -= ch_p->step_count;
+    ch_p->linear_cmd_timer.waitTime_ms++;
+  }
+}
 
-  // Gets first char of command, and reset index
-  char cmd_type = nextWord(input, 1).charAt(0);
+/**
+ * Steps all ramping channels by every step their plan has due. Steps missed
+ * during a long loop pass, or due together because the ramp is faster than
+ * one step per ms, go out in a batch. Channels that are due together move on
+ * the same INC pulse, so a coordinated ramp costs one step period no matter
+ * how many channels it drives.
+ */
+void rampStep(Application *app_p)
+{
+  int8_t dir[POT_CHANNELS];
+  int8_t step_dir[POT_CHANNELS];
+  uint8_t due[POT_CHANNELS];
+  uint8_t batch = 0;
+  Watchdog_stage(StageRamp);
 
-  // Executs the command based on the char, otherwise gives error message
-  switch (cmd_type)
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
   {
-  case 't': // Linear ramp to throttle
-    arg1 = nextWord(input, 0);
-    arg2 = nextWord(input, 0);
-    if (isNumeric(arg1)) // nested ifs are ugly, change to function calls
-    {
-      int target = arg1.toInt();
-      if (target >= 0 && target < 100)
-      {
-        if (isNumeric(arg2))
-        {
-          uint64_t time = arg2.toInt();
-          if (time > 0)
-          {
-            app_p->target_pos = target;
-            app_p->ramping_time = time;
-            app_p->steps = abs(target - app_p->pot_pos);
-            uint64_t step_time = app_p->ramping_time / (app_p->steps);
-            app_p->linear_cmd_timer = SWTimer_construct(step_time);
-            SWTimer_start(&app_p->linear_cmd_timer);
-          }
-          else
-            output_text = "  Time out of bounds";
-        }
-        else if (arg2.equals("NULL"))
-          pot.setPosition(target);
-      }
-      else
-        output_text = "  Throttle out of bounds";
-    }
-    else
-      output_text = "  Bad argument for command 't'";
-    break;
+    Channel *ch_p = &app_p->channels[ch];
+    due[ch] = 0;
+    uint8_t position = X9C_getPosition(&pots[ch]);
+    dir[ch] = ch_p->target_pos > position ? 1 : (ch_p->target_pos < position ? -1 : 0);
 
-  case 's': // Step command
-    arg1 = nextWord(input, 0);
-    if (isNumeric(arg1))
+    while (due[ch] < ch_p->steps && SWTimer_expired(&ch_p->linear_cmd_timer))
     {
-      int new_pos = app_p->pot_pos + arg1.toInt();
-      if (new_pos >= 0 && new_pos < 100)
-        pot.setPosition(new_pos);
-      else
-        output_text = "  Throttle out of bounds";
+      due[ch]++;
+      rampPlanNext(ch_p);
     }
-    else
-      output_text = "  Bad argument for command 's'";
-    break;
+    batch = max(batch, due[ch]);
+  }
 
-  case 'w': // Wait command
-    arg1 = nextWord(input, 0);
-    if (isNumeric(arg1))
+  for (uint8_t n = 0; n < batch; n++)
+  {
+    for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+      step_dir[ch] = n < due[ch] ? dir[ch] : 0;
+    X9C_stepGroup(pots, step_dir, POT_CHANNELS);
+  }
+
+  // The last step of a ramp is planned at its end, the worst channel is reported
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    Channel *ch_p = &app_p->channels[ch];
+    if (due[ch] == 0)
+      continue;
+
+    ch_p->steps -= due[ch];
+    if (ch_p->steps == 0)
     {
-      int time = arg1.toInt();
-      if (time > 0)
-      {
-        app_p->wait_cmd_timer = SWTimer_construct(time);
-        SWTimer_start(&app_p->wait_cmd_timer);
-      }
-      else
-        output_text = "  Time out of bounds";
+      long late_ms = (long)(millis() - ch_p->linear_cmd_timer.startCounter - ch_p->ramping_time);
+      app_p->ramp_late_ms = max(app_p->ramp_late_ms, late_ms);
     }
-    else
-      output_text = "  Bad argument for command 'w'";
-    break;
+  }
+}
 
-  case 'r': // Read potentiometer command, effectively a dump
-    app_p->new_value_flag = 1;
-    break;
+// Returns true if any channel is still ramping
+bool rampActive(Application *app_p)
+{
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    if (app_p->channels[ch].steps != 0)
+      return true;
+  }
+  return false;
+}
 
-  case 'q': // Quit command, terminate program and reset (High Priority)
-    app_p->cmd_high_priority = false;
-    resetApplication(app_p);
-    break;
+/**
+ * Starts a resync of every selected channel, or a sweep of the calibration
+ * curve on the first selected channel. Both take one measurement at a time,
+ * each once the ADC has settled after the move before it, so the loop keeps
+ * running while they work.
+ */
+void syncStart(Application *app_p, bool calibrating)
+{
+  WiperSync *sync_p = &app_p->wiper_sync;
 
-  default:
-    output_text = "  Unknown command type";
-    break;
+  sync_p->active = true;
+  sync_p->calibrating = calibrating;
+  sync_p->phase = 0;
+  sync_p->channel = 0;
+  while (!(app_p->channel_mask & (1 << sync_p->channel)))
+    sync_p->channel++;
+
+  // The sweep starts from the bottom end stop, so its positions are known
+  if (calibrating)
+  {
+    sync_p->tracked = X9C_getPosition(&pots[sync_p->channel]);
+    X9C_setPosition(&pots[sync_p->channel], Calibration_point(0), true);
   }
 
-  if (!output_text.equals("Fail"))
-    Serial.println(output_text);
+  sync_p->settle_timer = SWTimer_construct(ADC_SETTLE_TIME + Adc_latencyMs());
+  SWTimer_start(&sync_p->settle_timer);
 }
 
 /**
- * Gets the next word from the string
+ * A resync looks at the wiper twice. The first look is taken as its position,
+ * then the wiper is moved SYNC_PROBE_TAPS away from the nearer end stop and
+ * looked at again. A second look that agrees with the move confirms the
+ * curve, and the two are averaged for the corrected position. The wiper then
+ * goes back to where it was meant to be.
  */
-String nextWord(String input, bool reset)
+bool syncStep(Application *app_p)
 {
-  static unsigned int cur = 0; // cursor for string index
-
-  if (reset)
-    cur = 0;
-
-  if (cur >= input.length())
-    return "NULL";
+  WiperSync *sync_p = &app_p->wiper_sync;
+  Watchdog_stage(StageSync);
 
-  // Attempt to find a word
-  _parserStates state = Spaces; // initial state for the parser FSM
-  for (unsigned int i = cur; i < input.length(); i++)
-  {
-    char c = input.charAt(i);
+  if (!SWTimer_expired(&sync_p->settle_timer))
+    return true;
 
-    switch (state)
-    {
-    case Spaces:
-      if (c == ASCII_LF || c == ASCII_SPACE)
-        ; // stay in Spaces state
-      else
-      {
-        cur = i; // move cursor to after spaces
-        state = Reading;
-      }
-      break;
+  uint8_t ch = sync_p->channel;
+  X9C *pot_p = &pots[ch];
+  uint16_t mv = app_p->channels[ch].pot_v * 1000 + 0.5;
 
-    case Reading:
-      if (c == ASCII_LF || c == ASCII_SPACE)
-      {
-        String word = input.substring(cur, i);
-        cur = i + 1;
-        return word;
-      }
-      break;
+  if (sync_p->calibrating)
+    return calibrateStep(app_p, mv);
 
-    default:
-      break;
-    }
+  if (sync_p->phase == 0)
+  {
+    sync_p->tracked = X9C_getPosition(pot_p);
+    sync_p->estimate = Calibration_position(mv);
+    sync_p->dir = sync_p->estimate < X9C_MAX_POS / 2 ? 1 : -1;
+    X9C_resync(pot_p, sync_p->estimate);
+    X9C_setPosition(pot_p, sync_p->estimate + sync_p->dir * SYNC_PROBE_TAPS, false);
+    sync_p->phase = 1;
+    SWTimer_start(&sync_p->settle_timer);
+    return true;
   }
 
-  return "NULL";
+  int16_t expected = sync_p->estimate + sync_p->dir * SYNC_PROBE_TAPS;
+  int16_t found = Calibration_position(mv);
+  bool following = abs(found - expected) <= SYNC_TOLERANCE;
+  if (following)
+    found = (found + expected + 1) / 2;
+  X9C_resync(pot_p, found);
+  serialPrintResync(ch, following ? found - sync_p->dir * SYNC_PROBE_TAPS : sync_p->estimate,
+                    sync_p->tracked, following);
+  X9C_setPosition(pot_p, sync_p->tracked, false);
+
+  app_p->channels[ch].desync_count = 0;
+  app_p->channels[ch].desync = false;
+
+  // On to the next selected channel, its ADC was not disturbed by this one
+  do
+    ch++;
+  while (ch < POT_CHANNELS && !(app_p->channel_mask & (1 << ch)));
+  if (ch >= POT_CHANNELS)
+    return false;
+
+  sync_p->channel = ch;
+  sync_p->phase = 0;
+  return true;
 }
 
-// Pin state setup
-void InitializePins()
+// Records the settled voltage at the current curve point and moves on to the next
+bool calibrateStep(Application *app_p, uint16_t mv)
 {
-  pinMode(LED_PIN, OUTPUT);
-  pinMode(CS_PIN, OUTPUT);
-  pinMode(INC_PIN, OUTPUT);
-  pinMode(UD_PIN, OUTPUT);
-}
+  WiperSync *sync_p = &app_p->wiper_sync;
+  X9C *pot_p = &pots[sync_p->channel];
 
-// Blinks an LED once a second as a visual indicator of processor hang
-void WatchdogLED(Application *app_p)
-{
-  static bool state = true;
+  Calibration_set(sync_p->phase, mv);
+  sync_p->phase++;
+  if (sync_p->phase < CAL_POINTS)
+  {
+    X9C_setPosition(pot_p, Calibration_point(sync_p->phase), false);
+    SWTimer_start(&sync_p->settle_timer);
+    return true;
+  }
 
-  if (SWTimer_expired(&app_p->watchdog_timer))
+  X9C_setPosition(pot_p, sync_p->tracked, false);
+
+  // A falling curve means the wiper did not follow the sweep, keep the old one
+  ScriptResult result = Calibration_save();
+  if (result == ScriptCorrupt)
   {
-    digitalWrite(LED_PIN, state);
-    state = !state;
-    SWTimer_start(&app_p->watchdog_timer);
+    Calibration_begin(V_POT_MAX * 1000);
+    serialPrintResponse(app_p, RespCurveNotRising, 'f');
   }
+  else if (result != ScriptOk)
+    serialPrintResponse(app_p, scriptResponse(result), 'f');
+  serialPrintCalibration();
+  return false;
 }
 
-void serialPrintData(Application *app_p)
+/**
+ * Runs every SYNC_CHECK_PERIOD while no ramp is moving the wipers. A channel
+ * out of tolerance SYNC_CHECK_COUNT times in a row is reported once, until
+ * it is back in tolerance or resynced with 'f'.
+ *
+ * Does nothing until 'f c' has measured the curve. The ideal curve ignores
+ * the load on the divider, so a loaded rig would be flagged all the time.
+ */
+void syncCheck(Application *app_p)
 {
-  String data = "";
-  data.concat(S_D_CHAR);
-  data.concat(app_p->pot_v); // voltage at divider
-  data.concat(",");
-  data.concat(app_p->pot_pos); // pot position
-  data.concat(",");
-  data.concat(app_p->pot_ohms); // pot ohms
-  data.concat(",");
-  data.concat(app_p->mes_timestamp); // timestamp of measurement
+  if (!Calibration_stored())
+    return;
+
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    Channel *ch_p = &app_p->channels[ch];
+    uint8_t found = Calibration_position(ch_p->pot_v * 1000 + 0.5);
 
-  Serial.println(data);
+    if (abs(found - ch_p->pot_pos) <= SYNC_TOLERANCE)
+    {
+      ch_p->desync_count = 0;
+      ch_p->desync = false;
+      continue;
+    }
+
+    if (ch_p->desync_count < SYNC_CHECK_COUNT)
+      ch_p->desync_count++;
+    if (ch_p->desync_count == SYNC_CHECK_COUNT && !ch_p->desync)
+    {
+      ch_p->desync = true;
+      serialPrintDesync(ch, found, ch_p->pot_pos);
+    }
+  }
 }
 
-void serialPrintChar(char c)
+// Ends a boot phase, its time runs from *phase_us_p to now
+void bootPhase(uint8_t phase, unsigned long *phase_us_p)
 {
-  char message[2];
-  snprintf(message, 2, "%c", c);
-  Serial.println(message);
+  unsigned long now_us = micros();
+  boot_us[phase] = now_us - *phase_us_p;
+  *phase_us_p = now_us;
 }
 
 /**
- * Checks if a string is made up of only numeric characters
- *
- * @param str String to check
- *
- * @returns true if string is numeric, false otherwise
+ * Waits until every channel reads the same, within BOOT_SETTLE_COUNTS, in two
+ * results a filter latency apart. The node settles exponentially, so this
+ * ends once it is creeping by well under a tap per ms. Gives up after
+ * timeout_ms and returns false.
  */
-bool isNumeric(String str)
+bool adcWaitSettled(uint16_t timeout_ms)
 {
-  for (unsigned int i = 0; i < str.length(); i++)
+  uint16_t last[POT_CHANNELS];
+  uint16_t tolerance = BOOT_SETTLE_COUNTS << Adc_extraBits();
+  uint16_t period_ms = max(Adc_latencyMs(), (uint16_t)1);
+  unsigned long start_ms = millis();
+  bool settled = false;
+
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+    last[ch] = Adc_read(ch);
+
+  while (!settled && millis() - start_ms < timeout_ms)
   {
-    if (!(isdigit(str.charAt(i)) || str.charAt(i) == '-'))
-      return false;
+    delay(period_ms);
+    settled = Adc_ready();
+    for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+    {
+      uint16_t value = Adc_read(ch);
+      if (abs((int32_t)value - last[ch]) > tolerance)
+        settled = false;
+      last[ch] = value;
+    }
   }
-  return true;
+  return settled;
 }
 
-void checkPriority(Application *app_p, char* cmd)
+/**
+ * The chips recall their stored wipers when they power up, but a reset of
+ * the MCU alone leaves them wherever they were. A channel keeps its stored
+ * position only if the settled ADC reading puts the wiper there, otherwise
+ * it is homed as usual.
+ */
+void recallBoot()
 {
-  switch(cmd[0])
+  uint32_t full_scale = (uint32_t)ADC_MAX << Adc_extraBits();
+
+  eeprom_read_block(&recall, (const void *)(uintptr_t)CONFIG_RECALL_ADDR, sizeof(recall));
+  if (recall.mode == RECALL_ON)
+    adcWaitSettled(BOOT_SETTLE_TIMEOUT);
+
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
   {
-  case 'q': // Quit command
-    app_p->cmd_high_priority = true;
-    break;
-  default:
-    break;
+    uint8_t stored = recall.stored[ch];
+    if (recall.mode == RECALL_ON && stored <= X9C_MAX_POS)
+    {
+      uint16_t mv = (uint32_t)Adc_read(ch) * (uint16_t)(V_POT_MAX * 1000) / full_scale;
+      if (abs(Calibration_position(mv) - stored) <= SYNC_TOLERANCE)
+      {
+        X9C_resync(&pots[ch], stored);
+        Uart.print(F("  Channel "));
+        Uart.print(ch);
+        Uart.print(F(" recalled "));
+        Uart.println(stored);
+        continue;
+      }
+    }
+    X9C_setPosition(&pots[ch], 0, true);
   }
 }
 
-void resetApplication(Application *app_p)
+// Writes the mirror first, so a chip never holds a position the config block does not know of.
+// recallService stores the chips once the write is done
+void recallStore(Application *app_p)
 {
-  pot.setPosition(0);
+  bool moved = false;
+
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+    moved |= app_p->channels[ch].pot_pos != recall.stored[ch];
+  if (!moved)
+  {
+    recall_flush = false;
+    return;
+  }
+  if (Script_busy())
+    return;
+
+  uint8_t old[POT_CHANNELS];
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    old[ch] = recall.stored[ch];
+    recall.stored[ch] = app_p->channels[ch].pot_pos;
+  }
+  Script_writeConfig(CONFIG_RECALL_ADDR, &recall, sizeof(recall));
+  recall_flush = false;
+
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    if (recall.stored[ch] != old[ch])
+      store_pending |= 1 << ch;
+  }
+}
+
+// Starts the chip stores recallStore left pending, one per pass as a store waiting on another
+// would stall the loop for its cycle. A wiper that moved off its mirrored position since waits
+// for the next mirror write
+void recallService()
+{
+  if (Script_busy() || X9C_storeBusy())
+    return;
+
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    if ((store_pending & (1 << ch)) && X9C_getPosition(&pots[ch]) == recall.stored[ch])
+    {
+      store_pending &= ~(1 << ch);
+      X9C_store(&pots[ch]);
+      return;
+    }
+  }
+}
+
+// The chips' stored positions are unknown until the wipers next settle
+uint8_t recallSet(bool on)
+{
+  if (Script_busy())
+    return scriptResponse(ScriptBusy);
+
+  recall.mode = on ? RECALL_ON : 0;
+  for (uint8_t ch = 0; ch < POT_CHANNELS_MAX; ch++)
+    recall.stored[ch] = 0xFF;
+  return scriptResponse(Script_writeConfig(CONFIG_RECALL_ADDR, &recall, sizeof(recall)));
+}
+
+/**
+ * Executs a command based on the serial input string
+ */
+void executeCommand(Application *app_p, char *input)
+{
+  // Response code and argument index, printed only when not RespOk
+  uint8_t output = RespOk;
+  Watchdog_stage(StageCommand);
+  char arg1[CMD_CHAR_LEN + 1];
+  char arg2[CMD_CHAR_LEN + 1];
+  char word[CMD_CHAR_LEN + 1];
+
+  for (char *c = input; *c != '\0'; c++)
+    *c = tolower(*c);
+
+  // Gets first char of command, and reset index
+  nextWord(input, word, 1);
+  char cmd_type = word[0];
+
+  // Executs the command based on the char, otherwise gives error message
+  switch (cmd_type)
+  {
+  case 't': // Linear ramp to throttle
+  case 'u': // Retarget, replaces the ramp in flight from the current position
+    nextWord(input, arg1, 0);
+    nextWord(input, arg2, 0);
+    if (isNumeric(arg1)) // nested ifs are ugly, change to function calls
+    {
+      int target = atoi(arg1);
+      if (target >= 0 && target < 100)
+      {
+        if (isNumeric(arg2))
+        {
+          uint64_t time = atol(arg2);
+          if (time > 0 && app_p->script_run.recording)
+            output = scriptRecord(SCRIPT_RAMP, target, 0, time);
+          else if (time > 0)
+            rampStart(app_p, target, time);
+          else
+            output = RESPONSE_ARG(RespTimeBounds, 2);
+        }
+        else if (strcmp(arg2, "NULL") == 0 && app_p->script_run.recording)
+          output = scriptRecord(SCRIPT_SET, target, 0, 0);
+        else if (strcmp(arg2, "NULL") == 0)
+        {
+          // A set replaces any ramp in flight on the channel
+          for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+          {
+            if (app_p->channel_mask & (1 << ch))
+            {
+              app_p->channels[ch].steps = 0;
+              app_p->channels[ch].target_pos = target;
+              X9C_setPosition(&pots[ch], target, false);
+            }
+          }
+        }
+      }
+      else
+        output = RESPONSE_ARG(RespThrottleBounds, 1);
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, 1);
+    break;
+
+  case 's': // Step command
+    nextWord(input, arg1, 0);
+    if (isNumeric(arg1) && app_p->script_run.recording)
+      output = scriptRecord(SCRIPT_STEP, constrain(atoi(arg1), -X9C_MAX_POS, X9C_MAX_POS), 0, 0);
+    else if (isNumeric(arg1))
+    {
+      // Check every addressed channel before moving any of them
+      bool in_bounds = true;
+      for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+      {
+        int new_pos = app_p->channels[ch].pot_pos + atoi(arg1);
+        if ((app_p->channel_mask & (1 << ch)) && (new_pos < 0 || new_pos >= 100))
+          in_bounds = false;
+      }
+
+      if (in_bounds)
+      {
+        for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+        {
+          if (app_p->channel_mask & (1 << ch))
+            X9C_setPosition(&pots[ch], app_p->channels[ch].pot_pos + atoi(arg1), false);
+        }
+      }
+      else
+        output = RESPONSE_ARG(RespThrottleBounds, 1);
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, 1);
+    break;
+
+  case 'w': // Wait command
+    nextWord(input, arg1, 0);
+    if (isNumeric(arg1))
+    {
+      long time = atol(arg1);
+      if (time > 0 && app_p->script_run.recording)
+        output = scriptRecord(SCRIPT_WAIT, 0, 0, time);
+      else if (time > 0)
+      {
+        app_p->wait_cmd_timer = SWTimer_construct(time);
+        SWTimer_start(&app_p->wait_cmd_timer);
+      }
+      else
+        output = RESPONSE_ARG(RespTimeBounds, 1);
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, 1);
+    break;
+
+  case 'c': // Channel select command, bitmask of channels for 't' and 's'
+    nextWord(input, arg1, 0);
+    if (isNumeric(arg1))
+    {
+      int mask = atoi(arg1);
+      if (mask > 0 && mask < (1 << POT_CHANNELS) && app_p->script_run.recording)
+        output = scriptRecord(SCRIPT_CHANNELS, mask, 0, 0);
+      else if (mask > 0 && mask < (1 << POT_CHANNELS))
+        app_p->channel_mask = mask;
+      else
+        output = RESPONSE_ARG(RespChannelBounds, 1);
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, 1);
+    break;
+
+  case 'm': // Memory health command, one frame or periodic frames every arg1 ms
+    nextWord(input, arg1, 0);
+    if (strcmp(arg1, "NULL") == 0)
+      serialPrintHealth();
+    else if (isNumeric(arg1))
+    {
+      long period = atol(arg1);
+      if (period >= 0)
+      {
+        app_p->health_timer = SWTimer_construct(period);
+        SWTimer_start(&app_p->health_timer);
+        app_p->health_enabled = period > 0;
+      }
+      else
+        output = RESPONSE_ARG(RespTimeBounds, 1);
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, 1);
+    break;
+
+  case 'j': // Loop period histogram command, dump or reset with 'j 0'
+    nextWord(input, arg1, 0);
+    if (strcmp(arg1, "NULL") == 0)
+      serialPrintHistogram(&loop_hist, loop_overruns);
+    else if (strcmp(arg1, "0") == 0)
+    {
+      Histogram_reset(&loop_hist);
+      loop_overruns = 0;
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, 1);
+    break;
+
+  case 'o': // Oversample command, extra ADC bits (4x samples each) and median length
+    nextWord(input, arg1, 0);
+    nextWord(input, arg2, 0);
+    if (isNumeric(arg1) && (isNumeric(arg2) || strcmp(arg2, "NULL") == 0))
+    {
+      int median_len = strcmp(arg2, "NULL") == 0 ? 1 : atoi(arg2);
+      if (Adc_configure(atoi(arg1), median_len))
+      {
+        app_p->adc_settling_timer = SWTimer_construct(ADC_SETTLE_TIME + Adc_latencyMs());
+        SWTimer_start(&app_p->adc_settling_timer);
+      }
+      else
+        output = RESPONSE_ARG(RespOversampleBounds, 1);
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, isNumeric(arg1) ? 2 : 1);
+    break;
+
+  case 'd': // Data subscribe command, frame period in ms and DATA_* field mask
+    nextWord(input, arg1, 0);
+    nextWord(input, arg2, 0);
+    if (isNumeric(arg1) && (isNumeric(arg2) || strcmp(arg2, "NULL") == 0))
+    {
+      long period = atol(arg1);
+      long mask = strcmp(arg2, "NULL") == 0 ? app_p->data_mask : atol(arg2);
+      if (period < 1 || period > S_DATA_TIMESTEP_MAX)
+        output = RESPONSE_ARG(RespTimeBounds, 1);
+      else if (mask < 1 || mask > DATA_ALL_MASK)
+        output = RESPONSE_ARG(RespFieldMaskBounds, 2);
+      else
+      {
+        app_p->data_step_timer = SWTimer_construct(period);
+        SWTimer_start(&app_p->data_step_timer);
+        app_p->data_mask = mask;
+      }
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, isNumeric(arg1) ? 2 : 1);
+    break;
+
+  case 'b': // Batch command, samples per frame and latency bound in ms
+    nextWord(input, arg1, 0);
+    nextWord(input, arg2, 0);
+    if (isNumeric(arg1) && (isNumeric(arg2) || strcmp(arg2, "NULL") == 0))
+    {
+      int len = atoi(arg1);
+      long latency = strcmp(arg2, "NULL") == 0 ? DATA_BATCH_LATENCY_MAX : atol(arg2);
+      if (len < 1 || len > DATA_BATCH_MAX)
+        output = RESPONSE_ARG(RespBatchBounds, 1);
+      else if (latency < 1 || latency > DATA_BATCH_LATENCY_MAX)
+        output = RESPONSE_ARG(RespTimeBounds, 2);
+      else
+      {
+        if (data_batch.count > 0)
+          serialPrintBatch(app_p);
+        app_p->batch_len = len;
+        app_p->batch_timer = SWTimer_construct(latency);
+      }
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, isNumeric(arg1) ? 2 : 1);
+    break;
+
+  case 'y': // Clock sync command, echoes the host's sequence number with device times
+    nextWord(input, arg1, 0);
+    if (isNumeric(arg1))
+      serialPrintSync(arg1, app_p->command_us);
+    else
+      output = RESPONSE_ARG(RespBadArgument, 1);
+    break;
+
+  case 'i': // Trigger input command, 0 off, 1 rising edge, 2 falling edge
+    nextWord(input, arg1, 0);
+    if (isNumeric(arg1))
+    {
+      int edge = atoi(arg1);
+      if (edge >= TRIGGER_OFF && edge <= TRIGGER_FALLING)
+        Trigger_begin(edge);
+      else
+        output = RESPONSE_ARG(RespEdgeBounds, 1);
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, 1);
+    break;
+
+  case 'a': // Arm command, the rest of the line runs on the next trigger edge
+  {
+    // Skip past the command word to the armed command
+    char *armed = input + strspn(input, " ");
+    armed += strcspn(armed, " \n");
+    armed += strspn(armed, " ");
+    if (*armed == ASCII_LF || *armed == '\0')
+      app_p->trigger_cmd[0] = '\0'; // bare 'a' disarms
+    else
+      strcpy(app_p->trigger_cmd, armed);
+    app_p->trigger_fired = false;
+    break;
+  }
+
+  case 'l': // Loop command, repeats the script lines up to the matching 'n' (recording only)
+    nextWord(input, arg1, 0);
+    if (!app_p->script_run.recording)
+      output = RespOnlyRecording;
+    else if (isNumeric(arg1))
+    {
+      long count = atol(arg1);
+      if (count >= 1 && count <= UINT16_MAX)
+        output = scriptLoopOpen(app_p, count);
+      else
+        output = RESPONSE_ARG(RespCountBounds, 1);
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, 1);
+    break;
+
+  case 'n': // Next command, ends the innermost loop (recording only)
+    if (app_p->script_run.recording)
+      output = scriptLoopClose(app_p);
+    else
+      output = RespOnlyRecording;
+    break;
+
+  case 'v': // Voltage wait command, mV to cross and timeout in ms (recording only)
+    nextWord(input, arg1, 0);
+    nextWord(input, arg2, 0);
+    if (!app_p->script_run.recording)
+      output = RespOnlyRecording;
+    else if (isNumeric(arg1) && (isNumeric(arg2) || strcmp(arg2, "NULL") == 0))
+    {
+      long mv = atol(arg1);
+      long timeout = strcmp(arg2, "NULL") == 0 ? 0 : atol(arg2);
+      if (mv < 0 || mv > V_POT_MAX * 1000)
+        output = RESPONSE_ARG(RespVoltageBounds, 1);
+      else if (timeout < 0)
+        output = RESPONSE_ARG(RespTimeBounds, 2);
+      else
+        output = scriptRecord(SCRIPT_WAIT_V, 0, mv, timeout);
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, isNumeric(arg1) ? 2 : 1);
+    break;
+
+  case 'k': // Marker command, prints a numbered marker, or records one in a script
+    nextWord(input, arg1, 0);
+    if (isNumeric(arg1) && atol(arg1) >= 0 && atol(arg1) <= UINT16_MAX)
+    {
+      if (app_p->script_run.recording)
+        output = scriptRecord(SCRIPT_MARK, 0, atol(arg1), 0);
+      else
+        serialPrintMarker(atol(arg1));
+    }
+    else
+      output = RESPONSE_ARG(RespBadArgument, 1);
+    break;
+
+  case 'f': // Find command, locates the wiper of the selected channels, or calibrates with 'f c'
+    nextWord(input, arg1, 0);
+    if (strcmp(arg1, "NULL") == 0)
+      syncStart(app_p, false);
+    else if (strcmp(arg1, "c") == 0)
+      syncStart(app_p, true);
+    else
+      output = RESPONSE_ARG(RespBadArgument, 1);
+    break;
+
+  case 'p': // Persist command, recalls the wipers at power up with 'p 1', reports with a bare 'p'
+    nextWord(input, arg1, 0);
+    if (strcmp(arg1, "NULL") == 0)
+      serialPrintRecall();
+    else if (strcmp(arg1, "0") == 0 || strcmp(arg1, "1") == 0)
+      output = recallSet(arg1[0] == '1');
+    else
+      output = RESPONSE_ARG(RespBadArgument, 1);
+    break;
+
+  case 'h': // Help command, explains response codes and switches terse responses on or off
+    output = executeResponseCommand(app_p, input);
+    break;
+
+  case 'e': // Script command, record, save, execute, delete, boot or list EEPROM scripts
+    output = executeScriptCommand(app_p, input);
+    break;
+
+  case 'r': // Read potentiometer command, effectively a dump
+    app_p->new_value_flag = 1;
+    break;
+
+  case 'q': // Quit command, terminate program and reset (High Priority)
+    app_p->cmd_high_priority = false;
+    resetApplication(app_p);
+    break;
+
+  default:
+    output = RespUnknownCommand;
+    break;
+  }
+
+  if (output != RespOk)
+    serialPrintResponse(app_p, output, cmd_type);
+}
+
+/**
+ * Script subcommands, each followed by a script name where it needs one:
+ *   e r <name>  record the following 't', 's', 'w' and 'c' lines
+ *   e s         save the recording to EEPROM
+ *   e x <name>  load a script into SRAM and run it
+ *   e d <name>  delete a script
+ *   e b <name>  run a script at boot, a bare 'e b' clears it
+ *   e l         list the scripts
+ */
+uint8_t executeScriptCommand(Application *app_p, const char *input)
+{
+  char sub[CMD_CHAR_LEN + 1];
+  char name[CMD_CHAR_LEN + 1];
+  ScriptResult result;
+
+  nextWord(input, sub, 0);
+  nextWord(input, name, 0);
+  bool has_name = strcmp(name, "NULL") != 0;
+  if (has_name && strlen(name) > SCRIPT_NAME_LEN)
+    return RESPONSE_ARG(RespNameTooLong, 2);
+
+  switch (sub[0])
+  {
+  case 'r':
+    if (!has_name)
+      break;
+    if (Script_busy())
+      return scriptResponse(ScriptBusy);
+    Script_clear(&script, name);
+    app_p->script_run.recording = true;
+    app_p->script_run.loop_depth = 0;
+    return RespOk;
+
+  case 's':
+    if (!app_p->script_run.recording)
+      return RespNotRecording;
+    if (app_p->script_run.loop_depth != 0)
+      return RespLoopNotClosed;
+    result = Script_save(&script);
+    if (result == ScriptOk)
+      app_p->script_run.recording = false;
+    return scriptResponse(result);
+
+  case 'x':
+    if (!has_name)
+      break;
+    app_p->script_run.recording = false;
+    result = Script_load(&script, name);
+    if (result == ScriptOk && !scriptChannelsFit(&script))
+      return RespChannelBounds;
+    if (result == ScriptOk)
+      scriptStart(app_p);
+    return scriptResponse(result);
+
+  case 'd':
+    if (!has_name)
+      break;
+    return scriptResponse(Script_delete(name));
+
+  case 'b':
+    return scriptResponse(Script_setBoot(has_name ? name : ""));
+
+  case 'l':
+    serialPrintScriptList();
+    return RespOk;
+
+  default:
+    break;
+  }
+  return RESPONSE_ARG(RespBadArgument, 1);
+}
+
+uint8_t scriptResponse(ScriptResult result)
+{
+  switch (result)
+  {
+  case ScriptBusy:
+    return RespEepromBusy;
+  case ScriptFull:
+    return RespScriptFull;
+  case ScriptNotFound:
+    return RespScriptNotFound;
+  case ScriptExists:
+    return RespScriptExists;
+  case ScriptCorrupt:
+    return RespScriptCorrupt;
+  default:
+    return RespOk;
+  }
+}
+
+/**
+ * Response subcommands:
+ *   h           explain the last response that was not RespOk
+ *   h <code>    explain a response code
+ *   h t         terse mode, responses are sent as ?<code>[,<argument>]
+ *   h v         verbose mode, responses are sent as text
+ */
+uint8_t executeResponseCommand(Application *app_p, const char *input)
+{
+  char arg1[CMD_CHAR_LEN + 1];
+
+  nextWord(input, arg1, 0);
+  if (strcmp(arg1, "NULL") == 0)
+    serialPrintResponseText(app_p->last_response, app_p->last_cmd);
+  else if (strcmp(arg1, "t") == 0 || strcmp(arg1, "v") == 0)
+    app_p->terse = arg1[0] == 't';
+  else if (isNumeric(arg1) && atoi(arg1) >= 0 && atoi(arg1) < RESP_CODES)
+    serialPrintResponseText(atoi(arg1), '\0');
+  else
+    return RESPONSE_ARG(RespBadArgument, 1);
+  return RespOk;
+}
+
+const __FlashStringHelper *responseText(uint8_t code)
+{
+  switch (code)
+  {
+  case RespOk:
+    return F("  Ok");
+  case RespUnknownCommand:
+    return F("  Unknown command type");
+  case RespBadArgument:
+    return F("  Bad argument for command");
+  case RespThrottleBounds:
+    return F("  Throttle out of bounds");
+  case RespTimeBounds:
+    return F("  Time out of bounds");
+  case RespChannelBounds:
+    return F("  Channel out of bounds");
+  case RespOversampleBounds:
+    return F("  Oversampling out of bounds");
+  case RespFieldMaskBounds:
+    return F("  Field mask out of bounds");
+  case RespBatchBounds:
+    return F("  Batch length out of bounds");
+  case RespEdgeBounds:
+    return F("  Edge out of bounds");
+  case RespCountBounds:
+    return F("  Count out of bounds");
+  case RespVoltageBounds:
+    return F("  Voltage out of bounds");
+  case RespOnlyRecording:
+    return F("  Only while recording");
+  case RespNameTooLong:
+    return F("  Name too long");
+  case RespNotRecording:
+    return F("  Not recording");
+  case RespLoopNotClosed:
+    return F("  Loop not closed");
+  case RespLoopsTooDeep:
+    return F("  Loops nested too deep");
+  case RespNoLoop:
+    return F("  No loop to close");
+  case RespEepromBusy:
+    return F("  EEPROM busy");
+  case RespScriptFull:
+    return F("  Script full");
+  case RespScriptNotFound:
+    return F("  Script not found");
+  case RespScriptExists:
+    return F("  Script exists");
+  case RespScriptCorrupt:
+    return F("  Script corrupt");
+  case RespCurveNotRising:
+    return F("  Curve not rising");
+  case RespVoltageTimeout:
+    return F("  Voltage wait timed out");
+  case RespQueueFull:
+    return F("  Command queue full");
+  default:
+    return F("  Unknown response");
+  }
+}
+
+// Compiles a step into the SRAM script, planned times over 24 bits do not fit
+uint8_t scriptRecord(uint8_t op, int8_t arg, uint16_t value, uint32_t time_ms)
+{
+  ScriptStep step;
+
+  if (time_ms > SCRIPT_TIME_MAX)
+    return RespTimeBounds;
+
+  step.op = op;
+  step.arg = arg;
+  step.value = value;
+  step.time_ms = time_ms;
+  if (!Script_append(&script, &step))
+    return scriptResponse(ScriptFull);
+  return RespOk;
+}
+
+uint8_t scriptLoopOpen(Application *app_p, uint16_t count)
+{
+  ScriptRun *run_p = &app_p->script_run;
+
+  if (run_p->loop_depth >= SCRIPT_LOOP_DEPTH)
+    return RespLoopsTooDeep;
+
+  uint8_t error = scriptRecord(SCRIPT_LOOP, run_p->loop_depth, count, 0);
+  if (error == RespOk)
+  {
+    run_p->loop_start[run_p->loop_depth] = script.len;
+    run_p->loop_depth++;
+  }
+  return error;
+}
+
+uint8_t scriptLoopClose(Application *app_p)
+{
+  ScriptRun *run_p = &app_p->script_run;
+
+  if (run_p->loop_depth == 0)
+    return RespNoLoop;
+
+  uint8_t slot = run_p->loop_depth - 1;
+  uint8_t error = scriptRecord(SCRIPT_NEXT, slot, run_p->loop_start[slot], 0);
+  if (error == RespOk)
+    run_p->loop_depth--;
+  return error;
+}
+
+/**
+ * A step is done when its ramp has finished and its hold has expired, or,
+ * for a voltage wait, when the first selected channel crosses the voltage.
+ * Voltage waits have no planned length, so the schedule restarts from the
+ * crossing. One that times out ends the script.
+ */
+bool scriptReady(Application *app_p)
+{
+  ScriptRun *run_p = &app_p->script_run;
+
+  if (rampActive(app_p))
+    return false;
+  if (!run_p->voltage_wait)
+    return SWTimer_expired(&app_p->wait_cmd_timer);
+
+  uint16_t mv = app_p->channels[run_p->voltage_channel].pot_v * 1000 + 0.5;
+  if (run_p->voltage_rising ? mv >= run_p->voltage_mv : mv <= run_p->voltage_mv)
+  {
+    run_p->voltage_wait = false;
+    run_p->start_ms = millis() - run_p->planned_ms;
+    return true;
+  }
+
+  if (run_p->voltage_timeout && SWTimer_expired(&app_p->wait_cmd_timer))
+  {
+    serialPrintResponse(app_p, RespVoltageTimeout, 'v');
+    run_p->voltage_wait = false;
+    run_p->pc = script.len;
+    return true;
+  }
+  return false;
+}
+
+// A script recorded by a build with more channels keeps the channels this one has
+bool scriptChannelsFit(const Script *script_p)
+{
+  ScriptStep step;
+  uint8_t pc = 0;
+
+  while (Script_decode(script_p, &pc, &step))
+  {
+    if (step.op == SCRIPT_CHANNELS && !(step.arg & CHANNEL_MASK_ALL))
+      return false;
+  }
+  return true;
+}
+
+void scriptStart(Application *app_p)
+{
+  memset(&app_p->script_run, 0, sizeof(app_p->script_run));
+  app_p->script_run.running = true;
+  app_p->script_run.start_ms = millis();
+  app_p->wait_cmd_timer = SWTimer_construct(0);
+}
+
+/**
+ * Starts the next step of the running script. A step is planned to start
+ * once the steps before it have taken their planned time, so its lateness is
+ * how far the run has drifted from the schedule by then. Ramps hold for
+ * their full time even when the pots are already at the target.
+ */
+bool scriptStep(Application *app_p)
+{
+  ScriptRun *run_p = &app_p->script_run;
+  ScriptStep step;
+  Watchdog_stage(StageScript);
+
+  long late_ms = (long)(millis() - run_p->start_ms - run_p->planned_ms);
+  if (!Script_decode(&script, &run_p->pc, &step))
+  {
+    run_p->end_late_ms = late_ms;
+    run_p->running = false;
+    return false;
+  }
+
+  if (run_p->steps == 0 || late_ms > run_p->worst_late_ms)
+  {
+    run_p->worst_late_ms = late_ms;
+    run_p->worst_step = run_p->steps;
+  }
+  run_p->steps++;
+  if (step.op != SCRIPT_WAIT_V) // a timeout is not part of the plan
+    run_p->planned_ms += step.time_ms;
+
+  switch (step.op)
+  {
+  case SCRIPT_RAMP:
+    rampStart(app_p, step.arg, step.time_ms);
+    // fall through
+  case SCRIPT_WAIT:
+    app_p->wait_cmd_timer = SWTimer_construct(step.time_ms);
+    SWTimer_start(&app_p->wait_cmd_timer);
+    break;
+
+  case SCRIPT_SET:
+  case SCRIPT_STEP:
+    for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+    {
+      if (!(app_p->channel_mask & (1 << ch)))
+        continue;
+      int position = step.arg;
+      if (step.op == SCRIPT_STEP)
+        position = constrain(X9C_getPosition(&pots[ch]) + step.arg, 0, X9C_MAX_POS);
+      X9C_setPosition(&pots[ch], position, false);
+    }
+    break;
+
+  case SCRIPT_CHANNELS:
+    if (step.arg & CHANNEL_MASK_ALL)
+      app_p->channel_mask = step.arg & CHANNEL_MASK_ALL;
+    break;
+
+  case SCRIPT_LOOP:
+    run_p->loop_left[step.arg % SCRIPT_LOOP_DEPTH] = step.value;
+    break;
+
+  case SCRIPT_NEXT:
+  {
+    uint16_t *left_p = &run_p->loop_left[step.arg % SCRIPT_LOOP_DEPTH];
+    if (*left_p > 1)
+    {
+      (*left_p)--;
+      run_p->pc = step.value;
+    }
+    else
+      *left_p = 0;
+    break;
+  }
+
+  case SCRIPT_WAIT_V:
+  {
+    uint8_t ch = 0;
+    while (ch < POT_CHANNELS - 1 && !(app_p->channel_mask & (1 << ch)))
+      ch++;
+    run_p->voltage_wait = true;
+    run_p->voltage_channel = ch;
+    run_p->voltage_mv = step.value;
+    run_p->voltage_rising = app_p->channels[ch].pot_v * 1000 < step.value;
+    run_p->voltage_timeout = step.time_ms != 0;
+    app_p->wait_cmd_timer = SWTimer_construct(step.time_ms);
+    SWTimer_start(&app_p->wait_cmd_timer);
+    break;
+  }
+
+  case SCRIPT_MARK:
+    serialPrintMarker(step.value);
+    break;
+  }
+  return true;
+}
+
+/**
+ * Copies the next word from the string into word, which must hold
+ * CMD_CHAR_LEN + 1 chars. The word is "NULL" if there are no more words.
+ */
+void nextWord(const char *input, char *word, bool reset)
+{
+  static unsigned int cur = 0; // cursor for string index
+  unsigned int length = strlen(input);
+
+  strcpy(word, "NULL");
+
+  if (reset)
+    cur = 0;
+
+  if (cur >= length)
+    return;
+
+  // Attempt to find a word
+  _parserStates state = Spaces; // initial state for the parser FSM
+  for (unsigned int i = cur; i < length; i++)
+  {
+    char c = input[i];
+
+    switch (state)
+    {
+    case Spaces:
+      if (c == ASCII_LF || c == ASCII_SPACE)
+        ; // stay in Spaces state
+      else
+      {
+        cur = i; // move cursor to after spaces
+        state = Reading;
+      }
+      break;
+
+    case Reading:
+      if (c == ASCII_LF || c == ASCII_SPACE)
+      {
+        unsigned int word_len = min(i - cur, (unsigned int)CMD_CHAR_LEN);
+        memcpy(word, &input[cur], word_len);
+        word[word_len] = '\0';
+        cur = i + 1;
+        return;
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+}
+
+// Pin state setup
+void InitializePins()
+{
+  pinMode(LED_PIN, OUTPUT);
+}
+
+// Blinks an LED once a second as a visual indicator of processor hang
+void WatchdogLED(Application *app_p)
+{
+  static bool state = true;
+
+  if (SWTimer_expired(&app_p->watchdog_timer))
+  {
+    digitalWrite(LED_PIN, state);
+    state = !state;
+    SWTimer_start(&app_p->watchdog_timer);
+  }
+}
+
+/**
+ * Prints a data frame field by field straight into the serial TX buffer.
+ * Only the fields in the 'd' command mask are sent, in the order
+ * voltage,position,ohms for each channel, then timestamp, free RAM and
+ * loop overruns
+ */
+void serialPrintData(Application *app_p)
+{
+  DataSample sample = dataSample(app_p);
+
+  Uart.print(S_D_CHAR);
+  serialPrintSample(&sample, app_p->data_mask, sample.timestamp);
+  Uart.println();
+}
+
+// Snapshot of everything a data frame can carry
+DataSample dataSample(Application *app_p)
+{
+  DataSample sample;
+
+  sample.timestamp = app_p->mes_timestamp;
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    sample.pot_v_100uV[ch] = app_p->channels[ch].pot_v * 10000 + 0.5;
+    sample.pot_pos[ch] = app_p->channels[ch].pot_pos;
+  }
+  sample.free_ram = Memory_freeRam();
+  sample.overruns = loop_overruns;
+
+  return sample;
+}
+
+void serialPrintSample(DataSample *sample_p, uint8_t mask, unsigned long timestamp)
+{
+  bool first = true;
+
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    if (mask & DATA_VOLTAGE)
+    {
+      serialPrintSeparator(&first);
+      Uart.print(sample_p->pot_v_100uV[ch] / 10000.0, Adc_extraBits() ? 4 : 2); // voltage at divider
+    }
+    if (mask & DATA_POSITION)
+    {
+      serialPrintSeparator(&first);
+      Uart.print(sample_p->pot_pos[ch]); // pot position
+    }
+    if (mask & DATA_OHMS)
+    {
+      serialPrintSeparator(&first);
+      Uart.print(X9C_positionToOhms(&pots[ch], sample_p->pot_pos[ch])); // pot ohms
+    }
+  }
+  if (mask & DATA_TIMESTAMP)
+  {
+    serialPrintSeparator(&first);
+    Uart.print(timestamp); // timestamp of measurement
+  }
+  if (mask & DATA_FREE_RAM)
+  {
+    serialPrintSeparator(&first);
+    Uart.print(sample_p->free_ram);
+  }
+  if (mask & DATA_OVERRUNS)
+  {
+    serialPrintSeparator(&first);
+    Uart.print(sample_p->overruns);
+  }
+}
+
+// Queue the current measurements, the first sample starts the latency bound
+void batchAdd(Application *app_p)
+{
+  if (data_batch.count == 0)
+    SWTimer_start(&app_p->batch_timer);
+
+  data_batch.samples[data_batch.count] = dataSample(app_p);
+  data_batch.count++;
+
+  if (data_batch.count >= app_p->batch_len)
+    serialPrintBatch(app_p);
+}
+
+/**
+ * Prints the batch as {base;sample;sample... where base is the timestamp of
+ * the first sample and every sample carries the data frame fields, with its
+ * time field as the ms offset from base
+ */
+void serialPrintBatch(Application *app_p)
+{
+  unsigned long base = data_batch.samples[0].timestamp;
+
+  Uart.print(S_B_CHAR);
+  Uart.print(base);
+  for (uint8_t i = 0; i < data_batch.count; i++)
+  {
+    DataSample *sample_p = &data_batch.samples[i];
+    Uart.print(';');
+    serialPrintSample(sample_p, app_p->data_mask | DATA_TIMESTAMP, sample_p->timestamp - base);
+  }
+  Uart.println();
+
+  data_batch.count = 0;
+}
+
+void serialPrintSeparator(bool *first_p)
+{
+  if (!*first_p)
+    Uart.print(',');
+  *first_p = false;
+}
+
+/**
+ * Prints a memory health frame: stack high-water mark, smallest and current
+ * free RAM between heap and stack, heap bytes claimed and heap bytes on the
+ * free list (fragmentation), then a timestamp
+ */
+void serialPrintHealth()
+{
+  MemoryStats stats = Memory_stats();
+
+  Uart.print(S_H_CHAR);
+  Uart.print(stats.stack_peak);
+  Uart.print(',');
+  Uart.print(stats.min_free);
+  Uart.print(',');
+  Uart.print(stats.free_now);
+  Uart.print(',');
+  Uart.print(stats.heap_used);
+  Uart.print(',');
+  Uart.print(stats.heap_free_list);
+  Uart.print(',');
+  Uart.println(millis());
+}
+
+/**
+ * Prints the loop period histogram, one count per log2 bin followed by the
+ * longest period in microseconds and the number of loop deadline overruns
+ */
+void serialPrintHistogram(Histogram *hist_p, uint16_t overruns)
+{
+  Uart.print(S_L_CHAR);
+  for (uint8_t i = 0; i < HISTOGRAM_BINS; i++)
+  {
+    Uart.print(hist_p->bins[i]);
+    Uart.print(',');
+  }
+  Uart.print(hist_p->max_us);
+  Uart.print(',');
+  Uart.println(overruns);
+}
+
+/**
+ * Prints ~seq,rx_us,tx_us,tx_ms for an NTP style exchange. rx_us is when the
+ * request's line end arrived, stamped in the RX interrupt. The TX buffer is
+ * drained first so tx_us is when the reply starts on the wire. tx_ms lets the
+ * host unwrap micros(), which wraps every 71 minutes.
+ */
+void serialPrintSync(const char *seq, unsigned long rx_us)
+{
+  Uart.flush();
+  unsigned long tx_us = micros();
+  unsigned long tx_ms = millis();
+
+  Uart.print(S_Y_CHAR);
+  Uart.print(seq);
+  Uart.print(',');
+  Uart.print(rx_us);
+  Uart.print(',');
+  Uart.print(tx_us);
+  Uart.print(',');
+  Uart.println(tx_ms);
+}
+
+// Prints &steps,worst_late_ms,worst_step,end_late_ms, late against the planned schedule
+void serialPrintScript(Application *app_p)
+{
+  ScriptRun *run_p = &app_p->script_run;
+
+  Uart.print(S_X_CHAR);
+  Uart.print(run_p->steps);
+  Uart.print(',');
+  Uart.print(run_p->worst_late_ms);
+  Uart.print(',');
+  Uart.print(run_p->worst_step);
+  Uart.print(',');
+  Uart.println(run_p->end_late_ms);
+}
+
+// Prints one line per script with its size in bytes, then the free EEPROM and the boot script
+void serialPrintScriptList()
+{
+  char name[SCRIPT_NAME_LEN + 1];
+  uint8_t len;
+
+  for (uint8_t i = 0; Script_entry(i, name, &len); i++)
+  {
+    Uart.print(F("  "));
+    Uart.print(name);
+    Uart.print(' ');
+    Uart.println(SCRIPT_HEADER_LEN + len);
+  }
+  Uart.print(F("  free "));
+  Uart.println(Script_free());
+  if (Script_bootName(name))
+  {
+    Uart.print(F("  boot "));
+    Uart.println(name);
+  }
+}
+
+// Prints #marker,us
+void serialPrintMarker(uint16_t marker)
+{
+  Uart.print(S_K_CHAR);
+  Uart.print(marker);
+  Uart.print(',');
+  Uart.println(micros());
+}
+
+// Prints >late_ms, the end of a 't' command with how far past its plan the ramp finished
+void serialPrintRampEnd(Application *app_p)
+{
+  Uart.print(S_E_CHAR);
+  Uart.println(app_p->ramp_late_ms);
+}
+
+// Prints where the wiper of a channel was found and where it was tracked
+void serialPrintResync(uint8_t ch, uint8_t found, uint8_t tracked, bool following)
+{
+  Uart.print(F("  Channel "));
+  Uart.print(ch);
+  if (!following)
+    Uart.println(F(" wiper not following"));
+  else
+  {
+    Uart.print(F(" wiper at "));
+    Uart.print(found);
+    Uart.print(F(", tracked "));
+    Uart.println(tracked);
+  }
+}
+
+// Prints the time to ready and the share of each boot phase, all in us
+void serialPrintBoot(bool settled)
+{
+  Uart.print(F("  Ready in "));
+  Uart.print(ready_us);
+  Uart.print(F(" us, core "));
+  Uart.print(boot_us[BootCore]);
+  Uart.print(F(", uart "));
+  Uart.print(boot_us[BootUart]);
+  Uart.print(F(", init "));
+  Uart.print(boot_us[BootInit]);
+  Uart.print(F(", pots "));
+  Uart.print(boot_us[BootPots]);
+  Uart.print(F(", settle "));
+  Uart.println(boot_us[BootSettle]);
+  if (!settled)
+    Uart.println(F("  ADC not settled"));
+}
+
+// Prints ?code or ?code,argument in terse mode, the text otherwise. Kept for 'h'
+void serialPrintResponse(Application *app_p, uint8_t response, char cmd)
+{
+  app_p->last_response = response;
+  app_p->last_cmd = cmd;
+
+  if (!app_p->terse)
+  {
+    serialPrintResponseText(response, cmd);
+    return;
+  }
+
+  Uart.print(S_Q_CHAR);
+  Uart.print(RESPONSE_CODE(response));
+  if (response >> RESPONSE_ARG_SHIFT)
+  {
+    Uart.print(',');
+    Uart.print(response >> RESPONSE_ARG_SHIFT);
+  }
+  Uart.println();
+}
+
+// A bad argument names its command, as in "  Bad argument for command 't'"
+void serialPrintResponseText(uint8_t response, char cmd)
+{
+  uint8_t code = RESPONSE_CODE(response);
+
+  Uart.print(responseText(code));
+  if (code == RespBadArgument && cmd != '\0')
+  {
+    Uart.print(F(" '"));
+    Uart.print(cmd);
+    Uart.print('\'');
+  }
+  Uart.println();
+}
+
+// Prints the recall mode, the stored position of each channel and the last time to ready
+void serialPrintRecall()
+{
+  Uart.print(recall.mode == RECALL_ON ? F("  Recall on, stored ") : F("  Recall off, stored "));
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+  {
+    if (ch > 0)
+      Uart.print(',');
+    if (recall.stored[ch] <= X9C_MAX_POS)
+      Uart.print(recall.stored[ch]);
+    else
+      Uart.print('-');
+  }
+  Uart.print(F(", ready in "));
+  Uart.print(ready_us);
+  Uart.println(F(" us"));
+}
+
+// Prints the curve in mV, one value per point, and whether it was measured
+void serialPrintCalibration()
+{
+  Uart.print(Calibration_stored() ? F("  Curve ") : F("  Ideal curve "));
+  for (uint8_t i = 0; i < CAL_POINTS; i++)
+  {
+    if (i > 0)
+      Uart.print(',');
+    Uart.print(Calibration_mv(Calibration_point(i)));
+  }
+  Uart.println();
+}
+
+// Prints *ch,found,tracked, a wiper measured away from its tracked position
+void serialPrintDesync(uint8_t ch, uint8_t found, uint8_t tracked)
+{
+  Uart.print(S_W_CHAR);
+  Uart.print(ch);
+  Uart.print(',');
+  Uart.print(found);
+  Uart.print(',');
+  Uart.println(tracked);
+}
+
+// Prints ^us,seq. A gap in seq means edges were dropped from a full queue
+void serialPrintTrigger(TriggerEvent *event_p)
+{
+  Uart.print(S_T_CHAR);
+  Uart.print(event_p->us);
+  Uart.print(',');
+  Uart.println(event_p->seq);
+}
+
+void serialPrintChar(char c)
+{
+  char message[2];
+  snprintf(message, 2, "%c", c);
+  Uart.println(message);
+}
+
+/**
+ * Checks if a string is made up of only numeric characters
+ *
+ * @param str String to check
+ *
+ * @returns true if string is numeric, false otherwise
+ */
+bool isNumeric(const char *str)
+{
+  for (unsigned int i = 0; str[i] != '\0'; i++)
+  {
+    if (!(isdigit(str[i]) || str[i] == '-'))
+      return false;
+  }
+  return true;
+}
+
+void checkPriority(Application *app_p, char* cmd)
+{
+  switch(cmd[0])
+  {
+  case 'q': // Quit command
+    app_p->cmd_high_priority = true;
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+ * Called from the RX interrupt when the stop byte arrives. Cuts every
+ * channel to zero with full travel pulses, which takes a few hundred us,
+ * and leaves the pots halted until the main loop resets the application.
+ * A stop that finds a store cycle running blocks movement at once and
+ * leaves the pulses to the main loop, once the chips take INC again.
+ *
+ * Latency is measured from entry to the wiper reaching zero. Entry itself can
+ * be held off by the longest interrupts-off section, a single INC pulse or a
+ * Timer0 tick, both a few us.
+ */
+void emergencyStop()
+{
+  unsigned long start_us = micros();
+  bool pending = X9C_haltPending();
+
+  X9C_halt(pots, POT_CHANNELS);
+
+  if (X9C_haltPending())
+  {
+    if (!pending)
+      estop_start_us = start_us;
+  }
+  else
+    estopLatency(start_us);
+  estop_flag = true;
+}
+
+// Records the time from a stop's entry to the wipers reaching zero
+void estopLatency(unsigned long start_us)
+{
+  uint16_t latency_us = micros() - start_us;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    estop_us = latency_us;
+    if (latency_us > estop_worst_us)
+      estop_worst_us = latency_us;
+  }
+}
+
+// Prints the stop latency in us, as !<last>,<worst>
+void serialPrintStop()
+{
+  uint16_t last_us, worst_us;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    last_us = estop_us;
+    worst_us = estop_worst_us;
+  }
+
+  Uart.print(S_HP_CHAR);
+  Uart.print(last_us);
+  Uart.print(',');
+  Uart.println(worst_us);
+}
+
+void resetApplication(Application *app_p)
+{
+  command_queue.count = 0;
+  for (uint8_t ch = 0; ch < POT_CHANNELS; ch++)
+    X9C_setPosition(&pots[ch], 0, false);
+
+  // The response mode belongs to the host, not to the run being reset
+  bool terse = app_p->terse;
   *app_p = Application_construct();
+  app_p->terse = terse;
+  recall_flush = true;
 }
 
 
@@ -515,8 +2243,8 @@ void potSweep(Application *app_p)
   // For now, cycles between 0% and 99% throttle
   if (SWTimer_expired(&app_p->pot_test_timer))
   {
-    pot.incr();
-    Serial.println(pot.getOhm());
+    X9C_setPosition(&pots[0], X9C_getPosition(&pots[0]) + 1, false);
+    Uart.println(X9C_getOhms(&pots[0]));
     SWTimer_start(&app_p->pot_test_timer);
     count++;
   }
@@ -524,6 +2252,6 @@ void potSweep(Application *app_p)
   if (count == 99)
   {
     count = 1;
-    pot.setPosition(0, true);
+    X9C_setPosition(&pots[0], 0, true);
   }
 }
\ No newline at end of file
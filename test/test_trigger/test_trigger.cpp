@@ -0,0 +1,171 @@
+/*
+ * test_trigger.cpp
+ *
+ *  Created on: 10/16/2026
+ *      Author: Colton Tshudy
+ *
+ *  Checks of the trigger driver against the simulated Timer1, run with
+ *  pio test -e native. Pulses on the simulated D8 go through the same capture
+ *  interrupt as on the board, so the timestamps, sequence numbers and queue
+ *  are the real driver's.
+ */
+
+#include <HAL/Trigger.h>
+#include <HAL/sim/Sim.h>
+#include <unity.h>
+
+#define TRIGGER_TICKS_PER_US 2 // Timer1 runs at 16 MHz / 8
+
+extern "C" void TIMER1_CAPT_vect(void);
+
+// Sequence number of the last edge read
+static uint16_t last_seq = 0;
+
+static bool readEvent(TriggerEvent *event_p)
+{
+    if (!Trigger_read(event_p))
+        return false;
+    last_seq = event_p->seq;
+    return true;
+}
+
+void setUp()
+{
+    TriggerEvent event;
+    while (readEvent(&event))
+        ;
+}
+
+void tearDown()
+{
+    Trigger_begin(TRIGGER_OFF);
+}
+
+static void test_configures_capture()
+{
+    // The noise canceler is the only debounce, it holds a capture until
+    // 4 equal samples of the pin
+    Trigger_begin(TRIGGER_RISING);
+    TEST_ASSERT_TRUE(TCCR1B & _BV(ICNC1));
+    TEST_ASSERT_TRUE(TCCR1B & _BV(ICES1));
+    TEST_ASSERT_TRUE(TIMSK1 & _BV(ICIE1));
+
+    Trigger_begin(TRIGGER_FALLING);
+    TEST_ASSERT_TRUE(TCCR1B & _BV(ICNC1));
+    TEST_ASSERT_FALSE(TCCR1B & _BV(ICES1));
+
+    Trigger_begin(TRIGGER_OFF);
+    TEST_ASSERT_FALSE(TIMSK1 & _BV(ICIE1));
+}
+
+static void test_pulse_timestamp()
+{
+    Trigger_begin(TRIGGER_RISING);
+    uint16_t seq = last_seq;
+    unsigned long before_us = micros();
+    Sim_pulse(TRIGGER_PIN);
+    unsigned long after_us = micros();
+
+    TriggerEvent event;
+    TEST_ASSERT_TRUE(readEvent(&event));
+    TEST_ASSERT_EQUAL_UINT16(seq + 1, event.seq);
+    TEST_ASSERT_TRUE(event.us - before_us <= after_us - before_us);
+    TEST_ASSERT_FALSE(readEvent(&event));
+}
+
+static void test_capture_latency()
+{
+    // The interrupt runs 500 us after the edge, the timestamp is the edge's
+    Trigger_begin(TRIGGER_RISING);
+    unsigned long before_us = micros();
+    ICR1 = 1000;
+    TCNT1 = 1000 + 500 * TRIGGER_TICKS_PER_US;
+    TIMER1_CAPT_vect();
+    unsigned long after_us = micros();
+    TCNT1 = 0;
+
+    TriggerEvent event;
+    TEST_ASSERT_TRUE(readEvent(&event));
+    TEST_ASSERT_TRUE(event.us + 500 - before_us <= after_us - before_us);
+
+    // Across a wrap of TCNT1 as well
+    before_us = micros();
+    ICR1 = 0xFFFF - 99;
+    TCNT1 = 100;
+    TIMER1_CAPT_vect();
+    after_us = micros();
+    TCNT1 = 0;
+
+    TEST_ASSERT_TRUE(readEvent(&event));
+    TEST_ASSERT_TRUE(event.us + 100 - before_us <= after_us - before_us);
+}
+
+static void test_pulses_in_order()
+{
+    Trigger_begin(TRIGGER_FALLING);
+    uint16_t seq = last_seq;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        Sim_pulse(TRIGGER_PIN);
+        delayMicroseconds(200);
+    }
+
+    TriggerEvent first, event;
+    TEST_ASSERT_TRUE(readEvent(&first));
+    TEST_ASSERT_EQUAL_UINT16(seq + 1, first.seq);
+    for (uint8_t i = 1; i < 3; i++)
+    {
+        TEST_ASSERT_TRUE(readEvent(&event));
+        TEST_ASSERT_EQUAL_UINT16(first.seq + i, event.seq);
+        TEST_ASSERT_TRUE(event.us - first.us >= 200UL * i);
+    }
+    TEST_ASSERT_FALSE(readEvent(&event));
+}
+
+static void test_full_queue_drops()
+{
+    // The ring keeps one slot free, edges past that are counted and dropped
+    Trigger_begin(TRIGGER_RISING);
+    uint16_t seq = last_seq;
+    for (uint8_t i = 0; i < TRIGGER_QUEUE_SIZE + 2; i++)
+        Sim_pulse(TRIGGER_PIN);
+
+    TriggerEvent event;
+    for (uint8_t i = 1; i < TRIGGER_QUEUE_SIZE; i++)
+    {
+        TEST_ASSERT_TRUE(readEvent(&event));
+        TEST_ASSERT_EQUAL_UINT16(seq + i, event.seq);
+    }
+    TEST_ASSERT_FALSE(readEvent(&event));
+
+    // The next edge shows the gap
+    Sim_pulse(TRIGGER_PIN);
+    TEST_ASSERT_TRUE(readEvent(&event));
+    TEST_ASSERT_EQUAL_UINT16(seq + TRIGGER_QUEUE_SIZE + 3, event.seq);
+}
+
+static void test_off_ignores_pulses()
+{
+    Trigger_begin(TRIGGER_OFF);
+    Sim_pulse(TRIGGER_PIN);
+
+    TriggerEvent event;
+    TEST_ASSERT_FALSE(readEvent(&event));
+
+    // Other pins never capture
+    Trigger_begin(TRIGGER_RISING);
+    Sim_pulse(TRIGGER_PIN + 1);
+    TEST_ASSERT_FALSE(readEvent(&event));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_configures_capture);
+    RUN_TEST(test_pulse_timestamp);
+    RUN_TEST(test_capture_latency);
+    RUN_TEST(test_pulses_in_order);
+    RUN_TEST(test_full_queue_drops);
+    RUN_TEST(test_off_ignores_pulses);
+    return UNITY_END();
+}